@@ -0,0 +1,362 @@
+/*! @file bme280.c
+ * @brief Microbenchmark for BME280 compensation, in the mode it was built with (BME280_COMP)
+ *
+ * @details Compensates raw samples with the datasheet example calibration and prints the time per
+ * sample, including the conversion to °C, hPa and %RH done by bme_read(), and the largest
+ * deviation from the datasheet's double-precision formulas. In the fixed-point modes, every output
+ * is also checked for bit-exactness against the datasheet's integer formulas. The same samples are
+ * then compensated in batches (bme_batch_compensate()), whose time per sample and results are
+ * compared with single-frame compensation.
+ *
+ * Raw samples are read from a file, one per line, as the 8 data registers (0xF7 to 0xFE) in hex,
+ * e.g. `51 A3 C0 7E ED 00 6D 60`. Without a file, samples sweep the operating range (about -40 to
+ * 85 °C, 300 to 1100 hPa and 0 to 100 %RH).
+ *
+ * Usage: bme280_<mode> [raw samples]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../bme280/common/batch.h"
+#include "../bme280/common/common.h"
+
+#define MAX_SAMPLES 65536
+#define GENERATED_SAMPLES 4096
+#define MIN_SAMPLES 5000000
+
+#if defined(BME280_32BIT_ENABLE)
+#define BME280_COMP "int32"
+#elif defined(BME280_64BIT_ENABLE)
+#define BME280_COMP "int64"
+#else
+#define BME280_COMP "float"
+#endif
+
+/// Datasheet example calibration (dig_T1 through dig_H6), as laid out in the register file
+static const uint8_t calib_00[26] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,  // T1 = 27504, T2 = 26435, T3 = -1000
+    0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,  // P1 = 36477, P2 = -10685, P3 = 3024
+    0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF,  // P4 = 2855, P5 = 140, P6 = -7
+    0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17,  // P7 = 15500, P8 = -14600, P9 = 6000
+    0x00, 0x4B,                          // H1 = 75
+};
+static const uint8_t calib_26[7] = {
+    0x6A, 0x01, 0x00,  // H2 = 362, H3 = 0
+    0x13, 0x29, 0x03,  // H4 = 313, H5 = 50
+    0x1E,              // H6 = 30
+};
+
+static uint8_t regs[256];
+static struct bme280_uncomp_data samples[MAX_SAMPLES];
+static struct bme_batch batch;
+
+// Keeps results alive, so the compensation is not optimized away
+static volatile double sink;
+
+static double now_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static BME280_INTF_RET_TYPE reg_read(uint8_t reg_addr, uint8_t* data, uint32_t len, void* intf) {
+  memcpy(data, &regs[reg_addr], len);
+  return 0;
+}
+
+static BME280_INTF_RET_TYPE reg_write(uint8_t reg_addr,
+                                      const uint8_t* data,
+                                      uint32_t len,
+                                      void* intf) {
+  return 0;
+}
+
+static void no_delay(uint32_t period, void* intf) {}
+
+/**
+ * @brief Loads raw samples
+ * @param[in] path Sample file, or NULL to generate samples
+ * @returns Amount of samples, or 0 if the file could not be read
+ */
+static uint32_t load_samples(const char* path) {
+  uint8_t reg_data[BME280_P_T_H_DATA_LEN];
+  unsigned int b[BME280_P_T_H_DATA_LEN];
+  char line[128];
+  uint32_t count = 0;
+  FILE* f;
+
+  if (!path) {
+    srand(1);
+    for (count = 0; count < GENERATED_SAMPLES; count++) {
+      samples[count].temperature = 330000 + rand() % 400000;
+      samples[count].pressure = 250000 + rand() % 550000;
+      samples[count].humidity = 15000 + rand() % 30000;
+    }
+    return count;
+  }
+
+  f = fopen(path, "r");
+  if (!f)
+    return 0;
+
+  while (count < MAX_SAMPLES && fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "%x %x %x %x %x %x %x %x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5], &b[6],
+               &b[7]) != BME280_P_T_H_DATA_LEN)
+      continue;
+
+    for (uint8_t i = 0; i < BME280_P_T_H_DATA_LEN; i++)
+      reg_data[i] = b[i];
+    bme280_parse_sensor_data(reg_data, &samples[count++]);
+  }
+
+  fclose(f);
+  return count;
+}
+
+/**
+ * @brief Datasheet double-precision compensation (section 8.1), with the API's output limits
+ */
+static void reference_double(const struct bme280_uncomp_data* raw,
+                             const struct bme280_calib_data* c,
+                             struct bme_data* out) {
+  double var1, var2, p, t_fine;
+
+  var1 = (raw->temperature / 16384.0 - c->dig_t1 / 1024.0) * c->dig_t2;
+  var2 = (raw->temperature / 131072.0 - c->dig_t1 / 8192.0);
+  var2 = var2 * var2 * c->dig_t3;
+  t_fine = (int32_t)(var1 + var2);
+  out->temperature = fmin(fmax((var1 + var2) / 5120.0, -40), 85);
+
+  var1 = t_fine / 2.0 - 64000.0;
+  var2 = var1 * var1 * c->dig_p6 / 32768.0;
+  var2 = var2 + var1 * c->dig_p5 * 2.0;
+  var2 = var2 / 4.0 + c->dig_p4 * 65536.0;
+  var1 = (c->dig_p3 * var1 * var1 / 524288.0 + c->dig_p2 * var1) / 524288.0;
+  var1 = (1.0 + var1 / 32768.0) * c->dig_p1;
+  p = 1048576.0 - raw->pressure;
+  p = (p - var2 / 4096.0) * 6250.0 / var1;
+  var1 = c->dig_p9 * p * p / 2147483648.0;
+  var2 = p * c->dig_p8 / 32768.0;
+  p = p + (var1 + var2 + c->dig_p7) / 16.0;
+  out->pressure = fmin(fmax(p, 30000), 110000) / 100;
+
+  var1 = t_fine - 76800.0;
+  var2 = raw->humidity - (c->dig_h4 * 64.0 + c->dig_h5 / 16384.0 * var1);
+  var2 = var2 * (c->dig_h2 / 65536.0 *
+                 (1.0 + c->dig_h6 / 67108864.0 * var1 * (1.0 + c->dig_h3 / 67108864.0 * var1)));
+  var2 = var2 * (1.0 - c->dig_h1 * var2 / 524288.0);
+  out->humidity = fmin(fmax(var2, 0), 100);
+}
+
+#ifndef BME280_FLOAT_ENABLE
+
+/**
+ * @brief Datasheet fixed-point compensation (section 4.2.3), in the API's units and output limits
+ */
+static void reference_fixed(const struct bme280_uncomp_data* raw,
+                            const struct bme280_calib_data* c,
+                            struct bme280_data* out) {
+  int32_t adc_t = raw->temperature, adc_p = raw->pressure, adc_h = raw->humidity;
+  int32_t var1, var2, t_fine, t, h;
+  uint32_t p;
+
+  var1 = ((((adc_t >> 3) - ((int32_t)c->dig_t1 << 1))) * ((int32_t)c->dig_t2)) >> 11;
+  var2 = (((((adc_t >> 4) - ((int32_t)c->dig_t1)) * ((adc_t >> 4) - ((int32_t)c->dig_t1))) >> 12) *
+          ((int32_t)c->dig_t3)) >>
+         14;
+  t_fine = var1 + var2;
+  t = (t_fine * 5 + 128) >> 8;
+  out->temperature = t < -4000 ? -4000 : t > 8500 ? 8500 : t;
+
+#ifdef BME280_32BIT_ENABLE
+  var1 = (t_fine >> 1) - (int32_t)64000;
+  var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t)c->dig_p6);
+  var2 = var2 + ((var1 * ((int32_t)c->dig_p5)) << 1);
+  var2 = (var2 >> 2) + (((int32_t)c->dig_p4) << 16);
+  var1 = (((c->dig_p3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) +
+          ((((int32_t)c->dig_p2) * var1) >> 1)) >>
+         18;
+  var1 = ((32768 + var1) * ((int32_t)c->dig_p1)) >> 15;
+  if (var1 == 0) {
+    p = 30000;
+  } else {
+    p = (((uint32_t)(((int32_t)1048576) - adc_p) - (var2 >> 12))) * 3125;
+    if (p < 0x80000000)
+      p = (p << 1) / ((uint32_t)var1);
+    else
+      p = (p / (uint32_t)var1) * 2;
+    var1 = (((int32_t)c->dig_p9) * ((int32_t)(((p >> 3) * (p >> 3)) >> 13))) >> 12;
+    var2 = (((int32_t)(p >> 2)) * ((int32_t)c->dig_p8)) >> 13;
+    p = (uint32_t)((int32_t)p + ((var1 + var2 + c->dig_p7) >> 4));
+    p = p < 30000 ? 30000 : p > 110000 ? 110000 : p;
+  }
+#else
+  int64_t v1, v2, q;
+
+  v1 = ((int64_t)t_fine) - 128000;
+  v2 = v1 * v1 * (int64_t)c->dig_p6;
+  v2 = v2 + ((v1 * (int64_t)c->dig_p5) << 17);
+  v2 = v2 + (((int64_t)c->dig_p4) << 35);
+  v1 = ((v1 * v1 * (int64_t)c->dig_p3) >> 8) + ((v1 * (int64_t)c->dig_p2) << 12);
+  v1 = (((((int64_t)1) << 47) + v1)) * ((int64_t)c->dig_p1) >> 33;
+  if (v1 == 0) {
+    p = 3000000;
+  } else {
+    q = 1048576 - adc_p;
+    q = (((q << 31) - v2) * 3125) / v1;
+    v1 = (((int64_t)c->dig_p9) * (q >> 13) * (q >> 13)) >> 25;
+    v2 = (((int64_t)c->dig_p8) * q) >> 19;
+    q = ((q + v1 + v2) >> 8) + (((int64_t)c->dig_p7) << 4);
+    // Q24.8 Pa to 1/100 Pa, as the API does
+    p = (uint32_t)(((q / 2) * 100) / 128);
+    p = p < 3000000 ? 3000000 : p > 11000000 ? 11000000 : p;
+  }
+#endif
+  out->pressure = p;
+
+  h = t_fine - ((int32_t)76800);
+  h = (((((adc_h << 14) - (((int32_t)c->dig_h4) << 20) - (((int32_t)c->dig_h5) * h)) +
+         ((int32_t)16384)) >>
+        15) *
+       (((((((h * ((int32_t)c->dig_h6)) >> 10) *
+            (((h * ((int32_t)c->dig_h3)) >> 11) + ((int32_t)32768))) >>
+           10) +
+          ((int32_t)2097152)) *
+             ((int32_t)c->dig_h2) +
+         8192) >>
+        14));
+  h = (h - (((((h >> 15) * (h >> 15)) >> 7) * ((int32_t)c->dig_h1)) >> 4));
+  h = (h < 0 ? 0 : h);
+  h = (h > 419430400 ? 419430400 : h);
+  out->humidity = (uint32_t)(h >> 12);
+}
+
+#endif
+
+/**
+ * @brief Compensates samples in batches, alternating between two calibrations, and compares the
+ * results with bme280_compensate_data()
+ * @returns Mismatching samples
+ */
+static uint32_t check_batch(struct bme280_calib_data* calib, uint32_t count) {
+  struct bme280_data data;
+  uint32_t mismatches = 0;
+
+  for (uint32_t first = 0; first < count; first += batch.count) {
+    bme_batch_reset(&batch);
+    for (uint32_t i = first; i < count && bme_batch_add(&batch, &calib[i % 2], &samples[i]) >= 0;
+         i++)
+      continue;
+    bme_batch_compensate(&batch);
+
+    for (uint16_t k = 0; k < batch.count; k++) {
+      bme280_compensate_data(BME280_ALL, &samples[first + k], &data, &calib[(first + k) % 2]);
+      mismatches += batch.temperature[k] != data.temperature * BME_TEMPERATURE_SCALE ||
+                    batch.pressure[k] != data.pressure * BME_PRESSURE_SCALE ||
+                    batch.humidity[k] != data.humidity * BME_HUMIDITY_SCALE;
+    }
+  }
+
+  return mismatches;
+}
+
+/**
+ * @brief Times batch compensation, frames included
+ * @returns Time per sample, in ns
+ */
+static double time_batch(const struct bme280_calib_data* calib, uint32_t count, uint32_t rounds) {
+  double start = now_ns();
+
+  for (uint32_t r = 0; r < rounds; r++) {
+    for (uint32_t first = 0; first < count; first += batch.count) {
+      bme_batch_reset(&batch);
+      for (uint32_t i = first; i < count && bme_batch_add(&batch, calib, &samples[i]) >= 0; i++)
+        continue;
+      bme_batch_compensate(&batch);
+      sink = batch.temperature[0] + batch.pressure[0] + batch.humidity[0];
+    }
+  }
+
+  return (now_ns() - start) / rounds / count;
+}
+
+int main(int argc, char* argv[]) {
+  struct bme280_dev dev = {.read = reg_read, .write = reg_write, .delay_us = no_delay};
+  struct bme280_data data;
+  struct bme280_calib_data calib[2];
+  struct bme_data out, ref;
+  double start, ns, batch_ns, dev_t = 0, dev_p = 0, dev_h = 0;
+  uint32_t count, rounds, mismatches = 0, batch_mismatches;
+
+  count = load_samples(argc > 1 ? argv[1] : NULL);
+  if (!count) {
+    fprintf(stderr, "bme280_%s: no samples in %s\n", BME280_COMP, argv[1]);
+    return -1;
+  }
+
+  memcpy(&regs[0x88], calib_00, sizeof(calib_00));
+  memcpy(&regs[0xE1], calib_26, sizeof(calib_26));
+  regs[BME280_CHIP_ID_ADDR] = BME280_CHIP_ID;
+  dev.intf = BME280_I2C_INTF;
+
+  if (bme280_init(&dev) != BME280_OK) {
+    fprintf(stderr, "bme280_%s: calibration could not be parsed\n", BME280_COMP);
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    bme280_compensate_data(BME280_ALL, &samples[i], &data, &dev.calib_data);
+    reference_double(&samples[i], &dev.calib_data, &ref);
+
+    dev_t = fmax(dev_t, fabs(data.temperature * BME_TEMPERATURE_SCALE - ref.temperature));
+    dev_p = fmax(dev_p, fabs(data.pressure * BME_PRESSURE_SCALE - ref.pressure));
+    dev_h = fmax(dev_h, fabs(data.humidity * BME_HUMIDITY_SCALE - ref.humidity));
+
+#ifndef BME280_FLOAT_ENABLE
+    struct bme280_data fixed;
+
+    reference_fixed(&samples[i], &dev.calib_data, &fixed);
+    mismatches += data.temperature != fixed.temperature || data.pressure != fixed.pressure ||
+                  data.humidity != fixed.humidity;
+#endif
+  }
+
+  rounds = (MIN_SAMPLES + count - 1) / count;
+  start = now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    for (uint32_t i = 0; i < count; i++) {
+      bme280_compensate_data(BME280_ALL, &samples[i], &data, &dev.calib_data);
+      out.temperature = data.temperature * BME_TEMPERATURE_SCALE;
+      out.pressure = data.pressure * BME_PRESSURE_SCALE;
+      out.humidity = data.humidity * BME_HUMIDITY_SCALE;
+      sink = out.temperature + out.pressure + out.humidity;
+    }
+  }
+  ns = (now_ns() - start) / rounds / count;
+  batch_ns = time_batch(&dev.calib_data, count, rounds);
+
+  // A second, made-up calibration checks that every frame is compensated with its own
+  calib[0] = calib[1] = dev.calib_data;
+  calib[1].dig_t2 += 100;
+  calib[1].dig_p1 -= 50;
+  calib[1].dig_p8 += 200;
+  calib[1].dig_h2 += 10;
+  batch_mismatches = check_batch(calib, count);
+
+  printf("bme280_%s: %u %s samples, %.1f ns/sample\n", BME280_COMP, count,
+         argc > 1 ? "recorded" : "generated", ns);
+  printf("  max deviation from double precision  %.4f °C  %.4f hPa  %.4f %%RH\n", dev_t, dev_p,
+         dev_h);
+#ifndef BME280_FLOAT_ENABLE
+  printf("  %u mismatches against the datasheet's fixed-point formulas\n", mismatches);
+#endif
+  printf("  batches of %u  %.1f ns/sample  speedup %.2fx  %u mismatches against single frames\n",
+         BME_BATCH_MAX, batch_ns, ns / batch_ns, batch_mismatches);
+
+  return mismatches || batch_mismatches ? -1 : 0;
+}
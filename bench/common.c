@@ -0,0 +1,160 @@
+/*! @file common.c
+ * @brief Sweep benchmarking: timing, statistics and report
+ */
+
+#include "common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../sim/common.h"
+
+static const char* bench_name;
+static const char* stage_names[BENCH_MAX_STAGES];
+static uint8_t stage_count;
+
+// Per-sweep samples, in microseconds
+static double sweep_us[BENCH_MAX_SWEEPS];
+static double stage_us[BENCH_MAX_STAGES][BENCH_MAX_SWEEPS];
+static unsigned int sweeps, target;
+
+static struct timespec sweep_start, last_mark;
+static struct sim_stats stats_start, stats_total;
+
+// Heap allocations, counted by wrapping malloc/calloc/realloc at link time (BENCH_LDFLAGS). Only
+// calls made from the daemon's objects are wrapped, not those made inside shared libraries.
+static unsigned long allocations, allocations_start, allocations_total;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+  return __real_realloc(ptr, size);
+}
+
+static double elapsed_us(const struct timespec* from, const struct timespec* to) {
+  return (to->tv_sec - from->tv_sec) * 1e6 + (to->tv_nsec - from->tv_nsec) / 1e3;
+}
+
+static int compare_double(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nearest-rank percentile (sorts the samples in place)
+ * @param[in, out] samples Samples
+ * @param[in] count Amount of samples
+ * @param[in] p Percentile (0-100)
+ * @returns Percentile value
+ */
+static double percentile(double* samples, unsigned int count, double p) {
+  unsigned int rank = (p / 100) * count;
+
+  qsort(samples, count, sizeof(double), compare_double);
+  return samples[rank < count ? rank : count - 1];
+}
+
+static void report() {
+  double total = 0, stage_total, p50, p99;
+
+  for (unsigned int i = 0; i < sweeps; i++)
+    total += sweep_us[i];
+
+  p50 = percentile(sweep_us, sweeps, 50);
+  p99 = percentile(sweep_us, sweeps, 99);
+
+  printf("%s: %u sweeps\n", bench_name, sweeps);
+  printf("  %-14s p50 %10.1f us  p99 %10.1f us  mean %10.1f us\n", "sweep", p50, p99,
+         total / sweeps);
+
+  for (uint8_t s = 0; s < stage_count; s++) {
+    stage_total = 0;
+    for (unsigned int i = 0; i < sweeps; i++)
+      stage_total += stage_us[s][i];
+
+    p50 = percentile(stage_us[s], sweeps, 50);
+    p99 = percentile(stage_us[s], sweeps, 99);
+
+    printf("  %-14s p50 %10.1f us  p99 %10.1f us  mean %10.1f us  %5.1f%%\n", stage_names[s], p50,
+           p99, stage_total / sweeps, 100 * stage_total / total);
+  }
+
+  printf("  %-14s %.1f syscalls, %.1f I2C bytes, %.1f SPI bytes, %.1f allocations\n",
+         "per sweep", (double)stats_total.syscalls / sweeps, (double)stats_total.i2c_bytes / sweeps,
+         (double)stats_total.spi_bytes / sweeps, (double)allocations_total / sweeps);
+  fflush(stdout);
+}
+
+void bench_sweep_begin(const char* name) {
+  const char* env;
+
+  if (!target) {
+    env = getenv("SIMAR_BENCH_SWEEPS");
+    target = env ? atoi(env) : BENCH_DEFAULT_SWEEPS;
+    if (target < 1 || target > BENCH_MAX_SWEEPS)
+      target = BENCH_DEFAULT_SWEEPS;
+  }
+
+  bench_name = name;
+  sim_get_stats(&stats_start);
+  allocations_start = __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+  clock_gettime(CLOCK_MONOTONIC, &sweep_start);
+  last_mark = sweep_start;
+
+  for (uint8_t s = 0; s < stage_count; s++)
+    stage_us[s][sweeps] = 0;
+}
+
+void bench_stage(const char* stage) {
+  struct timespec now;
+  uint8_t s;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  for (s = 0; s < stage_count && strcmp(stage_names[s], stage); s++)
+    ;
+
+  if (s == stage_count) {
+    if (stage_count == BENCH_MAX_STAGES)
+      return;
+    stage_names[stage_count++] = stage;
+    memset(stage_us[s], 0, sizeof(stage_us[s]));
+  }
+
+  stage_us[s][sweeps] += elapsed_us(&last_mark, &now);
+  last_mark = now;
+}
+
+void bench_sweep_end() {
+  struct timespec now;
+  struct sim_stats stats;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  sim_get_stats(&stats);
+
+  sweep_us[sweeps++] = elapsed_us(&sweep_start, &now);
+  stats_total.syscalls += stats.syscalls - stats_start.syscalls;
+  stats_total.i2c_bytes += stats.i2c_bytes - stats_start.i2c_bytes;
+  stats_total.spi_bytes += stats.spi_bytes - stats_start.spi_bytes;
+  allocations_total += __atomic_load_n(&allocations, __ATOMIC_RELAXED) - allocations_start;
+
+  if (sweeps == target) {
+    report();
+    exit(0);
+  }
+}
@@ -0,0 +1,68 @@
+/*! @file common.h
+ * @brief Common declarations for sweep benchmarking
+ */
+
+/*!
+ * @defgroup bench Benchmarking
+ * @brief Sweep latency instrumentation for the daemons
+ *
+ * @details Daemons mark the start and end of each acquisition sweep, and the stages in between,
+ * with the BENCH_* macros declared here. They compile to nothing unless built with
+ * `-DSIMAR_BENCH` (`make bench`), in which case every sweep is timed and, after
+ * `SIMAR_BENCH_SWEEPS` sweeps (200 by default), the daemon prints p50/p99 sweep latency, a
+ * per-stage breakdown, the hardware accesses and the heap allocations per sweep, then exits.
+ * Benchmark builds always run against the simulation backend (see sim/common.h).
+ */
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdint.h>
+
+#define BENCH_MAX_SWEEPS 10000
+#define BENCH_MAX_STAGES 8
+#define BENCH_DEFAULT_SWEEPS 200
+
+#ifdef SIMAR_BENCH
+
+/**
+ * \ingroup bench
+ * @brief Starts timing a sweep
+ * @param[in] name Daemon name, used in the report
+ */
+void bench_sweep_begin(const char* name);
+
+/**
+ * \ingroup bench
+ * @brief Attributes the time elapsed since the last mark (or the start of the sweep) to a stage
+ * @param[in] stage Stage name (string literal)
+ */
+void bench_stage(const char* stage);
+
+/**
+ * \ingroup bench
+ * @brief Finishes timing a sweep; prints the report and exits after the last one
+ */
+void bench_sweep_end();
+
+#define BENCH_SWEEP_BEGIN(name) bench_sweep_begin(name)
+#define BENCH_STAGE(stage) bench_stage(stage)
+#define BENCH_SWEEP_END() bench_sweep_end()
+/// Statements wrapped in BENCH_SKIP (such as idle waits between sweeps) are left out of benchmarks
+#define BENCH_SKIP(statement) \
+  do {                        \
+    if (0) {                  \
+      statement;              \
+    }                         \
+  } while (0)
+
+#else
+
+#define BENCH_SWEEP_BEGIN(name)
+#define BENCH_STAGE(stage)
+#define BENCH_SWEEP_END()
+#define BENCH_SKIP(statement) statement
+
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+/*! @file crc.c
+ * @brief Microbenchmark for the Sensirion CRC-8, comparing the table-driven and bitwise paths
+ *
+ * @details Validates responses of 2 words (an SHT3x measurement) and of the largest buffer the
+ * drivers read, and prints the time per word for the one-pass table-driven unpacking and for the
+ * previous per-word bitwise check, and the speedup. Both CRCs are first checked against each other
+ * over every 2-byte word.
+ *
+ * Usage: crc
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../sht3x/common/crc8.h"
+
+#define MAX_WORDS 32
+#define MIN_WORDS 20000000
+
+// Keeps results alive, so the checks are not optimized away
+static volatile uint8_t sink;
+
+static double now_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Per-word check and copy, as the drivers did before sensirion_crc8_unpack_words()
+ */
+static int8_t unpack_scalar(const uint8_t* buf, uint8_t* data, uint16_t num_words) {
+  for (uint16_t i = 0; i < num_words; i++, buf += 3) {
+    if (sensirion_crc8_scalar(buf, 2) != buf[2])
+      return -1;
+
+    data[2 * i] = buf[0];
+    data[2 * i + 1] = buf[1];
+  }
+  return 0;
+}
+
+static void run(const uint8_t* buf, uint16_t num_words) {
+  uint8_t data[2 * MAX_WORDS];
+  uint32_t rounds = MIN_WORDS / num_words;
+  double start, table_ns, scalar_ns;
+
+  start = now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    sink = sensirion_crc8_unpack_words(buf, data, num_words);
+    sink = data[r % (2 * num_words)];
+  }
+  table_ns = (now_ns() - start) / rounds / num_words;
+
+  start = now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    sink = unpack_scalar(buf, data, num_words);
+    sink = data[r % (2 * num_words)];
+  }
+  scalar_ns = (now_ns() - start) / rounds / num_words;
+
+  printf("  %2u words  table %6.3f ns/word  bitwise %6.3f ns/word  speedup %5.2fx\n", num_words,
+         table_ns, scalar_ns, scalar_ns / table_ns);
+}
+
+int main() {
+  uint8_t buf[3 * MAX_WORDS], data[2 * MAX_WORDS];
+  uint32_t mismatches = 0;
+
+  for (uint32_t w = 0; w < 65536; w++) {
+    buf[0] = w >> 8;
+    buf[1] = w;
+    mismatches += sensirion_crc8(buf, 2) != sensirion_crc8_scalar(buf, 2);
+  }
+
+  srand(1);
+  for (uint16_t i = 0; i < MAX_WORDS; i++) {
+    buf[3 * i] = rand();
+    buf[3 * i + 1] = rand();
+    buf[3 * i + 2] = sensirion_crc8_scalar(&buf[3 * i], 2);
+  }
+
+  // A corrupted word must fail the whole buffer
+  mismatches += sensirion_crc8_unpack_words(buf, data, MAX_WORDS) != 0;
+  buf[3 * (MAX_WORDS - 1) + 1] ^= 0x04;
+  mismatches += sensirion_crc8_unpack_words(buf, data, MAX_WORDS) != -1;
+  buf[3 * (MAX_WORDS - 1) + 1] ^= 0x04;
+
+  printf("crc: CRC-8 0x%02X, %u mismatches against the bitwise reference\n", CRC8_POLYNOMIAL,
+         mismatches);
+
+  run(buf, 2);
+  run(buf, MAX_WORDS);
+
+  return mismatches ? -1 : 0;
+}
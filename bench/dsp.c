@@ -0,0 +1,139 @@
+/*! @file dsp.c
+ * @brief Microbenchmark for the DSP kernels, comparing the vectorized and scalar paths
+ *
+ * @details Runs every kernel over blocks of simulated current/voltage samples and prints the time
+ * per sample for both implementations, the speedup and the largest relative difference between
+ * their results.
+ *
+ * Usage: dsp [block size]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../dsp/common.h"
+
+#define DEFAULT_BLOCK 4096
+#define MAX_BLOCK 65536
+#define MIN_SAMPLES 50000000
+
+static uint16_t codes[MAX_BLOCK];
+static float current[MAX_BLOCK], voltage[MAX_BLOCK];
+
+// Keeps results alive, so the kernels are not optimized away
+static volatile double sink;
+
+static double now_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double rel_diff(double a, double b) {
+  double scale = fmax(fabs(a), fabs(b));
+  return scale > 0 ? fabs(a - b) / scale : 0;
+}
+
+static void report(const char* kernel, double vec_ns, double scalar_ns, double diff) {
+  printf("  %-8s vector %7.3f ns/sample  scalar %7.3f ns/sample  speedup %5.2fx  diff %.1e\n",
+         kernel, vec_ns, scalar_ns, scalar_ns / vec_ns, diff);
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t n = argc > 1 ? atoi(argv[1]) : DEFAULT_BLOCK;
+  uint32_t rounds;
+  struct dsp_stats stats_vec, stats_scalar;
+  struct dsp_power power_vec, power_scalar;
+  float out_vec[MAX_BLOCK], out_scalar[MAX_BLOCK];
+  double start, vec_ns, scalar_ns, diff;
+
+  if (n < 1 || n > MAX_BLOCK)
+    n = DEFAULT_BLOCK;
+  rounds = MIN_SAMPLES / n + 1;
+
+  // 60 Hz current (with third harmonic) around the transducer offset, sampled at 1.4 kHz
+  for (uint32_t k = 0; k < n; k++) {
+    double phase = 2 * M_PI * 60 * k / 1400.0;
+
+    codes[k] = (2.5 + 0.66 * 2 * (sin(phase) + 0.1 * sin(3 * phase))) / 5 * 4095;
+    voltage[k] = 180 * sin(phase);
+  }
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+  printf("dsp: %u-sample blocks, NEON (%d lanes)\n", n, DSP_LANES);
+#elif defined(__SSE2__)
+  printf("dsp: %u-sample blocks, SSE2 (%d lanes)\n", n, DSP_LANES);
+#else
+  printf("dsp: %u-sample blocks, generic vectors (%d lanes)\n", n, DSP_LANES);
+#endif
+
+  start = now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    dsp_convert(codes, n, 5.0f / 4096 / 0.66f, -2.5f / 0.66f, out_vec);
+    sink = out_vec[r % n];
+  }
+  vec_ns = (now_ns() - start) / rounds / n;
+
+  start = now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    dsp_convert_scalar(codes, n, 5.0f / 4096 / 0.66f, -2.5f / 0.66f, out_scalar);
+    sink = out_scalar[r % n];
+  }
+  scalar_ns = (now_ns() - start) / rounds / n;
+
+  diff = 0;
+  for (uint32_t k = 0; k < n; k++)
+    diff = fmax(diff, rel_diff(out_vec[k], out_scalar[k]));
+  report("convert", vec_ns, scalar_ns, diff);
+
+  for (uint32_t k = 0; k < n; k++)
+    current[k] = out_vec[k];
+
+  start = now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    dsp_stats_init(&stats_vec);
+    dsp_stats_update(&stats_vec, current, n);
+    sink = stats_vec.sum_sq;
+  }
+  vec_ns = (now_ns() - start) / rounds / n;
+
+  start = now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    dsp_stats_init(&stats_scalar);
+    dsp_stats_update_scalar(&stats_scalar, current, n);
+    sink = stats_scalar.sum_sq;
+  }
+  scalar_ns = (now_ns() - start) / rounds / n;
+
+  diff = fmax(rel_diff(dsp_ac_rms(&stats_vec), dsp_ac_rms(&stats_scalar)),
+              rel_diff(dsp_peak(&stats_vec), dsp_peak(&stats_scalar)));
+  report("stats", vec_ns, scalar_ns, diff);
+
+  start = now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    power_vec = (struct dsp_power){0};
+    dsp_power_update(&power_vec, voltage, current, n);
+    sink = power_vec.sum_vi;
+  }
+  vec_ns = (now_ns() - start) / rounds / n;
+
+  start = now_ns();
+  for (uint32_t r = 0; r < rounds; r++) {
+    power_scalar = (struct dsp_power){0};
+    dsp_power_update_scalar(&power_scalar, voltage, current, n);
+    sink = power_scalar.sum_vi;
+  }
+  scalar_ns = (now_ns() - start) / rounds / n;
+
+  diff = fmax(rel_diff(dsp_active_power(&power_vec), dsp_active_power(&power_scalar)),
+              rel_diff(dsp_apparent_power(&power_vec), dsp_apparent_power(&power_scalar)));
+  report("power", vec_ns, scalar_ns, diff);
+
+  printf("  AC RMS %.4f A, peak %.4f A, active %.2f W, apparent %.2f VA\n", dsp_ac_rms(&stats_vec),
+         dsp_peak(&stats_vec), dsp_active_power(&power_vec), dsp_apparent_power(&power_vec));
+
+  return 0;
+}
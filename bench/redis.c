@@ -0,0 +1,580 @@
+/*! @file redis.c
+ * @brief Minimal Redis stand-in for benchmarks
+ *
+ * @details Single-threaded RESP server, holding strings, hashes, lists and streams in memory. It
+ * only implements the commands the daemons use (PING, SET, GET, DEL, EXISTS, HSET, HGET, HMGET,
+ * HGETALL, RPUSH, XADD, XLEN, XREVRANGE, SUBSCRIBE, PUBLISH and CONFIG GET/SET of
+ * `notify-keyspace-events`, with keyspace notifications for HSET), and is only meant to stand in
+ * for a local Redis server while benchmarking.
+ *
+ * With more than one instance, every instance after the first is a separate process listening on
+ * the next port, holding the keys a `volt` node publishes, so that the aggregator has nodes to
+ * scrape. Instances exit along with the first one.
+ *
+ * Usage: redis [port] [instances]
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_CLIENTS 64
+#define MAX_KEYS 1024
+#define MAX_ARGS 64
+#define BUF_LEN 65536
+#define MAX_CHANNELS 8
+#define KEYSPACE_PREFIX "__keyspace@0__:"
+
+enum value_type { TYPE_NONE, TYPE_STRING, TYPE_HASH, TYPE_LIST, TYPE_STREAM };
+
+/*!
+ * @brief Stored key; hashes keep fields and values interleaved in `items`, streams keep their
+ * entries already serialized as replies (oldest first) and their last ID in `str`
+ */
+struct entry {
+  char* key;
+  enum value_type type;
+  char* str;
+  char** items;
+  unsigned int count;
+};
+
+struct client {
+  int fd;
+  char in[BUF_LEN];
+  size_t in_len;
+  char* out;
+  size_t out_len, out_cap;
+  char* channels[MAX_CHANNELS];  ///< Subscribed channels
+  unsigned int channel_count;
+};
+
+static struct entry db[MAX_KEYS];
+static struct client clients[MAX_CLIENTS];
+static char notify_flags[16];
+
+static unsigned int hash(const char* s) {
+  unsigned int h = 2166136261u;
+
+  while (*s)
+    h = (h ^ (unsigned char)*s++) * 16777619u;
+  return h;
+}
+
+/**
+ * @brief Finds a key (open addressing)
+ * @param[in] key Key
+ * @param[in] create Whether to create the key if it does not exist
+ * @returns Entry, or NULL if it does not exist (or the store is full)
+ */
+static struct entry* lookup(const char* key, int create) {
+  unsigned int h = hash(key);
+
+  for (unsigned int i = 0; i < MAX_KEYS; i++) {
+    struct entry* e = &db[(h + i) % MAX_KEYS];
+
+    if (e->key == NULL) {
+      if (!create)
+        return NULL;
+      e->key = strdup(key);
+      return e;
+    }
+    if (strcmp(e->key, key) == 0)
+      return e;
+  }
+
+  return NULL;
+}
+
+static void clear(struct entry* e) {
+  free(e->str);
+  for (unsigned int i = 0; i < e->count; i++)
+    free(e->items[i]);
+  free(e->items);
+  e->str = NULL;
+  e->items = NULL;
+  e->count = 0;
+  e->type = TYPE_NONE;
+}
+
+static void append(struct client* c, const char* data, size_t len) {
+  if (c->out_len + len > c->out_cap) {
+    c->out_cap = (c->out_len + len) * 2;
+    c->out = realloc(c->out, c->out_cap);
+  }
+  memcpy(c->out + c->out_len, data, len);
+  c->out_len += len;
+}
+
+static void reply_fmt(struct client* c, const char* fmt, long value) {
+  char buf[32];
+  append(c, buf, snprintf(buf, sizeof(buf), fmt, value));
+}
+
+static void reply_bulk(struct client* c, const char* s) {
+  if (s == NULL) {
+    append(c, "$-1\r\n", 5);
+    return;
+  }
+  reply_fmt(c, "$%ld\r\n", strlen(s));
+  append(c, s, strlen(s));
+  append(c, "\r\n", 2);
+}
+
+/**
+ * @brief Sends a message to every client subscribed to a channel
+ * @returns Amount of receivers
+ */
+static long publish(const char* channel, const char* message) {
+  long receivers = 0;
+
+  for (int i = 0; i < MAX_CLIENTS; i++) {
+    struct client* c = &clients[i];
+
+    for (unsigned int k = 0; c->fd >= 0 && k < c->channel_count; k++) {
+      if (strcmp(c->channels[k], channel) == 0) {
+        append(c, "*3\r\n$7\r\nmessage\r\n", 17);
+        reply_bulk(c, channel);
+        reply_bulk(c, message);
+        receivers++;
+      }
+    }
+  }
+
+  return receivers;
+}
+
+/**
+ * @brief Publishes a keyspace notification for a hash command, if enabled
+ */
+static void notify_hash(const char* key, const char* event) {
+  char channel[BUF_LEN];
+
+  if (!strchr(notify_flags, 'K') || !(strchr(notify_flags, 'h') || strchr(notify_flags, 'A')))
+    return;
+
+  snprintf(channel, sizeof(channel), KEYSPACE_PREFIX "%s", key);
+  publish(channel, event);
+}
+
+static char** hash_field(struct entry* e, const char* field) {
+  for (unsigned int i = 0; i + 1 < e->count; i += 2) {
+    if (strcmp(e->items[i], field) == 0)
+      return &e->items[i + 1];
+  }
+  return NULL;
+}
+
+/**
+ * @brief Gets a key, checking its type
+ * @returns 0 if the key is missing or of the expected type, -1 (after replying) otherwise
+ */
+static int typed(struct client* c, struct entry* e, enum value_type type) {
+  if (e == NULL || e->type == TYPE_NONE || e->type == type)
+    return 0;
+  append(c, "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n", 68);
+  return -1;
+}
+
+/**
+ * @brief Serializes a stream entry the way XRANGE replies carry it
+ * @param[in] id Entry ID
+ * @param[in] fields Field names and values, interleaved
+ * @param[in] n Amount of field names and values
+ * @returns Serialized entry
+ */
+static char* stream_entry(const char* id, char** fields, int n) {
+  size_t len = 64 + strlen(id), pos;
+  char* out;
+
+  for (int i = 0; i < n; i++)
+    len += strlen(fields[i]) + 24;
+
+  out = malloc(len);
+  pos = snprintf(out, len, "*2\r\n$%zu\r\n%s\r\n*%d\r\n", strlen(id), id, n);
+  for (int i = 0; i < n; i++)
+    pos += snprintf(out + pos, len - pos, "$%zu\r\n%s\r\n", strlen(fields[i]), fields[i]);
+
+  return out;
+}
+
+/**
+ * @brief Executes XADD (only with `*` IDs, and an optional MAXLEN [~|=] trim)
+ */
+static void xadd(struct client* c, char** argv, int argc) {
+  struct entry* e;
+  struct timespec ts;
+  long maxlen = 0, ms;
+  char id[48];
+  int i = 2;
+
+  if (i < argc && !strcasecmp(argv[i], "MAXLEN")) {
+    i++;
+    if (i < argc && (!strcmp(argv[i], "~") || !strcmp(argv[i], "=")))
+      i++;
+    maxlen = i < argc ? atol(argv[i++]) : 0;
+  }
+
+  if (i >= argc || strcmp(argv[i], "*") || (argc - i - 1) < 2 || (argc - i - 1) % 2) {
+    append(c, "-ERR syntax error\r\n", 19);
+    return;
+  }
+
+  e = lookup(argv[1], 1);
+  if (typed(c, e, TYPE_STREAM))
+    return;
+  e->type = TYPE_STREAM;
+
+  // IDs are milliseconds since the epoch, with a sequence number within the same millisecond
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ms = ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+  if (e->str && atol(e->str) >= ms)
+    snprintf(id, sizeof(id), "%ld-%ld", atol(e->str), atol(strchr(e->str, '-') + 1) + 1);
+  else
+    snprintf(id, sizeof(id), "%ld-0", ms);
+
+  free(e->str);
+  e->str = strdup(id);
+  e->items = realloc(e->items, (e->count + 1) * sizeof(char*));
+  e->items[e->count++] = stream_entry(id, argv + i + 1, argc - i - 1);
+
+  if (maxlen > 0 && e->count > (unsigned long)maxlen) {
+    unsigned int excess = e->count - maxlen;
+
+    for (unsigned int k = 0; k < excess; k++)
+      free(e->items[k]);
+    memmove(e->items, e->items + excess, maxlen * sizeof(char*));
+    e->count = maxlen;
+  }
+
+  reply_bulk(c, id);
+}
+
+static void execute(struct client* c, char** argv, int argc) {
+  struct entry* e = argc > 1 ? lookup(argv[1], 0) : NULL;
+  const char* cmd = argv[0];
+  long n = 0;
+
+  if (!strcasecmp(cmd, "PING")) {
+    append(c, "+PONG\r\n", 7);
+  } else if (argc < 2) {
+    append(c, "-ERR wrong number of arguments\r\n", 32);
+  } else if (!strcasecmp(cmd, "SET") && argc >= 3) {
+    e = lookup(argv[1], 1);
+    clear(e);
+    e->type = TYPE_STRING;
+    e->str = strdup(argv[2]);
+    append(c, "+OK\r\n", 5);
+  } else if (!strcasecmp(cmd, "GET")) {
+    if (!typed(c, e, TYPE_STRING))
+      reply_bulk(c, e ? e->str : NULL);
+  } else if (!strcasecmp(cmd, "DEL") || !strcasecmp(cmd, "EXISTS")) {
+    for (int i = 1; i < argc; i++) {
+      e = lookup(argv[i], 0);
+      if (e && e->type != TYPE_NONE) {
+        n++;
+        if (!strcasecmp(cmd, "DEL"))
+          clear(e);
+      }
+    }
+    reply_fmt(c, ":%ld\r\n", n);
+  } else if (!strcasecmp(cmd, "HSET") && argc >= 4 && argc % 2 == 0) {
+    e = lookup(argv[1], 1);
+    if (typed(c, e, TYPE_HASH))
+      return;
+    e->type = TYPE_HASH;
+    for (int i = 2; i < argc; i += 2) {
+      char** value = hash_field(e, argv[i]);
+
+      if (value) {
+        free(*value);
+        *value = strdup(argv[i + 1]);
+        continue;
+      }
+      e->items = realloc(e->items, (e->count + 2) * sizeof(char*));
+      e->items[e->count++] = strdup(argv[i]);
+      e->items[e->count++] = strdup(argv[i + 1]);
+      n++;
+    }
+    reply_fmt(c, ":%ld\r\n", n);
+    notify_hash(argv[1], "hset");
+  } else if (!strcasecmp(cmd, "HGET") && argc == 3) {
+    if (!typed(c, e, TYPE_HASH)) {
+      char** value = e ? hash_field(e, argv[2]) : NULL;
+      reply_bulk(c, value ? *value : NULL);
+    }
+  } else if (!strcasecmp(cmd, "HMGET") && argc >= 3) {
+    if (typed(c, e, TYPE_HASH))
+      return;
+    reply_fmt(c, "*%ld\r\n", argc - 2);
+    for (int i = 2; i < argc; i++) {
+      char** value = e ? hash_field(e, argv[i]) : NULL;
+      reply_bulk(c, value ? *value : NULL);
+    }
+  } else if (!strcasecmp(cmd, "HGETALL")) {
+    if (typed(c, e, TYPE_HASH))
+      return;
+    reply_fmt(c, "*%ld\r\n", e ? e->count : 0);
+    for (unsigned int i = 0; e && i < e->count; i++)
+      reply_bulk(c, e->items[i]);
+  } else if (!strcasecmp(cmd, "XADD") && argc >= 5) {
+    xadd(c, argv, argc);
+  } else if (!strcasecmp(cmd, "XLEN")) {
+    if (!typed(c, e, TYPE_STREAM))
+      reply_fmt(c, ":%ld\r\n", e ? e->count : 0);
+  } else if (!strcasecmp(cmd, "XREVRANGE") && argc >= 4) {
+    // Only the whole range (+ -) is supported, newest entries first
+    n = argc == 6 && !strcasecmp(argv[4], "COUNT") ? atol(argv[5]) : -1;
+    if (typed(c, e, TYPE_STREAM))
+      return;
+    if (e == NULL || n < 0 || n > (long)e->count)
+      n = e ? e->count : 0;
+    reply_fmt(c, "*%ld\r\n", n);
+    for (long i = 0; i < n; i++)
+      append(c, e->items[e->count - 1 - i], strlen(e->items[e->count - 1 - i]));
+  } else if (!strcasecmp(cmd, "RPUSH") && argc >= 3) {
+    e = lookup(argv[1], 1);
+    if (typed(c, e, TYPE_LIST))
+      return;
+    e->type = TYPE_LIST;
+    e->items = realloc(e->items, (e->count + argc - 2) * sizeof(char*));
+    for (int i = 2; i < argc; i++)
+      e->items[e->count++] = strdup(argv[i]);
+    reply_fmt(c, ":%ld\r\n", e->count);
+  } else if (!strcasecmp(cmd, "SUBSCRIBE")) {
+    for (int i = 1; i < argc && c->channel_count < MAX_CHANNELS; i++) {
+      c->channels[c->channel_count++] = strdup(argv[i]);
+      append(c, "*3\r\n$9\r\nsubscribe\r\n", 19);
+      reply_bulk(c, argv[i]);
+      reply_fmt(c, ":%ld\r\n", c->channel_count);
+    }
+  } else if (!strcasecmp(cmd, "PUBLISH") && argc == 3) {
+    reply_fmt(c, ":%ld\r\n", publish(argv[1], argv[2]));
+  } else if (!strcasecmp(cmd, "CONFIG") && argc >= 3 &&
+             !strcasecmp(argv[2], "notify-keyspace-events")) {
+    if (!strcasecmp(argv[1], "GET")) {
+      append(c, "*2\r\n", 4);
+      reply_bulk(c, argv[2]);
+      reply_bulk(c, notify_flags);
+    } else if (!strcasecmp(argv[1], "SET") && argc == 4) {
+      snprintf(notify_flags, sizeof(notify_flags), "%s", argv[3]);
+      append(c, "+OK\r\n", 5);
+    } else {
+      append(c, "-ERR syntax error\r\n", 19);
+    }
+  } else {
+    append(c, "-ERR unknown command\r\n", 22);
+  }
+}
+
+/**
+ * @brief Parses and executes every complete command in a client's input buffer
+ * @retval 0 OK
+ * @retval -1 Protocol error (the client should be dropped)
+ */
+static int process(struct client* c) {
+  char* argv[MAX_ARGS];
+  size_t pos = 0;
+
+  while (pos < c->in_len) {
+    char *p = c->in + pos, *end = c->in + c->in_len, *nl;
+    long argc, len;
+    int complete = 1;
+
+    if (*p != '*')
+      return -1;
+    if ((nl = memchr(p, '\n', end - p)) == NULL)
+      break;
+    argc = strtol(p + 1, NULL, 10);
+    if (argc < 1 || argc > MAX_ARGS)
+      return -1;
+    p = nl + 1;
+
+    for (long i = 0; i < argc; i++) {
+      if (p >= end || (nl = memchr(p, '\n', end - p)) == NULL) {
+        complete = 0;
+        break;
+      }
+      if (*p != '$')
+        return -1;
+      len = strtol(p + 1, NULL, 10);
+      if (len < 0 || len > BUF_LEN)
+        return -1;
+      p = nl + 1;
+      if (end - p < len + 2) {
+        complete = 0;
+        break;
+      }
+      argv[i] = p;
+      p[len] = '\0';
+      p += len + 2;
+    }
+
+    if (!complete)
+      break;
+
+    execute(c, argv, argc);
+    pos = p - c->in;
+  }
+
+  memmove(c->in, c->in + pos, c->in_len - pos);
+  c->in_len -= pos;
+
+  return c->in_len == BUF_LEN ? -1 : 0;
+}
+
+static void drop(struct client* c) {
+  close(c->fd);
+  free(c->out);
+  for (unsigned int k = 0; k < c->channel_count; k++)
+    free(c->channels[k]);
+  memset(c, 0, sizeof(*c));
+  c->fd = -1;
+}
+
+static int flush_out(struct client* c) {
+  ssize_t n;
+
+  while (c->out_len) {
+    n = write(c->fd, c->out, c->out_len);
+    if (n < 0)
+      return errno == EAGAIN ? 0 : -1;
+    memmove(c->out, c->out + n, c->out_len - n);
+    c->out_len -= n;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Runs a command on the store, as if a client had sent it (replies are discarded)
+ * @param[in] format Command, with space-separated arguments
+ */
+static void seed(const char* format, ...) {
+  struct client c = {.fd = -1};
+  char command[256], *args[MAX_ARGS], *save;
+  int count = 0;
+  va_list ap;
+
+  va_start(ap, format);
+  vsnprintf(command, sizeof(command), format, ap);
+  va_end(ap);
+
+  for (char* arg = strtok_r(command, " ", &save); arg && count < MAX_ARGS;
+       arg = strtok_r(NULL, " ", &save))
+    args[count++] = arg;
+
+  execute(&c, args, count);
+  free(c.out);
+}
+
+/**
+ * @brief Fills the store with the keys a `volt` node publishes
+ * @param[in] node Node index, varying the values
+ */
+static void seed_node(int node) {
+  seed("SET volt %.3f", 126 + (node % 10) * 0.1);
+  seed("SET frequency %.3f", 59.98 + (node % 5) * 0.01);
+  seed("SET pfactor 0.970");
+  seed("SET glitch 0");
+  seed("HSET ich 0 %.3f 1 %.3f 2 %.3f 3 %.3f 4 %.3f 5 %.3f 6 %.3f", 2.8, 2.4, 2.0, 1.6, 1.2,
+       0.8 + node % 3 * 0.1, 0.4);
+  seed("HSET ich_pf 0 0.957 1 0.957 2 0.956 3 0.957 4 0.958 5 0.960 6 1.000");
+}
+
+int main(int argc, char* argv[]) {
+  struct sockaddr_in addr = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+  struct pollfd fds[MAX_CLIENTS + 1];
+  int one = 1, listener, port = argc > 1 ? atoi(argv[1]) : 6379;
+  int instances = argc > 2 ? atoi(argv[2]) : 1;
+
+  signal(SIGPIPE, SIG_IGN);
+
+  for (int node = 1; node < instances; node++) {
+    if (fork() == 0) {
+      prctl(PR_SET_PDEATHSIG, SIGTERM);
+      port += node;
+      seed_node(node);
+      break;
+    }
+  }
+
+  addr.sin_port = htons(port);
+
+  listener = socket(AF_INET, SOCK_STREAM, 0);
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) || listen(listener, 16)) {
+    perror("redis stand-in");
+    return 1;
+  }
+
+  for (int i = 0; i < MAX_CLIENTS; i++)
+    clients[i].fd = -1;
+
+  for (;;) {
+    fds[0] = (struct pollfd){.fd = listener, .events = POLLIN};
+    for (int i = 0; i < MAX_CLIENTS; i++)
+      fds[i + 1] = (struct pollfd){.fd = clients[i].fd,
+                                   .events = POLLIN | (clients[i].out_len ? POLLOUT : 0)};
+
+    if (poll(fds, MAX_CLIENTS + 1, -1) < 0)
+      continue;
+
+    if (fds[0].revents & POLLIN) {
+      int fd = accept(listener, NULL, NULL);
+
+      for (int i = 0; fd >= 0 && i <= MAX_CLIENTS; i++) {
+        if (i == MAX_CLIENTS) {
+          close(fd);
+        } else if (clients[i].fd < 0) {
+          fcntl(fd, F_SETFL, O_NONBLOCK);
+          setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+          clients[i].fd = fd;
+          break;
+        }
+      }
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+      struct client* c = &clients[i];
+      ssize_t n;
+
+      if (c->fd < 0 || !fds[i + 1].revents)
+        continue;
+
+      if (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+        n = read(c->fd, c->in + c->in_len, BUF_LEN - c->in_len);
+        if (n < 0 && errno == EAGAIN)
+          continue;
+
+        if (n <= 0) {
+          drop(c);
+          continue;
+        }
+
+        c->in_len += n;
+        if (process(c)) {
+          drop(c);
+          continue;
+        }
+      }
+
+      if (flush_out(c))
+        drop(c);
+    }
+  }
+}
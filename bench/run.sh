@@ -0,0 +1,30 @@
+#!/bin/sh
+# Runs every daemon's sweep benchmark against simulated hardware and a local Redis stand-in
+# Usage: run.sh [benchmark binaries folder]
+
+BIN=${1:-bin/bench}
+# Node instances scraped by the aggregator, on the ports after 6379
+NODES=${SIMAR_BENCH_NODES:-64}
+NODE_LIST=$(mktemp)
+
+$BIN/dsp || echo "dsp: benchmark failed"
+$BIN/crc || echo "crc: benchmark failed"
+for mode in float int32 int64; do
+  $BIN/bme280_$mode || echo "bme280_$mode: benchmark failed"
+done
+
+$BIN/redis 6379 $((NODES + 1)) &
+REDIS_PID=$!
+trap 'kill $REDIS_PID; rm -f $NODE_LIST' EXIT
+
+sleep 1
+
+for daemon in bme volt fan; do
+  $BIN/$daemon || echo "$daemon: benchmark failed"
+done
+
+for i in $(seq 1 $NODES); do
+  echo "127.0.0.1:$((6379 + i))" >> $NODE_LIST
+done
+
+$BIN/aggregator $NODE_LIST || echo "aggregator: benchmark failed"
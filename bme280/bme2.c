@@ -1167,6 +1167,12 @@ static double compensate_humidity(const struct bme280_uncomp_data* uncomp_data,
 
 #else
 
+/*
+ * The fixed-point compensation follows the datasheet's formulas bit for bit: right shifts of
+ * negative intermediates round toward minus infinity (arithmetic shifts, as on GCC and Clang),
+ * whereas divisions round toward zero and would drift from the reference by an LSB.
+ */
+
 /*!
  * @brief This internal API is used to compensate the raw temperature data and
  * return the compensated temperature data in integer data type.
@@ -1179,12 +1185,12 @@ static int32_t compensate_temperature(const struct bme280_uncomp_data* uncomp_da
   int32_t temperature_min = -4000;
   int32_t temperature_max = 8500;
 
-  var1 = (int32_t)((uncomp_data->temperature / 8) - ((int32_t)calib_data->dig_t1 * 2));
-  var1 = (var1 * ((int32_t)calib_data->dig_t2)) / 2048;
-  var2 = (int32_t)((uncomp_data->temperature / 16) - ((int32_t)calib_data->dig_t1));
-  var2 = (((var2 * var2) / 4096) * ((int32_t)calib_data->dig_t3)) / 16384;
+  var1 = (int32_t)((uncomp_data->temperature >> 3) - ((int32_t)calib_data->dig_t1 << 1));
+  var1 = (var1 * ((int32_t)calib_data->dig_t2)) >> 11;
+  var2 = (int32_t)((uncomp_data->temperature >> 4) - ((int32_t)calib_data->dig_t1));
+  var2 = (((var2 * var2) >> 12) * ((int32_t)calib_data->dig_t3)) >> 14;
   calib_data->t_fine = var1 + var2;
-  temperature = (calib_data->t_fine * 5 + 128) / 256;
+  temperature = (calib_data->t_fine * 5 + 128) >> 8;
 
   if (temperature < temperature_min) {
     temperature = temperature_min;
@@ -1215,18 +1221,18 @@ static uint32_t compensate_pressure(const struct bme280_uncomp_data* uncomp_data
   var2 = var1 * var1 * (int64_t)calib_data->dig_p6;
   var2 = var2 + ((var1 * (int64_t)calib_data->dig_p5) * 131072);
   var2 = var2 + (((int64_t)calib_data->dig_p4) * 34359738368);
-  var1 = ((var1 * var1 * (int64_t)calib_data->dig_p3) / 256) +
+  var1 = ((var1 * var1 * (int64_t)calib_data->dig_p3) >> 8) +
          ((var1 * ((int64_t)calib_data->dig_p2) * 4096));
   var3 = ((int64_t)1) * 140737488355328;
-  var1 = (var3 + var1) * ((int64_t)calib_data->dig_p1) / 8589934592;
+  var1 = ((var3 + var1) * ((int64_t)calib_data->dig_p1)) >> 33;
 
   /* To avoid divide by zero exception */
   if (var1 != 0) {
     var4 = 1048576 - uncomp_data->pressure;
     var4 = (((var4 * INT64_C(2147483648)) - var2) * 3125) / var1;
-    var1 = (((int64_t)calib_data->dig_p9) * (var4 / 8192) * (var4 / 8192)) / 33554432;
-    var2 = (((int64_t)calib_data->dig_p8) * var4) / 524288;
-    var4 = ((var4 + var1 + var2) / 256) + (((int64_t)calib_data->dig_p7) * 16);
+    var1 = (((int64_t)calib_data->dig_p9) * (var4 >> 13) * (var4 >> 13)) >> 25;
+    var2 = (((int64_t)calib_data->dig_p8) * var4) >> 19;
+    var4 = ((var4 + var1 + var2) >> 8) + (((int64_t)calib_data->dig_p7) * 16);
     pressure = (uint32_t)(((var4 / 2) * 100) / 128);
 
     if (pressure < pressure_min) {
@@ -1257,19 +1263,19 @@ static uint32_t compensate_pressure(const struct bme280_uncomp_data* uncomp_data
   uint32_t pressure_min = 30000;
   uint32_t pressure_max = 110000;
 
-  var1 = (((int32_t)calib_data->t_fine) / 2) - (int32_t)64000;
-  var2 = (((var1 / 4) * (var1 / 4)) / 2048) * ((int32_t)calib_data->dig_p6);
+  var1 = (((int32_t)calib_data->t_fine) >> 1) - (int32_t)64000;
+  var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t)calib_data->dig_p6);
   var2 = var2 + ((var1 * ((int32_t)calib_data->dig_p5)) * 2);
-  var2 = (var2 / 4) + (((int32_t)calib_data->dig_p4) * 65536);
-  var3 = (calib_data->dig_p3 * (((var1 / 4) * (var1 / 4)) / 8192)) / 8;
-  var4 = (((int32_t)calib_data->dig_p2) * var1) / 2;
-  var1 = (var3 + var4) / 262144;
-  var1 = (((32768 + var1)) * ((int32_t)calib_data->dig_p1)) / 32768;
+  var2 = (var2 >> 2) + (((int32_t)calib_data->dig_p4) * 65536);
+  var3 = (calib_data->dig_p3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3;
+  var4 = (((int32_t)calib_data->dig_p2) * var1) >> 1;
+  var1 = (var3 + var4) >> 18;
+  var1 = (((32768 + var1)) * ((int32_t)calib_data->dig_p1)) >> 15;
 
   /* avoid exception caused by division by zero */
   if (var1) {
     var5 = (uint32_t)((uint32_t)1048576) - uncomp_data->pressure;
-    pressure = ((uint32_t)(var5 - (uint32_t)(var2 / 4096))) * 3125;
+    pressure = ((uint32_t)(var5 - (uint32_t)(var2 >> 12))) * 3125;
 
     if (pressure < 0x80000000) {
       pressure = (pressure << 1) / ((uint32_t)var1);
@@ -1277,10 +1283,11 @@ static uint32_t compensate_pressure(const struct bme280_uncomp_data* uncomp_data
       pressure = (pressure / (uint32_t)var1) * 2;
     }
 
-    var1 = (((int32_t)calib_data->dig_p9) * ((int32_t)(((pressure / 8) * (pressure / 8)) / 8192))) /
-           4096;
-    var2 = (((int32_t)(pressure / 4)) * ((int32_t)calib_data->dig_p8)) / 8192;
-    pressure = (uint32_t)((int32_t)pressure + ((var1 + var2 + calib_data->dig_p7) / 16));
+    var1 =
+        (((int32_t)calib_data->dig_p9) * ((int32_t)(((pressure / 8) * (pressure / 8)) / 8192))) >>
+        12;
+    var2 = (((int32_t)(pressure / 4)) * ((int32_t)calib_data->dig_p8)) >> 13;
+    pressure = (uint32_t)((int32_t)pressure + ((var1 + var2 + calib_data->dig_p7) >> 4));
 
     if (pressure < pressure_min) {
       pressure = pressure_min;
@@ -1313,14 +1320,14 @@ static uint32_t compensate_humidity(const struct bme280_uncomp_data* uncomp_data
   var2 = (int32_t)(uncomp_data->humidity * 16384);
   var3 = (int32_t)(((int32_t)calib_data->dig_h4) * 1048576);
   var4 = ((int32_t)calib_data->dig_h5) * var1;
-  var5 = (((var2 - var3) - var4) + (int32_t)16384) / 32768;
-  var2 = (var1 * ((int32_t)calib_data->dig_h6)) / 1024;
-  var3 = (var1 * ((int32_t)calib_data->dig_h3)) / 2048;
-  var4 = ((var2 * (var3 + (int32_t)32768)) / 1024) + (int32_t)2097152;
-  var2 = ((var4 * ((int32_t)calib_data->dig_h2)) + 8192) / 16384;
+  var5 = (((var2 - var3) - var4) + (int32_t)16384) >> 15;
+  var2 = (var1 * ((int32_t)calib_data->dig_h6)) >> 10;
+  var3 = (var1 * ((int32_t)calib_data->dig_h3)) >> 11;
+  var4 = ((var2 * (var3 + (int32_t)32768)) >> 10) + (int32_t)2097152;
+  var2 = ((var4 * ((int32_t)calib_data->dig_h2)) + 8192) >> 14;
   var3 = var5 * var2;
-  var4 = ((var3 / 32768) * (var3 / 32768)) / 128;
-  var5 = var3 - ((var4 * ((int32_t)calib_data->dig_h1)) / 16);
+  var4 = ((var3 >> 15) * (var3 >> 15)) >> 7;
+  var5 = var3 - ((var4 * ((int32_t)calib_data->dig_h1)) >> 4);
   var5 = (var5 < 0 ? 0 : var5);
   var5 = (var5 > 419430400 ? 419430400 : var5);
   humidity = (uint32_t)(var5 / 4096);
@@ -0,0 +1,242 @@
+/*! @file batch.c
+ * @brief Compensation of many BME280 raw frames at once
+ *
+ * @details Each stage mirrors the corresponding compensate_*() function of bme2.c operation for
+ * operation, so that results stay bit-identical, but its branches are turned into selects. In the
+ * fixed-point modes, the pressure stage divides integers and stays scalar; in the floating-point
+ * mode, every stage is vectorized on x86, but not on the AM335x, whose NEON unit has no doubles.
+ */
+
+#include "batch.h"
+#include "common.h"
+
+// Vectorizes the stages whatever the optimization level. Floating-point exceptions are not used,
+// and assuming so lets the clamps become selects (results are unchanged)
+#define VECTORIZED \
+  __attribute__((optimize("tree-vectorize", "vect-cost-model=dynamic", "no-trapping-math")))
+
+void bme_batch_reset(struct bme_batch* batch) {
+  batch->count = 0;
+}
+
+int16_t bme_batch_add(struct bme_batch* batch,
+                      const struct bme280_calib_data* calib,
+                      const struct bme280_uncomp_data* uncomp_data) {
+  uint16_t i = batch->count;
+
+  if (i == BME_BATCH_MAX)
+    return -1;
+
+  batch->adc_t[i] = uncomp_data->temperature;
+  batch->adc_p[i] = uncomp_data->pressure;
+  batch->adc_h[i] = uncomp_data->humidity;
+
+  batch->dig_t1[i] = calib->dig_t1;
+  batch->dig_t2[i] = calib->dig_t2;
+  batch->dig_t3[i] = calib->dig_t3;
+  batch->dig_p1[i] = calib->dig_p1;
+  batch->dig_p2[i] = calib->dig_p2;
+  batch->dig_p3[i] = calib->dig_p3;
+  batch->dig_p4[i] = calib->dig_p4;
+  batch->dig_p5[i] = calib->dig_p5;
+  batch->dig_p6[i] = calib->dig_p6;
+  batch->dig_p7[i] = calib->dig_p7;
+  batch->dig_p8[i] = calib->dig_p8;
+  batch->dig_p9[i] = calib->dig_p9;
+  batch->dig_h1[i] = calib->dig_h1;
+  batch->dig_h2[i] = calib->dig_h2;
+  batch->dig_h3[i] = calib->dig_h3;
+  batch->dig_h4[i] = calib->dig_h4;
+  batch->dig_h5[i] = calib->dig_h5;
+  batch->dig_h6[i] = calib->dig_h6;
+
+  batch->count++;
+  return i;
+}
+
+#ifdef BME280_FLOAT_ENABLE
+
+VECTORIZED static void compensate_temperature(struct bme_batch* b) {
+  for (uint16_t i = 0; i < b->count; i++) {
+    double var1, var2, temperature;
+
+    var1 = ((double)b->adc_t[i]) / 16384.0 - ((double)b->dig_t1[i]) / 1024.0;
+    var1 = var1 * ((double)b->dig_t2[i]);
+    var2 = (((double)b->adc_t[i]) / 131072.0 - ((double)b->dig_t1[i]) / 8192.0);
+    var2 = (var2 * var2) * ((double)b->dig_t3[i]);
+    b->t_fine[i] = (int32_t)(var1 + var2);
+    temperature = (var1 + var2) / 5120.0;
+
+    temperature = temperature < -40 ? -40 : temperature > 85 ? 85 : temperature;
+    b->temperature[i] = temperature * BME_TEMPERATURE_SCALE;
+  }
+}
+
+VECTORIZED static void compensate_pressure(struct bme_batch* b) {
+  for (uint16_t i = 0; i < b->count; i++) {
+    double var1, var2, var3, pressure;
+    int valid;
+
+    var1 = ((double)b->t_fine[i] / 2.0) - 64000.0;
+    var2 = var1 * var1 * ((double)b->dig_p6[i]) / 32768.0;
+    var2 = var2 + var1 * ((double)b->dig_p5[i]) * 2.0;
+    var2 = (var2 / 4.0) + (((double)b->dig_p4[i]) * 65536.0);
+    var3 = ((double)b->dig_p3[i]) * var1 * var1 / 524288.0;
+    var1 = (var3 + ((double)b->dig_p2[i]) * var1) / 524288.0;
+    var1 = (1.0 + var1 / 32768.0) * ((double)b->dig_p1[i]);
+
+    // A zero divisor is replaced, and its result discarded
+    valid = var1 > 0.0;
+    var1 = valid ? var1 : 1.0;
+
+    pressure = 1048576.0 - (double)b->adc_p[i];
+    pressure = (pressure - (var2 / 4096.0)) * 6250.0 / var1;
+    var1 = ((double)b->dig_p9[i]) * pressure * pressure / 2147483648.0;
+    var2 = pressure * ((double)b->dig_p8[i]) / 32768.0;
+    pressure = pressure + (var1 + var2 + ((double)b->dig_p7[i])) / 16.0;
+
+    pressure = pressure < 30000.0 ? 30000.0 : pressure > 110000.0 ? 110000.0 : pressure;
+    pressure = valid ? pressure : 30000.0;
+    b->pressure[i] = pressure * BME_PRESSURE_SCALE;
+  }
+}
+
+VECTORIZED static void compensate_humidity(struct bme_batch* b) {
+  for (uint16_t i = 0; i < b->count; i++) {
+    double humidity, var1, var2, var3, var4, var5, var6;
+
+    var1 = ((double)b->t_fine[i]) - 76800.0;
+    var2 = (((double)b->dig_h4[i]) * 64.0 + (((double)b->dig_h5[i]) / 16384.0) * var1);
+    var3 = b->adc_h[i] - var2;
+    var4 = ((double)b->dig_h2[i]) / 65536.0;
+    var5 = (1.0 + (((double)b->dig_h3[i]) / 67108864.0) * var1);
+    var6 = 1.0 + (((double)b->dig_h6[i]) / 67108864.0) * var1 * var5;
+    var6 = var3 * var4 * (var5 * var6);
+    humidity = var6 * (1.0 - ((double)b->dig_h1[i]) * var6 / 524288.0);
+
+    humidity = humidity > 100.0 ? 100.0 : humidity < 0.0 ? 0.0 : humidity;
+    b->humidity[i] = humidity * BME_HUMIDITY_SCALE;
+  }
+}
+
+#else
+
+VECTORIZED static void compensate_temperature(struct bme_batch* b) {
+  for (uint16_t i = 0; i < b->count; i++) {
+    int32_t var1, var2, temperature;
+
+    var1 = (int32_t)((b->adc_t[i] >> 3) - ((int32_t)b->dig_t1[i] << 1));
+    var1 = (var1 * ((int32_t)b->dig_t2[i])) >> 11;
+    var2 = (int32_t)((b->adc_t[i] >> 4) - ((int32_t)b->dig_t1[i]));
+    var2 = (((var2 * var2) >> 12) * ((int32_t)b->dig_t3[i])) >> 14;
+    b->t_fine[i] = var1 + var2;
+    temperature = (b->t_fine[i] * 5 + 128) >> 8;
+
+    temperature = temperature < -4000 ? -4000 : temperature > 8500 ? 8500 : temperature;
+    b->temperature[i] = temperature * BME_TEMPERATURE_SCALE;
+  }
+}
+
+#ifndef BME280_32BIT_ENABLE
+
+static void compensate_pressure(struct bme_batch* b) {
+  for (uint16_t i = 0; i < b->count; i++) {
+    int64_t var1, var2, var3, var4;
+    uint32_t pressure;
+    int valid;
+
+    var1 = ((int64_t)b->t_fine[i]) - 128000;
+    var2 = var1 * var1 * (int64_t)b->dig_p6[i];
+    var2 = var2 + ((var1 * (int64_t)b->dig_p5[i]) * 131072);
+    var2 = var2 + (((int64_t)b->dig_p4[i]) * 34359738368);
+    var1 = ((var1 * var1 * (int64_t)b->dig_p3[i]) >> 8) +
+           ((var1 * ((int64_t)b->dig_p2[i]) * 4096));
+    var3 = ((int64_t)1) * 140737488355328;
+    var1 = ((var3 + var1) * ((int64_t)b->dig_p1[i])) >> 33;
+
+    valid = var1 != 0;
+    var1 = valid ? var1 : 1;
+
+    var4 = 1048576 - b->adc_p[i];
+    var4 = (((var4 * INT64_C(2147483648)) - var2) * 3125) / var1;
+    var1 = (((int64_t)b->dig_p9[i]) * (var4 >> 13) * (var4 >> 13)) >> 25;
+    var2 = (((int64_t)b->dig_p8[i]) * var4) >> 19;
+    var4 = ((var4 + var1 + var2) >> 8) + (((int64_t)b->dig_p7[i]) * 16);
+    pressure = (uint32_t)(((var4 / 2) * 100) / 128);
+
+    pressure = pressure < 3000000 ? 3000000 : pressure > 11000000 ? 11000000 : pressure;
+    pressure = valid ? pressure : 3000000;
+    b->pressure[i] = pressure * BME_PRESSURE_SCALE;
+  }
+}
+
+#else
+
+static void compensate_pressure(struct bme_batch* b) {
+  for (uint16_t i = 0; i < b->count; i++) {
+    int32_t var1, var2, var3, var4;
+    uint32_t var5, pressure;
+    int valid;
+
+    var1 = (((int32_t)b->t_fine[i]) >> 1) - (int32_t)64000;
+    var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t)b->dig_p6[i]);
+    var2 = var2 + ((var1 * ((int32_t)b->dig_p5[i])) * 2);
+    var2 = (var2 >> 2) + (((int32_t)b->dig_p4[i]) * 65536);
+    var3 = (b->dig_p3[i] * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3;
+    var4 = (((int32_t)b->dig_p2[i]) * var1) >> 1;
+    var1 = (var3 + var4) >> 18;
+    var1 = (((32768 + var1)) * ((int32_t)b->dig_p1[i])) >> 15;
+
+    valid = var1 != 0;
+    var1 = valid ? var1 : 1;
+
+    var5 = (uint32_t)((uint32_t)1048576) - b->adc_p[i];
+    pressure = ((uint32_t)(var5 - (uint32_t)(var2 >> 12))) * 3125;
+    pressure = pressure < 0x80000000 ? (pressure << 1) / ((uint32_t)var1)
+                                     : (pressure / (uint32_t)var1) * 2;
+    var1 = (((int32_t)b->dig_p9[i]) * ((int32_t)(((pressure / 8) * (pressure / 8)) / 8192))) >>
+           12;
+    var2 = (((int32_t)(pressure / 4)) * ((int32_t)b->dig_p8[i])) >> 13;
+    pressure = (uint32_t)((int32_t)pressure + ((var1 + var2 + b->dig_p7[i]) >> 4));
+
+    pressure = pressure < 30000 ? 30000 : pressure > 110000 ? 110000 : pressure;
+    pressure = valid ? pressure : 30000;
+    b->pressure[i] = pressure * BME_PRESSURE_SCALE;
+  }
+}
+
+#endif
+
+VECTORIZED static void compensate_humidity(struct bme_batch* b) {
+  for (uint16_t i = 0; i < b->count; i++) {
+    int32_t var1, var2, var3, var4, var5;
+    uint32_t humidity;
+
+    var1 = b->t_fine[i] - ((int32_t)76800);
+    var2 = (int32_t)(b->adc_h[i] * 16384);
+    var3 = (int32_t)(((int32_t)b->dig_h4[i]) * 1048576);
+    var4 = ((int32_t)b->dig_h5[i]) * var1;
+    var5 = (((var2 - var3) - var4) + (int32_t)16384) >> 15;
+    var2 = (var1 * ((int32_t)b->dig_h6[i])) >> 10;
+    var3 = (var1 * ((int32_t)b->dig_h3[i])) >> 11;
+    var4 = ((var2 * (var3 + (int32_t)32768)) >> 10) + (int32_t)2097152;
+    var2 = ((var4 * ((int32_t)b->dig_h2[i])) + 8192) >> 14;
+    var3 = var5 * var2;
+    var4 = ((var3 >> 15) * (var3 >> 15)) >> 7;
+    var5 = var3 - ((var4 * ((int32_t)b->dig_h1[i])) >> 4);
+    var5 = (var5 < 0 ? 0 : var5);
+    var5 = (var5 > 419430400 ? 419430400 : var5);
+    humidity = (uint32_t)(var5 / 4096);
+
+    humidity = humidity > 102400 ? 102400 : humidity;
+    b->humidity[i] = humidity * BME_HUMIDITY_SCALE;
+  }
+}
+
+#endif
+
+void bme_batch_compensate(struct bme_batch* batch) {
+  compensate_temperature(batch);
+  compensate_pressure(batch);
+  compensate_humidity(batch);
+}
@@ -0,0 +1,81 @@
+/*! @file batch.h
+ * @brief Declarations for compensating many BME280 raw frames at once
+ */
+
+/*!
+ * @defgroup bmeBatch Batch compensation
+ * @brief Structure-of-arrays compensation of raw frames from any amount of sensors
+ *
+ * @details Frames are appended with their own calibration, then compensated together, one stage
+ * (temperature, pressure, humidity) at a time over contiguous arrays, so that the compiler can
+ * vectorize the loops. Results are bit-identical with bme280_compensate_data() in the same
+ * compensation mode (BME280_COMP in the Makefile), scaled to °C, hPa and %RH as by bme_read().
+ * Besides the daemons' sweeps, this serves offline reprocessing of recorded raw data: fill,
+ * compensate and reset a batch for every BME_BATCH_MAX frames.
+ */
+
+#ifndef BME_BATCH_H
+#define BME_BATCH_H
+
+#include "../bme2.h"
+
+/// Frames per batch
+#define BME_BATCH_MAX 64
+
+/*!
+ * @brief Raw frames, their calibration and, once compensated, their readings
+ */
+struct bme_batch {
+  uint16_t count;
+
+  // Raw frames
+  uint32_t adc_t[BME_BATCH_MAX];
+  uint32_t adc_p[BME_BATCH_MAX];
+  uint32_t adc_h[BME_BATCH_MAX];
+
+  // Calibration of each frame's sensor
+  uint16_t dig_t1[BME_BATCH_MAX];
+  int16_t dig_t2[BME_BATCH_MAX], dig_t3[BME_BATCH_MAX];
+  uint16_t dig_p1[BME_BATCH_MAX];
+  int16_t dig_p2[BME_BATCH_MAX], dig_p3[BME_BATCH_MAX], dig_p4[BME_BATCH_MAX];
+  int16_t dig_p5[BME_BATCH_MAX], dig_p6[BME_BATCH_MAX], dig_p7[BME_BATCH_MAX];
+  int16_t dig_p8[BME_BATCH_MAX], dig_p9[BME_BATCH_MAX];
+  uint8_t dig_h1[BME_BATCH_MAX], dig_h3[BME_BATCH_MAX];
+  int16_t dig_h2[BME_BATCH_MAX], dig_h4[BME_BATCH_MAX], dig_h5[BME_BATCH_MAX];
+  int8_t dig_h6[BME_BATCH_MAX];
+
+  int32_t t_fine[BME_BATCH_MAX];
+
+  // Readings
+  double temperature[BME_BATCH_MAX];  ///< °C
+  double pressure[BME_BATCH_MAX];     ///< hPa
+  double humidity[BME_BATCH_MAX];     ///< %RH
+};
+
+/**
+ * \ingroup bmeBatch
+ * @brief Empties a batch
+ */
+void bme_batch_reset(struct bme_batch* batch);
+
+/**
+ * \ingroup bmeBatch
+ * @brief Appends a raw frame
+ * @param[in, out] batch Batch
+ * @param[in] calib Calibration of the sensor the frame was read from
+ * @param[in] uncomp_data Raw frame (see bme280_parse_sensor_data())
+ * @returns Index of the frame's readings in the batch
+ * @retval -1 The batch is full
+ */
+int16_t bme_batch_add(struct bme_batch* batch,
+                      const struct bme280_calib_data* calib,
+                      const struct bme280_uncomp_data* uncomp_data);
+
+/**
+ * \ingroup bmeBatch
+ * @brief Compensates every frame in a batch
+ * @details Fills the batch's temperature, pressure and humidity arrays.
+ */
+void bme_batch_compensate(struct bme_batch* batch);
+
+#endif
@@ -5,11 +5,10 @@
 #include <math.h>
 #include <syslog.h>
 
+#include "../../bench/common.h"
+#include "batch.h"
 #include "common.h"
 
-int8_t fd_76 = 0;
-int8_t fd_77 = 0;
-
 /**
  * @brief Initializes sensor communication
  * @param[in] dev BME280/BMP280 device
@@ -27,14 +26,11 @@ int8_t bme_init(struct bme280_dev* dev, struct identifier* id, uint8_t addr) {
     return BUS_FAIL;
   }
 
-  int8_t* fd = addr == 0x76 ? &fd_76 : &fd_77;
-
-  if (i2c_open(fd, addr)) {
+  if (i2c_open(id, addr)) {
     syslog(LOG_CRIT, "Failed to open bus");
     return BUS_FAIL;
   }
 
-  id->fd = *fd;
   dev->intf = BME280_I2C_INTF;
   dev->read = i2c_read;
   dev->write = i2c_write;
@@ -62,30 +58,168 @@ int8_t bme_init(struct bme280_dev* dev, struct identifier* id, uint8_t addr) {
   return rslt;
 }
 
+/**
+ * @brief Selects a sensor's multiplexer channel(s)
+ * @param[in] id Sensor identification struct
+ */
+static void select_channel(const struct identifier* id) {
+  direct_mux(id->mux_id);
+
+  if (id->ext_mux_id >= 0)
+    direct_ext_mux(id->ext_mux_id);
+}
+
+/**
+ * @brief Queues the messages reading a sensor's data registers (register pointer write, followed
+ * by an 8-byte read)
+ * @param[in, out] txn Transaction
+ * @param[in] id Sensor identification struct
+ * @param[out] reg_data Data register buffer
+ */
+static void queue_data_read(struct i2c_txn* txn, const struct identifier* id, uint8_t* reg_data) {
+  static const uint8_t data_addr = BME280_DATA_ADDR;
+
+  i2c_txn_write(txn, id->addr, &data_addr, 1);
+  i2c_txn_read(txn, id->addr, reg_data, BME280_P_T_H_DATA_LEN);
+}
+
+/**
+ * @brief Compensates raw data register contents
+ */
+static int8_t compensate(struct bme280_dev* dev,
+                         const uint8_t* reg_data,
+                         struct bme_data* comp_data) {
+  struct bme280_uncomp_data uncomp_data;
+  struct bme280_data data;
+  int8_t rslt;
+
+  bme280_parse_sensor_data(reg_data, &uncomp_data);
+  rslt = bme280_compensate_data(BME280_ALL, &uncomp_data, &data, &dev->calib_data);
+  comp_data->temperature = data.temperature * BME_TEMPERATURE_SCALE;
+  comp_data->pressure = data.pressure * BME_PRESSURE_SCALE;
+  comp_data->humidity = data.humidity * BME_HUMIDITY_SCALE;
+
+  return rslt;
+}
+
 /**
  * @brief Reads sensor data
+ * @details The register pointer write and the data read go out as a single I2C transaction.
  * @param[in] dev BME280/BMP280 device
  * @param[out] comp_data Pointer to compensated data struct
  * @retval 0 OK
  * @retval -2 Communication failure
  */
-int8_t bme_read(struct bme280_dev* dev, struct bme280_data* comp_data) {
-  int8_t rslt = BME280_OK;
-
-  struct identifier id;
-  id = *((struct identifier*)dev->intf_ptr);
+int8_t bme_read(struct bme280_dev* dev, struct bme_data* comp_data) {
+  const struct identifier* id = dev->intf_ptr;
+  uint8_t reg_data[BME280_P_T_H_DATA_LEN];
+  struct i2c_txn txn;
+  int8_t rslt;
 
-  direct_mux(id.mux_id);
+  select_channel(id);
+  i2c_txn_init(&txn);
+  queue_data_read(&txn, id, reg_data);
 
-  if (id.ext_mux_id >= 0)
-    direct_ext_mux(id.ext_mux_id);
+  rslt = i2c_txn_submit(&txn) ? BME280_E_COMM_FAIL : BME280_OK;
+  BENCH_STAGE("bus");
 
-  rslt = bme280_get_sensor_data(BME280_ALL, comp_data, dev);
-  comp_data->pressure *= 0.01;
+  if (rslt == BME280_OK)
+    rslt = compensate(dev, reg_data, comp_data);
+  BENCH_STAGE("compensation");
 
   return rslt;
 }
 
+#ifdef BME280_BATCH_SWEEP
+
+/**
+ * @brief Compensates a batch of frames and stores the readings in their sensors
+ * @param[in, out] batch Batch, emptied afterwards
+ * @param[out] batched Sensor each frame was read from
+ */
+static void flush_batch(struct bme_batch* batch, struct bme_sensor_data** batched) {
+  bme_batch_compensate(batch);
+
+  for (uint16_t i = 0; i < batch->count; i++) {
+    batched[i]->data.temperature = batch->temperature[i];
+    batched[i]->data.pressure = batch->pressure[i];
+    batched[i]->data.humidity = batch->humidity[i];
+  }
+
+  bme_batch_reset(batch);
+}
+
+#endif
+
+int8_t bme_read_burst(struct bme_sensor_data* sensors, uint8_t count, int8_t* rslt) {
+  struct i2c_txn txn;
+  uint8_t reg_data[BME_BURST_MAX][BME280_P_T_H_DATA_LEN];
+  int8_t status = BME280_OK;
+  uint8_t first, n;
+#ifdef BME280_BATCH_SWEEP
+  struct bme_batch batch;
+  struct bme_sensor_data* batched[BME_BATCH_MAX];
+  struct bme280_uncomp_data uncomp_data;
+
+  bme_batch_reset(&batch);
+#endif
+
+  for (first = 0; first < count; first += n) {
+    const struct identifier* id = &sensors[first].id;
+
+    i2c_txn_init(&txn);
+    for (n = 0; first + n < count && n < BME_BURST_MAX; n++) {
+      const struct identifier* other = &sensors[first + n].id;
+
+      if (other->mux_id != id->mux_id || other->ext_mux_id != id->ext_mux_id)
+        break;
+      queue_data_read(&txn, other, reg_data[n]);
+    }
+
+    select_channel(id);
+
+    if (i2c_txn_submit(&txn) == 0) {
+      BENCH_STAGE("bus");
+#ifdef BME280_BATCH_SWEEP
+      if (batch.count + n > BME_BATCH_MAX)
+        flush_batch(&batch, batched);
+
+      // Frames are compensated together once every channel has been read
+      for (uint8_t k = 0; k < n; k++) {
+        struct bme_sensor_data* sensor = &sensors[first + k];
+
+        bme280_parse_sensor_data(reg_data[k], &uncomp_data);
+        batched[bme_batch_add(&batch, &sensor->dev.calib_data, &uncomp_data)] = sensor;
+        rslt[first + k] = BME280_OK;
+      }
+#else
+      for (uint8_t k = 0; k < n; k++) {
+        struct bme_sensor_data* sensor = &sensors[first + k];
+        rslt[first + k] = compensate(&sensor->dev, reg_data[k], &sensor->data);
+      }
+#endif
+      BENCH_STAGE("compensation");
+    } else {
+      BENCH_STAGE("bus");
+      // A sensor that does not acknowledge aborts the whole transaction
+      for (uint8_t k = 0; k < n; k++)
+        rslt[first + k] = bme_read(&sensors[first + k].dev, &sensors[first + k].data);
+    }
+
+    for (uint8_t k = 0; k < n; k++) {
+      if (rslt[first + k] != BME280_OK)
+        status = BME280_E_COMM_FAIL;
+    }
+  }
+
+#ifdef BME280_BATCH_SWEEP
+  flush_batch(&batch, batched);
+  BENCH_STAGE("compensation");
+#endif
+
+  return status;
+}
+
 int8_t check_alteration(struct bme_sensor_data sensor) {
   return sensor.data.pressure > 800 && sensor.data.pressure < 1000 &&
                  (sensor.past_pres == 0 ||
@@ -11,7 +11,38 @@
 #define WINDOW_SIZE 5
 #define MAX_NAME_LEN 16
 
-int8_t bme_read(struct bme280_dev* dev, struct bme280_data* comp_data);
+/// Maximum amount of sensors read in a single I2C transaction (two messages each)
+#define BME_BURST_MAX 16
+
+/*
+ * Scales from bme280_compensate_data() output to °C, hPa and %RH. The compensation mode is picked
+ * at build time (BME280_COMP in the Makefile): double precision, or Bosch's fixed-point reference
+ * with 32-bit or 64-bit pressure compensation.
+ */
+#ifdef BME280_FLOAT_ENABLE
+#define BME_TEMPERATURE_SCALE 1.0
+#define BME_PRESSURE_SCALE 0.01  ///< Pa
+#define BME_HUMIDITY_SCALE 1.0
+#else
+#define BME_TEMPERATURE_SCALE 0.01  ///< 1/100 °C
+#ifdef BME280_32BIT_ENABLE
+#define BME_PRESSURE_SCALE 0.01  ///< Pa
+#else
+#define BME_PRESSURE_SCALE 0.0001  ///< 1/100 Pa
+#endif
+#define BME_HUMIDITY_SCALE (1.0 / 1024)  ///< 1/1024 %RH
+#endif
+
+/*!
+ * @brief Compensated readings, in the same units whatever the compensation mode
+ */
+struct bme_data {
+  double temperature;  ///< °C
+  double pressure;     ///< hPa
+  double humidity;     ///< %RH
+};
+
+int8_t bme_read(struct bme280_dev* dev, struct bme_data* comp_data);
 int8_t bme_init(struct bme280_dev* dev, struct identifier* id, uint8_t address);
 
 /*!
@@ -22,7 +53,7 @@ struct bme_sensor_data {
   double past_pres;
   double average;
   double open_average;
-  struct bme280_data data;
+  struct bme_data data;
   double window[WINDOW_SIZE];
   struct bme280_dev dev;
   uint8_t strikes_closed;
@@ -42,4 +73,21 @@ struct bme_sensor_data {
  */
 int8_t check_alteration(struct bme_sensor_data sensor);
 
+/**
+ * @brief Reads several sensors, batching those on the same channel into a single I2C transaction
+ *
+ * @param[in, out] sensors : Sensors, grouped by channel (see bme_read())
+ * @param[in] count : Amount of sensors
+ * @param[out] rslt : Read result for each sensor (BME280_OK or an error code)
+ *
+ * @details Sensors are expected to be sorted by channel, as consecutive sensors on the same
+ * channel are read in one transaction. If a transaction fails, its sensors are read one at a time
+ * to find out which of them failed. Frames are compensated one at a time, or, in builds with
+ * `BME280_BATCH=1`, together at the end (see bme_batch_compensate()).
+ *
+ * @retval 0 All sensors read
+ * @retval -2 At least one sensor could not be read
+ */
+int8_t bme_read_burst(struct bme_sensor_data* sensors, uint8_t count, int8_t* rslt);
+
 #endif
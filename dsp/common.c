@@ -0,0 +1,188 @@
+/*! @file common.c
+ * @brief Sampled signal processing kernels
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <string.h>
+
+typedef float vec_f __attribute__((vector_size(DSP_LANES * sizeof(float))));
+typedef int32_t vec_i __attribute__((vector_size(DSP_LANES * sizeof(int32_t))));
+typedef uint16_t vec_u16 __attribute__((vector_size(DSP_LANES * sizeof(uint16_t))));
+
+// Keeps the reference kernels scalar, whatever the optimization level
+#define SCALAR __attribute__((optimize("no-tree-vectorize")))
+
+// Unaligned loads and stores (memcpy compiles down to a single vector instruction)
+static inline vec_f load_f(const float* p) {
+  vec_f v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void store_f(float* p, vec_f v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+static inline vec_f splat(float x) {
+  return (vec_f){0} + x;
+}
+
+static inline vec_f select_f(vec_i mask, vec_f a, vec_f b) {
+  return (vec_f)((mask & (vec_i)a) | (~mask & (vec_i)b));
+}
+
+static inline float hsum(vec_f v) {
+  float sum = 0;
+
+  for (uint8_t l = 0; l < DSP_LANES; l++)
+    sum += v[l];
+  return sum;
+}
+
+void dsp_convert(const uint16_t* codes, uint32_t n, float gain, float offset, float* out) {
+  const vec_f g = splat(gain), o = splat(offset);
+  uint32_t k = 0;
+  vec_u16 c;
+
+  for (; k + DSP_LANES <= n; k += DSP_LANES) {
+    memcpy(&c, codes + k, sizeof(c));
+    store_f(out + k, __builtin_convertvector(c, vec_f) * g + o);
+  }
+
+  for (; k < n; k++)
+    out[k] = codes[k] * gain + offset;
+}
+
+SCALAR void dsp_convert_scalar(const uint16_t* codes,
+                               uint32_t n,
+                               float gain,
+                               float offset,
+                               float* out) {
+  for (uint32_t k = 0; k < n; k++)
+    out[k] = codes[k] * gain + offset;
+}
+
+void dsp_stats_update(struct dsp_stats* stats, const float* x, uint32_t n) {
+  vec_f sum = splat(0), sum_sq = splat(0), min = splat(INFINITY), max = splat(-INFINITY);
+  float tail_sum = 0, tail_sq = 0;
+  uint32_t k = 0;
+  vec_f v;
+
+  for (; k + DSP_LANES <= n; k += DSP_LANES) {
+    v = load_f(x + k);
+    sum += v;
+    sum_sq += v * v;
+    min = select_f(v < min, v, min);
+    max = select_f(v > max, v, max);
+  }
+
+  for (; k < n; k++) {
+    tail_sum += x[k];
+    tail_sq += x[k] * x[k];
+    min[0] = fminf(min[0], x[k]);
+    max[0] = fmaxf(max[0], x[k]);
+  }
+
+  for (uint8_t l = 0; l < DSP_LANES; l++) {
+    stats->min = fminf(stats->min, min[l]);
+    stats->max = fmaxf(stats->max, max[l]);
+  }
+
+  stats->count += n;
+  stats->sum += hsum(sum) + tail_sum;
+  stats->sum_sq += hsum(sum_sq) + tail_sq;
+}
+
+SCALAR void dsp_stats_update_scalar(struct dsp_stats* stats, const float* x, uint32_t n) {
+  float sum = 0, sum_sq = 0;
+
+  for (uint32_t k = 0; k < n; k++) {
+    sum += x[k];
+    sum_sq += x[k] * x[k];
+    stats->min = fminf(stats->min, x[k]);
+    stats->max = fmaxf(stats->max, x[k]);
+  }
+
+  stats->count += n;
+  stats->sum += sum;
+  stats->sum_sq += sum_sq;
+}
+
+void dsp_power_update(struct dsp_power* power, const float* v, const float* i, uint32_t n) {
+  vec_f vi = splat(0), vv = splat(0), ii = splat(0);
+  float tail_vi = 0, tail_vv = 0, tail_ii = 0;
+  uint32_t k = 0;
+  vec_f a, b;
+
+  for (; k + DSP_LANES <= n; k += DSP_LANES) {
+    a = load_f(v + k);
+    b = load_f(i + k);
+    vi += a * b;
+    vv += a * a;
+    ii += b * b;
+  }
+
+  for (; k < n; k++) {
+    tail_vi += v[k] * i[k];
+    tail_vv += v[k] * v[k];
+    tail_ii += i[k] * i[k];
+  }
+
+  power->count += n;
+  power->sum_vi += hsum(vi) + tail_vi;
+  power->sum_vv += hsum(vv) + tail_vv;
+  power->sum_ii += hsum(ii) + tail_ii;
+}
+
+SCALAR void dsp_power_update_scalar(struct dsp_power* power,
+                                    const float* v,
+                                    const float* i,
+                                    uint32_t n) {
+  float vi = 0, vv = 0, ii = 0;
+
+  for (uint32_t k = 0; k < n; k++) {
+    vi += v[k] * i[k];
+    vv += v[k] * v[k];
+    ii += i[k] * i[k];
+  }
+
+  power->count += n;
+  power->sum_vi += vi;
+  power->sum_vv += vv;
+  power->sum_ii += ii;
+}
+
+void dsp_stats_init(struct dsp_stats* stats) {
+  *stats = (struct dsp_stats){.min = INFINITY, .max = -INFINITY};
+}
+
+double dsp_mean(const struct dsp_stats* stats) {
+  return stats->count ? stats->sum / stats->count : 0;
+}
+
+double dsp_ac_rms(const struct dsp_stats* stats) {
+  double mean = dsp_mean(stats), variance;
+
+  if (stats->count == 0)
+    return 0;
+
+  variance = stats->sum_sq / stats->count - mean * mean;
+  return variance > 0 ? sqrt(variance) : 0;
+}
+
+double dsp_peak(const struct dsp_stats* stats) {
+  double mean = dsp_mean(stats);
+
+  return stats->count ? fmax(stats->max - mean, mean - stats->min) : 0;
+}
+
+double dsp_active_power(const struct dsp_power* power) {
+  return power->count ? power->sum_vi / power->count : 0;
+}
+
+double dsp_apparent_power(const struct dsp_power* power) {
+  return power->count ? sqrt(power->sum_vv / power->count) * sqrt(power->sum_ii / power->count)
+                      : 0;
+}
@@ -0,0 +1,137 @@
+/*! @file common.h
+ * @brief Common declarations for sampled signal processing
+ */
+
+/*!
+ * @defgroup dsp DSP
+ * @brief Bulk conversion and statistics kernels for sampled ADC data
+ *
+ * @details Kernels work on blocks of thousands of samples per call. They are written with GCC
+ * vector extensions (DSP_LANES floats wide), so the same source compiles to SSE on x86 and to NEON
+ * on ARM (with `-mfpu=neon`). Every kernel has a plain scalar counterpart (`_scalar` suffix) with
+ * the same interface, kept as a reference for tests and benchmarks. Running sums are kept in
+ * float within a call and folded into double between calls, so blocks should stay below a few
+ * thousand samples.
+ */
+
+#ifndef DSP_COMMON_H
+#define DSP_COMMON_H
+
+#include <stdint.h>
+
+#define DSP_LANES 4
+
+/*!
+ * @brief Running statistics of a signal
+ */
+struct dsp_stats {
+  uint32_t count;
+  double sum;
+  double sum_sq;
+  float min;
+  float max;
+};
+
+/*!
+ * @brief Running sums for power computation over a voltage/current pair
+ */
+struct dsp_power {
+  uint32_t count;
+  double sum_vi;  ///< Sum of instantaneous power
+  double sum_vv;  ///< Sum of squared voltage
+  double sum_ii;  ///< Sum of squared current
+};
+
+/**
+ * \ingroup dsp
+ * \defgroup dspKernels Kernels
+ * @brief Bulk kernels, with their scalar references
+ */
+
+/**
+ * \ingroup dspKernels
+ * @brief Converts ADC codes to physical values (`out[i] = codes[i] * gain + offset`)
+ * @param[in] codes ADC codes
+ * @param[in] n Amount of samples
+ * @param[in] gain Value of one code step
+ * @param[in] offset Value of code 0
+ * @param[out] out Converted values
+ */
+void dsp_convert(const uint16_t* codes, uint32_t n, float gain, float offset, float* out);
+void dsp_convert_scalar(const uint16_t* codes, uint32_t n, float gain, float offset, float* out);
+
+/**
+ * \ingroup dspKernels
+ * @brief Adds a block of samples to running statistics
+ * @param[in, out] stats Statistics (zeroed with dsp_stats_init() before the first block)
+ * @param[in] x Samples
+ * @param[in] n Amount of samples
+ */
+void dsp_stats_update(struct dsp_stats* stats, const float* x, uint32_t n);
+void dsp_stats_update_scalar(struct dsp_stats* stats, const float* x, uint32_t n);
+
+/**
+ * \ingroup dspKernels
+ * @brief Adds a block of simultaneous voltage and current samples to running power sums
+ * @param[in, out] power Power sums (zero-initialized before the first block)
+ * @param[in] v Voltage samples
+ * @param[in] i Current samples
+ * @param[in] n Amount of samples
+ */
+void dsp_power_update(struct dsp_power* power, const float* v, const float* i, uint32_t n);
+void dsp_power_update_scalar(struct dsp_power* power, const float* v, const float* i, uint32_t n);
+
+/**
+ * \ingroup dsp
+ * \defgroup dspResults Results
+ * @brief Values derived from the running sums
+ */
+
+/**
+ * \ingroup dspResults
+ * @brief Resets running statistics
+ * @param[out] stats Statistics
+ */
+void dsp_stats_init(struct dsp_stats* stats);
+
+/**
+ * \ingroup dspResults
+ * @brief Mean value
+ * @param[in] stats Statistics
+ * @returns Mean (0 if there are no samples)
+ */
+double dsp_mean(const struct dsp_stats* stats);
+
+/**
+ * \ingroup dspResults
+ * @brief RMS value around the mean (AC RMS)
+ * @param[in] stats Statistics
+ * @returns RMS (0 if there are no samples)
+ */
+double dsp_ac_rms(const struct dsp_stats* stats);
+
+/**
+ * \ingroup dspResults
+ * @brief Largest deviation from the mean
+ * @param[in] stats Statistics
+ * @returns Peak (0 if there are no samples)
+ */
+double dsp_peak(const struct dsp_stats* stats);
+
+/**
+ * \ingroup dspResults
+ * @brief Active (mean instantaneous) power
+ * @param[in] power Power sums
+ * @returns Active power (0 if there are no samples)
+ */
+double dsp_active_power(const struct dsp_power* power);
+
+/**
+ * \ingroup dspResults
+ * @brief Apparent power (product of voltage and current RMS values)
+ * @param[in] power Power sums
+ * @returns Apparent power (0 if there are no samples)
+ */
+double dsp_apparent_power(const struct dsp_power* power);
+
+#endif
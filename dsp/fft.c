@@ -0,0 +1,154 @@
+/*! @file fft.c
+ * @brief Fixed-size real FFT and harmonic analysis
+ */
+
+#include "fft.h"
+
+#include <math.h>
+
+#include "fft_tables.h"
+
+#if FFT_TABLES_SIZE != FFT_SIZE
+#error "dsp/fft_tables.h does not match FFT_SIZE, run make fft_tables"
+#endif
+
+/// Bins on each side of a harmonic holding its energy (Hann main lobe)
+#define FFT_LOBE 2
+
+/**
+ * @brief In-place iterative radix-2 complex FFT over FFT_SIZE / 2 points
+ * @param[in, out] re Real parts (in bit-reversed order on input)
+ * @param[in, out] im Imaginary parts (in bit-reversed order on input)
+ */
+static void fft_complex(float* re, float* im) {
+  const uint32_t n = FFT_SIZE / 2;
+  uint32_t a, b, step;
+  float wr, wi, tr, ti;
+
+  for (uint32_t len = 2; len <= n; len <<= 1) {
+    // Twiddles of a len-point stage are every (FFT_SIZE / len)th table entry
+    step = FFT_SIZE / len;
+
+    for (uint32_t start = 0; start < n; start += len) {
+      for (uint32_t j = 0; j < len / 2; j++) {
+        wr = fft_cos[j * step];
+        wi = -fft_sin[j * step];
+        a = start + j;
+        b = a + len / 2;
+
+        tr = re[b] * wr - im[b] * wi;
+        ti = re[b] * wi + im[b] * wr;
+        re[b] = re[a] - tr;
+        im[b] = im[a] - ti;
+        re[a] += tr;
+        im[a] += ti;
+      }
+    }
+  }
+}
+
+void fft_real(const float* x, float* re, float* im) {
+  const uint32_t m = FFT_SIZE / 2;
+  float zr[FFT_SIZE / 2], zi[FFT_SIZE / 2];
+  float er, ei, or, oi, wr, wi;
+  uint32_t a, b;
+
+  // Even samples become the real parts, odd samples the imaginary parts
+  for (uint32_t k = 0; k < m; k++) {
+    zr[fft_bitrev[k]] = x[2 * k];
+    zi[fft_bitrev[k]] = x[2 * k + 1];
+  }
+
+  fft_complex(zr, zi);
+
+  // X[k] = E[k] + W^k * O[k], with E and O the transforms of the even and odd samples
+  for (uint32_t k = 0; k <= m; k++) {
+    a = k % m;
+    b = (m - k) % m;
+
+    er = (zr[a] + zr[b]) / 2;
+    ei = (zi[a] - zi[b]) / 2;
+    or = (zi[a] + zi[b]) / 2;
+    oi = (zr[b] - zr[a]) / 2;
+
+    wr = k < m ? fft_cos[k] : -1;
+    wi = k < m ? -fft_sin[k] : 0;
+
+    re[k] = er + wr * or - wi * oi;
+    im[k] = ei + wr * oi + wi * or;
+  }
+}
+
+/**
+ * @brief Energy of the bins around a frequency
+ * @param[in] re Real parts of the spectrum
+ * @param[in] im Imaginary parts of the spectrum
+ * @param[in] center Frequency, in bins
+ * @returns Sum of the squared magnitudes
+ */
+static double lobe_energy(const float* re, const float* im, double center) {
+  int32_t first = lround(center) - FFT_LOBE;
+  double energy = 0;
+
+  for (int32_t k = first < 1 ? 1 : first; k <= lround(center) + FFT_LOBE; k++)
+    energy += (double)re[k] * re[k] + (double)im[k] * im[k];
+
+  return energy;
+}
+
+int8_t fft_harmonics(const float* x, double sample_rate, struct fft_harmonics* h) {
+  float windowed[FFT_SIZE], re[FFT_SIZE / 2 + 1], im[FFT_SIZE / 2 + 1];
+  double bin_hz = sample_rate / FFT_SIZE, mean = 0, energy, best = 0, weighted = 0, total = 0;
+  uint32_t peak = 0, lo = ceil(FFT_FUNDAMENTAL_MIN / bin_hz), hi = FFT_FUNDAMENTAL_MAX / bin_hz;
+  double harmonics = 0, center;
+
+  if (hi + FFT_LOBE >= FFT_SIZE / 2 || lo <= FFT_LOBE)
+    return -1;
+
+  for (uint32_t k = 0; k < FFT_SIZE; k++)
+    mean += x[k];
+  mean /= FFT_SIZE;
+
+  for (uint32_t k = 0; k < FFT_SIZE; k++)
+    windowed[k] = (x[k] - mean) * fft_window[k];
+
+  fft_real(windowed, re, im);
+
+  // Fundamental: strongest bin in range, refined to the energy centroid of its lobe
+  for (uint32_t k = lo; k <= hi; k++) {
+    energy = (double)re[k] * re[k] + (double)im[k] * im[k];
+    if (energy > best) {
+      best = energy;
+      peak = k;
+    }
+  }
+
+  for (uint32_t k = peak - FFT_LOBE; k <= peak + FFT_LOBE; k++) {
+    energy = (double)re[k] * re[k] + (double)im[k] * im[k];
+    weighted += k * energy;
+    total += energy;
+  }
+
+  h->frequency = total > 0 ? weighted / total * bin_hz : peak * bin_hz;
+  h->orders = 0;
+
+  // Parseval: a sinusoid's lobe holds FFT_SIZE * FFT_WINDOW_POWER * rms^2 / 2 of energy
+  for (uint8_t order = 1; order <= FFT_HARMONICS; order++) {
+    center = order * h->frequency / bin_hz;
+    h->magnitude[order] = 0;
+
+    if (lround(center) + FFT_LOBE > FFT_SIZE / 2)
+      continue;
+
+    h->magnitude[order] = sqrt(2 * lobe_energy(re, im, center) / (FFT_SIZE * FFT_WINDOW_POWER));
+    h->orders = order;
+
+    if (order > 1)
+      harmonics += h->magnitude[order] * h->magnitude[order];
+  }
+
+  h->magnitude[0] = 0;
+  h->thd = h->magnitude[1] > 0 ? 100 * sqrt(harmonics) / h->magnitude[1] : 0;
+
+  return 0;
+}
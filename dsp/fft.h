@@ -0,0 +1,59 @@
+/*! @file fft.h
+ * @brief Declarations for the fixed-size real FFT and harmonic analysis
+ */
+
+#ifndef DSP_FFT_H
+#define DSP_FFT_H
+
+#include <stdint.h>
+
+/// Samples per transform (power of two); regenerate dsp/fft_tables.h after changing it
+#define FFT_SIZE 1024
+/// Highest harmonic order analyzed (the fundamental is order 1)
+#define FFT_HARMONICS 7
+/// Search range for the fundamental, in Hz (covers 50 and 60 Hz grids)
+#define FFT_FUNDAMENTAL_MIN 45.0
+#define FFT_FUNDAMENTAL_MAX 65.0
+
+/*!
+ * @brief Harmonic content of a signal
+ */
+struct fft_harmonics {
+  double frequency;                     ///< Fundamental frequency, in Hz
+  double magnitude[FFT_HARMONICS + 1];  ///< RMS value per order (index 1 is the fundamental)
+  double thd;                           ///< Total harmonic distortion, in % of the fundamental
+  uint8_t orders;                       ///< Highest order below the Nyquist frequency
+};
+
+/**
+ * \ingroup dsp
+ * \defgroup dspFft FFT
+ * @brief Radix-2 real FFT over FFT_SIZE samples, with precomputed tables (dsp/fft_tables.h)
+ */
+
+/**
+ * \ingroup dspFft
+ * @brief Computes the spectrum of FFT_SIZE real samples
+ * @details Packs the samples into a half-size complex transform, then splits its result into the
+ * real spectrum. No memory is allocated.
+ * @param[in] x Samples
+ * @param[out] re Real parts of bins 0 to FFT_SIZE / 2
+ * @param[out] im Imaginary parts of bins 0 to FFT_SIZE / 2
+ */
+void fft_real(const float* x, float* re, float* im);
+
+/**
+ * \ingroup dspFft
+ * @brief Measures the fundamental, the harmonics up to FFT_HARMONICS and the THD of a signal
+ * @details The mean is removed and a Hann window applied before the transform. Each harmonic's RMS
+ * value is taken from the energy of the bins around it, so it does not depend on where the
+ * harmonic falls between bins.
+ * @param[in] x FFT_SIZE samples
+ * @param[in] sample_rate Sampling rate, in Hz
+ * @param[out] h Harmonic content
+ * @retval 0 OK
+ * @retval -1 The sampling rate is too low to resolve the fundamental
+ */
+int8_t fft_harmonics(const float* x, double sample_rate, struct fft_harmonics* h);
+
+#endif
@@ -0,0 +1,483 @@
+/*! @file fft_tables.h
+ * @brief FFT tables for 1024 samples, generated by dsp/gen/fft_tables.c (do not edit)
+ */
+
+#ifndef DSP_FFT_TABLES_H
+#define DSP_FFT_TABLES_H
+
+#include <stdint.h>
+
+#define FFT_TABLES_SIZE 1024
+/// Sum of the squared window coefficients
+#define FFT_WINDOW_POWER 384
+
+// Bit reversal permutation of the 512-point complex transform
+static const uint16_t fft_bitrev[FFT_SIZE / 2] = {
+    0, 256, 128, 384, 64, 320, 192, 448, 32, 288, 160, 416,
+    96, 352, 224, 480, 16, 272, 144, 400, 80, 336, 208, 464,
+    48, 304, 176, 432, 112, 368, 240, 496, 8, 264, 136, 392,
+    72, 328, 200, 456, 40, 296, 168, 424, 104, 360, 232, 488,
+    24, 280, 152, 408, 88, 344, 216, 472, 56, 312, 184, 440,
+    120, 376, 248, 504, 4, 260, 132, 388, 68, 324, 196, 452,
+    36, 292, 164, 420, 100, 356, 228, 484, 20, 276, 148, 404,
+    84, 340, 212, 468, 52, 308, 180, 436, 116, 372, 244, 500,
+    12, 268, 140, 396, 76, 332, 204, 460, 44, 300, 172, 428,
+    108, 364, 236, 492, 28, 284, 156, 412, 92, 348, 220, 476,
+    60, 316, 188, 444, 124, 380, 252, 508, 2, 258, 130, 386,
+    66, 322, 194, 450, 34, 290, 162, 418, 98, 354, 226, 482,
+    18, 274, 146, 402, 82, 338, 210, 466, 50, 306, 178, 434,
+    114, 370, 242, 498, 10, 266, 138, 394, 74, 330, 202, 458,
+    42, 298, 170, 426, 106, 362, 234, 490, 26, 282, 154, 410,
+    90, 346, 218, 474, 58, 314, 186, 442, 122, 378, 250, 506,
+    6, 262, 134, 390, 70, 326, 198, 454, 38, 294, 166, 422,
+    102, 358, 230, 486, 22, 278, 150, 406, 86, 342, 214, 470,
+    54, 310, 182, 438, 118, 374, 246, 502, 14, 270, 142, 398,
+    78, 334, 206, 462, 46, 302, 174, 430, 110, 366, 238, 494,
+    30, 286, 158, 414, 94, 350, 222, 478, 62, 318, 190, 446,
+    126, 382, 254, 510, 1, 257, 129, 385, 65, 321, 193, 449,
+    33, 289, 161, 417, 97, 353, 225, 481, 17, 273, 145, 401,
+    81, 337, 209, 465, 49, 305, 177, 433, 113, 369, 241, 497,
+    9, 265, 137, 393, 73, 329, 201, 457, 41, 297, 169, 425,
+    105, 361, 233, 489, 25, 281, 153, 409, 89, 345, 217, 473,
+    57, 313, 185, 441, 121, 377, 249, 505, 5, 261, 133, 389,
+    69, 325, 197, 453, 37, 293, 165, 421, 101, 357, 229, 485,
+    21, 277, 149, 405, 85, 341, 213, 469, 53, 309, 181, 437,
+    117, 373, 245, 501, 13, 269, 141, 397, 77, 333, 205, 461,
+    45, 301, 173, 429, 109, 365, 237, 493, 29, 285, 157, 413,
+    93, 349, 221, 477, 61, 317, 189, 445, 125, 381, 253, 509,
+    3, 259, 131, 387, 67, 323, 195, 451, 35, 291, 163, 419,
+    99, 355, 227, 483, 19, 275, 147, 403, 83, 339, 211, 467,
+    51, 307, 179, 435, 115, 371, 243, 499, 11, 267, 139, 395,
+    75, 331, 203, 459, 43, 299, 171, 427, 107, 363, 235, 491,
+    27, 283, 155, 411, 91, 347, 219, 475, 59, 315, 187, 443,
+    123, 379, 251, 507, 7, 263, 135, 391, 71, 327, 199, 455,
+    39, 295, 167, 423, 103, 359, 231, 487, 23, 279, 151, 407,
+    87, 343, 215, 471, 55, 311, 183, 439, 119, 375, 247, 503,
+    15, 271, 143, 399, 79, 335, 207, 463, 47, 303, 175, 431,
+    111, 367, 239, 495, 31, 287, 159, 415, 95, 351, 223, 479,
+    63, 319, 191, 447, 127, 383, 255, 511
+};
+
+// cos/sin(2 * pi * k / FFT_SIZE)
+static const float fft_cos[FFT_SIZE / 2] = {
+    1, 0.999981175, 0.999924702, 0.999830582, 0.999698819,
+    0.999529418, 0.999322385, 0.999077728, 0.998795456, 0.998475581,
+    0.998118113, 0.997723067, 0.997290457, 0.996820299, 0.996312612,
+    0.995767414, 0.995184727, 0.994564571, 0.99390697, 0.993211949,
+    0.992479535, 0.991709754, 0.990902635, 0.99005821, 0.98917651,
+    0.988257568, 0.987301418, 0.986308097, 0.985277642, 0.984210092,
+    0.983105487, 0.981963869, 0.98078528, 0.979569766, 0.978317371,
+    0.977028143, 0.97570213, 0.974339383, 0.972939952, 0.971503891,
+    0.970031253, 0.968522094, 0.966976471, 0.965394442, 0.963776066,
+    0.962121404, 0.960430519, 0.958703475, 0.956940336, 0.955141168,
+    0.95330604, 0.951435021, 0.949528181, 0.947585591, 0.945607325,
+    0.943593458, 0.941544065, 0.939459224, 0.937339012, 0.93518351,
+    0.932992799, 0.930766961, 0.92850608, 0.926210242, 0.923879533,
+    0.921514039, 0.919113852, 0.91667906, 0.914209756, 0.911706032,
+    0.909167983, 0.906595705, 0.903989293, 0.901348847, 0.898674466,
+    0.89596625, 0.893224301, 0.890448723, 0.88763962, 0.884797098,
+    0.881921264, 0.879012226, 0.876070094, 0.873094978, 0.870086991,
+    0.867046246, 0.863972856, 0.860866939, 0.85772861, 0.854557988,
+    0.851355193, 0.848120345, 0.844853565, 0.841554977, 0.838224706,
+    0.834862875, 0.831469612, 0.828045045, 0.824589303, 0.821102515,
+    0.817584813, 0.81403633, 0.810457198, 0.806847554, 0.803207531,
+    0.799537269, 0.795836905, 0.792106577, 0.788346428, 0.784556597,
+    0.780737229, 0.776888466, 0.773010453, 0.769103338, 0.765167266,
+    0.761202385, 0.757208847, 0.753186799, 0.749136395, 0.745057785,
+    0.740951125, 0.736816569, 0.732654272, 0.72846439, 0.724247083,
+    0.720002508, 0.715730825, 0.711432196, 0.707106781, 0.702754744,
+    0.698376249, 0.693971461, 0.689540545, 0.685083668, 0.680600998,
+    0.676092704, 0.671558955, 0.666999922, 0.662415778, 0.657806693,
+    0.653172843, 0.648514401, 0.643831543, 0.639124445, 0.634393284,
+    0.629638239, 0.624859488, 0.620057212, 0.615231591, 0.610382806,
+    0.605511041, 0.600616479, 0.595699304, 0.590759702, 0.585797857,
+    0.580813958, 0.575808191, 0.570780746, 0.565731811, 0.560661576,
+    0.555570233, 0.550457973, 0.545324988, 0.540171473, 0.53499762,
+    0.529803625, 0.524589683, 0.51935599, 0.514102744, 0.508830143,
+    0.503538384, 0.498227667, 0.492898192, 0.48755016, 0.482183772,
+    0.47679923, 0.471396737, 0.465976496, 0.460538711, 0.455083587,
+    0.44961133, 0.444122145, 0.438616239, 0.433093819, 0.427555093,
+    0.422000271, 0.41642956, 0.410843171, 0.405241314, 0.3996242,
+    0.39399204, 0.388345047, 0.382683432, 0.37700741, 0.371317194,
+    0.365612998, 0.359895037, 0.354163525, 0.34841868, 0.342660717,
+    0.336889853, 0.331106306, 0.325310292, 0.319502031, 0.31368174,
+    0.30784964, 0.302005949, 0.296150888, 0.290284677, 0.284407537,
+    0.278519689, 0.272621355, 0.266712757, 0.260794118, 0.25486566,
+    0.248927606, 0.24298018, 0.237023606, 0.231058108, 0.225083911,
+    0.21910124, 0.21311032, 0.207111376, 0.201104635, 0.195090322,
+    0.189068664, 0.183039888, 0.17700422, 0.170961889, 0.16491312,
+    0.158858143, 0.152797185, 0.146730474, 0.140658239, 0.134580709,
+    0.128498111, 0.122410675, 0.116318631, 0.110222207, 0.104121634,
+    0.0980171403, 0.0919089565, 0.0857973123, 0.079682438, 0.0735645636,
+    0.0674439196, 0.0613207363, 0.0551952443, 0.0490676743, 0.0429382569,
+    0.0368072229, 0.0306748032, 0.0245412285, 0.0184067299, 0.0122715383,
+    0.00613588465, 6.123234e-17, -0.00613588465, -0.0122715383, -0.0184067299,
+    -0.0245412285, -0.0306748032, -0.0368072229, -0.0429382569, -0.0490676743,
+    -0.0551952443, -0.0613207363, -0.0674439196, -0.0735645636, -0.079682438,
+    -0.0857973123, -0.0919089565, -0.0980171403, -0.104121634, -0.110222207,
+    -0.116318631, -0.122410675, -0.128498111, -0.134580709, -0.140658239,
+    -0.146730474, -0.152797185, -0.158858143, -0.16491312, -0.170961889,
+    -0.17700422, -0.183039888, -0.189068664, -0.195090322, -0.201104635,
+    -0.207111376, -0.21311032, -0.21910124, -0.225083911, -0.231058108,
+    -0.237023606, -0.24298018, -0.248927606, -0.25486566, -0.260794118,
+    -0.266712757, -0.272621355, -0.278519689, -0.284407537, -0.290284677,
+    -0.296150888, -0.302005949, -0.30784964, -0.31368174, -0.319502031,
+    -0.325310292, -0.331106306, -0.336889853, -0.342660717, -0.34841868,
+    -0.354163525, -0.359895037, -0.365612998, -0.371317194, -0.37700741,
+    -0.382683432, -0.388345047, -0.39399204, -0.3996242, -0.405241314,
+    -0.410843171, -0.41642956, -0.422000271, -0.427555093, -0.433093819,
+    -0.438616239, -0.444122145, -0.44961133, -0.455083587, -0.460538711,
+    -0.465976496, -0.471396737, -0.47679923, -0.482183772, -0.48755016,
+    -0.492898192, -0.498227667, -0.503538384, -0.508830143, -0.514102744,
+    -0.51935599, -0.524589683, -0.529803625, -0.53499762, -0.540171473,
+    -0.545324988, -0.550457973, -0.555570233, -0.560661576, -0.565731811,
+    -0.570780746, -0.575808191, -0.580813958, -0.585797857, -0.590759702,
+    -0.595699304, -0.600616479, -0.605511041, -0.610382806, -0.615231591,
+    -0.620057212, -0.624859488, -0.629638239, -0.634393284, -0.639124445,
+    -0.643831543, -0.648514401, -0.653172843, -0.657806693, -0.662415778,
+    -0.666999922, -0.671558955, -0.676092704, -0.680600998, -0.685083668,
+    -0.689540545, -0.693971461, -0.698376249, -0.702754744, -0.707106781,
+    -0.711432196, -0.715730825, -0.720002508, -0.724247083, -0.72846439,
+    -0.732654272, -0.736816569, -0.740951125, -0.745057785, -0.749136395,
+    -0.753186799, -0.757208847, -0.761202385, -0.765167266, -0.769103338,
+    -0.773010453, -0.776888466, -0.780737229, -0.784556597, -0.788346428,
+    -0.792106577, -0.795836905, -0.799537269, -0.803207531, -0.806847554,
+    -0.810457198, -0.81403633, -0.817584813, -0.821102515, -0.824589303,
+    -0.828045045, -0.831469612, -0.834862875, -0.838224706, -0.841554977,
+    -0.844853565, -0.848120345, -0.851355193, -0.854557988, -0.85772861,
+    -0.860866939, -0.863972856, -0.867046246, -0.870086991, -0.873094978,
+    -0.876070094, -0.879012226, -0.881921264, -0.884797098, -0.88763962,
+    -0.890448723, -0.893224301, -0.89596625, -0.898674466, -0.901348847,
+    -0.903989293, -0.906595705, -0.909167983, -0.911706032, -0.914209756,
+    -0.91667906, -0.919113852, -0.921514039, -0.923879533, -0.926210242,
+    -0.92850608, -0.930766961, -0.932992799, -0.93518351, -0.937339012,
+    -0.939459224, -0.941544065, -0.943593458, -0.945607325, -0.947585591,
+    -0.949528181, -0.951435021, -0.95330604, -0.955141168, -0.956940336,
+    -0.958703475, -0.960430519, -0.962121404, -0.963776066, -0.965394442,
+    -0.966976471, -0.968522094, -0.970031253, -0.971503891, -0.972939952,
+    -0.974339383, -0.97570213, -0.977028143, -0.978317371, -0.979569766,
+    -0.98078528, -0.981963869, -0.983105487, -0.984210092, -0.985277642,
+    -0.986308097, -0.987301418, -0.988257568, -0.98917651, -0.99005821,
+    -0.990902635, -0.991709754, -0.992479535, -0.993211949, -0.99390697,
+    -0.994564571, -0.995184727, -0.995767414, -0.996312612, -0.996820299,
+    -0.997290457, -0.997723067, -0.998118113, -0.998475581, -0.998795456,
+    -0.999077728, -0.999322385, -0.999529418, -0.999698819, -0.999830582,
+    -0.999924702, -0.999981175
+};
+
+static const float fft_sin[FFT_SIZE / 2] = {
+    0, 0.00613588465, 0.0122715383, 0.0184067299, 0.0245412285,
+    0.0306748032, 0.0368072229, 0.0429382569, 0.0490676743, 0.0551952443,
+    0.0613207363, 0.0674439196, 0.0735645636, 0.079682438, 0.0857973123,
+    0.0919089565, 0.0980171403, 0.104121634, 0.110222207, 0.116318631,
+    0.122410675, 0.128498111, 0.134580709, 0.140658239, 0.146730474,
+    0.152797185, 0.158858143, 0.16491312, 0.170961889, 0.17700422,
+    0.183039888, 0.189068664, 0.195090322, 0.201104635, 0.207111376,
+    0.21311032, 0.21910124, 0.225083911, 0.231058108, 0.237023606,
+    0.24298018, 0.248927606, 0.25486566, 0.260794118, 0.266712757,
+    0.272621355, 0.278519689, 0.284407537, 0.290284677, 0.296150888,
+    0.302005949, 0.30784964, 0.31368174, 0.319502031, 0.325310292,
+    0.331106306, 0.336889853, 0.342660717, 0.34841868, 0.354163525,
+    0.359895037, 0.365612998, 0.371317194, 0.37700741, 0.382683432,
+    0.388345047, 0.39399204, 0.3996242, 0.405241314, 0.410843171,
+    0.41642956, 0.422000271, 0.427555093, 0.433093819, 0.438616239,
+    0.444122145, 0.44961133, 0.455083587, 0.460538711, 0.465976496,
+    0.471396737, 0.47679923, 0.482183772, 0.48755016, 0.492898192,
+    0.498227667, 0.503538384, 0.508830143, 0.514102744, 0.51935599,
+    0.524589683, 0.529803625, 0.53499762, 0.540171473, 0.545324988,
+    0.550457973, 0.555570233, 0.560661576, 0.565731811, 0.570780746,
+    0.575808191, 0.580813958, 0.585797857, 0.590759702, 0.595699304,
+    0.600616479, 0.605511041, 0.610382806, 0.615231591, 0.620057212,
+    0.624859488, 0.629638239, 0.634393284, 0.639124445, 0.643831543,
+    0.648514401, 0.653172843, 0.657806693, 0.662415778, 0.666999922,
+    0.671558955, 0.676092704, 0.680600998, 0.685083668, 0.689540545,
+    0.693971461, 0.698376249, 0.702754744, 0.707106781, 0.711432196,
+    0.715730825, 0.720002508, 0.724247083, 0.72846439, 0.732654272,
+    0.736816569, 0.740951125, 0.745057785, 0.749136395, 0.753186799,
+    0.757208847, 0.761202385, 0.765167266, 0.769103338, 0.773010453,
+    0.776888466, 0.780737229, 0.784556597, 0.788346428, 0.792106577,
+    0.795836905, 0.799537269, 0.803207531, 0.806847554, 0.810457198,
+    0.81403633, 0.817584813, 0.821102515, 0.824589303, 0.828045045,
+    0.831469612, 0.834862875, 0.838224706, 0.841554977, 0.844853565,
+    0.848120345, 0.851355193, 0.854557988, 0.85772861, 0.860866939,
+    0.863972856, 0.867046246, 0.870086991, 0.873094978, 0.876070094,
+    0.879012226, 0.881921264, 0.884797098, 0.88763962, 0.890448723,
+    0.893224301, 0.89596625, 0.898674466, 0.901348847, 0.903989293,
+    0.906595705, 0.909167983, 0.911706032, 0.914209756, 0.91667906,
+    0.919113852, 0.921514039, 0.923879533, 0.926210242, 0.92850608,
+    0.930766961, 0.932992799, 0.93518351, 0.937339012, 0.939459224,
+    0.941544065, 0.943593458, 0.945607325, 0.947585591, 0.949528181,
+    0.951435021, 0.95330604, 0.955141168, 0.956940336, 0.958703475,
+    0.960430519, 0.962121404, 0.963776066, 0.965394442, 0.966976471,
+    0.968522094, 0.970031253, 0.971503891, 0.972939952, 0.974339383,
+    0.97570213, 0.977028143, 0.978317371, 0.979569766, 0.98078528,
+    0.981963869, 0.983105487, 0.984210092, 0.985277642, 0.986308097,
+    0.987301418, 0.988257568, 0.98917651, 0.99005821, 0.990902635,
+    0.991709754, 0.992479535, 0.993211949, 0.99390697, 0.994564571,
+    0.995184727, 0.995767414, 0.996312612, 0.996820299, 0.997290457,
+    0.997723067, 0.998118113, 0.998475581, 0.998795456, 0.999077728,
+    0.999322385, 0.999529418, 0.999698819, 0.999830582, 0.999924702,
+    0.999981175, 1, 0.999981175, 0.999924702, 0.999830582,
+    0.999698819, 0.999529418, 0.999322385, 0.999077728, 0.998795456,
+    0.998475581, 0.998118113, 0.997723067, 0.997290457, 0.996820299,
+    0.996312612, 0.995767414, 0.995184727, 0.994564571, 0.99390697,
+    0.993211949, 0.992479535, 0.991709754, 0.990902635, 0.99005821,
+    0.98917651, 0.988257568, 0.987301418, 0.986308097, 0.985277642,
+    0.984210092, 0.983105487, 0.981963869, 0.98078528, 0.979569766,
+    0.978317371, 0.977028143, 0.97570213, 0.974339383, 0.972939952,
+    0.971503891, 0.970031253, 0.968522094, 0.966976471, 0.965394442,
+    0.963776066, 0.962121404, 0.960430519, 0.958703475, 0.956940336,
+    0.955141168, 0.95330604, 0.951435021, 0.949528181, 0.947585591,
+    0.945607325, 0.943593458, 0.941544065, 0.939459224, 0.937339012,
+    0.93518351, 0.932992799, 0.930766961, 0.92850608, 0.926210242,
+    0.923879533, 0.921514039, 0.919113852, 0.91667906, 0.914209756,
+    0.911706032, 0.909167983, 0.906595705, 0.903989293, 0.901348847,
+    0.898674466, 0.89596625, 0.893224301, 0.890448723, 0.88763962,
+    0.884797098, 0.881921264, 0.879012226, 0.876070094, 0.873094978,
+    0.870086991, 0.867046246, 0.863972856, 0.860866939, 0.85772861,
+    0.854557988, 0.851355193, 0.848120345, 0.844853565, 0.841554977,
+    0.838224706, 0.834862875, 0.831469612, 0.828045045, 0.824589303,
+    0.821102515, 0.817584813, 0.81403633, 0.810457198, 0.806847554,
+    0.803207531, 0.799537269, 0.795836905, 0.792106577, 0.788346428,
+    0.784556597, 0.780737229, 0.776888466, 0.773010453, 0.769103338,
+    0.765167266, 0.761202385, 0.757208847, 0.753186799, 0.749136395,
+    0.745057785, 0.740951125, 0.736816569, 0.732654272, 0.72846439,
+    0.724247083, 0.720002508, 0.715730825, 0.711432196, 0.707106781,
+    0.702754744, 0.698376249, 0.693971461, 0.689540545, 0.685083668,
+    0.680600998, 0.676092704, 0.671558955, 0.666999922, 0.662415778,
+    0.657806693, 0.653172843, 0.648514401, 0.643831543, 0.639124445,
+    0.634393284, 0.629638239, 0.624859488, 0.620057212, 0.615231591,
+    0.610382806, 0.605511041, 0.600616479, 0.595699304, 0.590759702,
+    0.585797857, 0.580813958, 0.575808191, 0.570780746, 0.565731811,
+    0.560661576, 0.555570233, 0.550457973, 0.545324988, 0.540171473,
+    0.53499762, 0.529803625, 0.524589683, 0.51935599, 0.514102744,
+    0.508830143, 0.503538384, 0.498227667, 0.492898192, 0.48755016,
+    0.482183772, 0.47679923, 0.471396737, 0.465976496, 0.460538711,
+    0.455083587, 0.44961133, 0.444122145, 0.438616239, 0.433093819,
+    0.427555093, 0.422000271, 0.41642956, 0.410843171, 0.405241314,
+    0.3996242, 0.39399204, 0.388345047, 0.382683432, 0.37700741,
+    0.371317194, 0.365612998, 0.359895037, 0.354163525, 0.34841868,
+    0.342660717, 0.336889853, 0.331106306, 0.325310292, 0.319502031,
+    0.31368174, 0.30784964, 0.302005949, 0.296150888, 0.290284677,
+    0.284407537, 0.278519689, 0.272621355, 0.266712757, 0.260794118,
+    0.25486566, 0.248927606, 0.24298018, 0.237023606, 0.231058108,
+    0.225083911, 0.21910124, 0.21311032, 0.207111376, 0.201104635,
+    0.195090322, 0.189068664, 0.183039888, 0.17700422, 0.170961889,
+    0.16491312, 0.158858143, 0.152797185, 0.146730474, 0.140658239,
+    0.134580709, 0.128498111, 0.122410675, 0.116318631, 0.110222207,
+    0.104121634, 0.0980171403, 0.0919089565, 0.0857973123, 0.079682438,
+    0.0735645636, 0.0674439196, 0.0613207363, 0.0551952443, 0.0490676743,
+    0.0429382569, 0.0368072229, 0.0306748032, 0.0245412285, 0.0184067299,
+    0.0122715383, 0.00613588465
+};
+
+// Hann window
+static const float fft_window[FFT_SIZE] = {
+    0, 9.4123587e-06, 3.76490804e-05, 8.47091021e-05, 0.000150590652,
+    0.000235291249, 0.000338807706, 0.000461136124, 0.000602271897, 0.000762209713,
+    0.00094094355, 0.00113846668, 0.00135477166, 0.00158985035, 0.00184369391,
+    0.00211629277, 0.00240763666, 0.00271771463, 0.003046515, 0.00339402538,
+    0.0037602327, 0.00414512317, 0.00454868229, 0.00497089487, 0.00541174502,
+    0.00587121613, 0.00634929092, 0.00684595138, 0.00736117881, 0.00789495381,
+    0.00844725628, 0.00901806545, 0.0096073598, 0.0102151172, 0.0108413146,
+    0.0114859287, 0.012148935, 0.0128303086, 0.0135300239, 0.0142480545,
+    0.0149843734, 0.0157389529, 0.0165117645, 0.0173027792, 0.0181119671,
+    0.0189392979, 0.0197847403, 0.0206482626, 0.0215298321, 0.0224294158,
+    0.0233469798, 0.0242824895, 0.0252359097, 0.0262072045, 0.0271963373,
+    0.0282032709, 0.0292279674, 0.0302703882, 0.031330494, 0.032408245,
+    0.0335036006, 0.0346165195, 0.0357469598, 0.0368948789, 0.0380602337,
+    0.0392429803, 0.0404430742, 0.04166047, 0.0428951221, 0.044146984,
+    0.0454160085, 0.0467021477, 0.0480053534, 0.0493255765, 0.0506627672,
+    0.0520168751, 0.0533878494, 0.0547756384, 0.0561801898, 0.0576014508,
+    0.0590393678, 0.0604938868, 0.0619649529, 0.0634525108, 0.0649565044,
+    0.0664768772, 0.0680135719, 0.0695665307, 0.071135695, 0.0727210058,
+    0.0743224034, 0.0759398276, 0.0775732174, 0.0792225113, 0.0808876472,
+    0.0825685625, 0.0842651938, 0.0859774774, 0.0877053486, 0.0894487425,
+    0.0912075934, 0.0929818351, 0.0947714009, 0.0965762232, 0.0983962343,
+    0.100231365, 0.102081548, 0.103946711, 0.105826786, 0.107721701,
+    0.109631386, 0.111555767, 0.113494773, 0.115448331, 0.117416367,
+    0.119398807, 0.121395577, 0.1234066, 0.125431803, 0.127471107,
+    0.129524437, 0.131591716, 0.133672864, 0.135767805, 0.137876459,
+    0.139998746, 0.142134587, 0.144283902, 0.146446609, 0.148622628,
+    0.150811875, 0.15301427, 0.155229728, 0.157458166, 0.159699501,
+    0.161953648, 0.164220523, 0.166500039, 0.168792111, 0.171096653,
+    0.173413579, 0.175742799, 0.178084229, 0.180437778, 0.182803358,
+    0.185180881, 0.187570256, 0.189971394, 0.192384205, 0.194808597,
+    0.197244479, 0.19969176, 0.202150348, 0.204620149, 0.207101071,
+    0.209593021, 0.212095904, 0.214609627, 0.217134095, 0.219669212,
+    0.222214883, 0.224771014, 0.227337506, 0.229914264, 0.23250119,
+    0.235098188, 0.237705159, 0.240322005, 0.242948628, 0.245584929,
+    0.248230808, 0.250886167, 0.253550904, 0.25622492, 0.258908114,
+    0.261600385, 0.264301632, 0.267011752, 0.269730645, 0.272458206,
+    0.275194335, 0.277938928, 0.280691881, 0.283453091, 0.286222453,
+    0.288999865, 0.29178522, 0.294578414, 0.297379343, 0.3001879,
+    0.30300398, 0.305827477, 0.308658284, 0.311496295, 0.314341403,
+    0.317193501, 0.320052482, 0.322918237, 0.32579066, 0.328669641,
+    0.331555073, 0.334446847, 0.337344854, 0.340248985, 0.34315913,
+    0.34607518, 0.348997025, 0.351924556, 0.354857661, 0.357796231,
+    0.360740155, 0.363689322, 0.366643621, 0.369602941, 0.37256717,
+    0.375536197, 0.37850991, 0.381488197, 0.384470946, 0.387458044,
+    0.39044938, 0.39344484, 0.396444312, 0.399447683, 0.402454839,
+    0.405465668, 0.408480056, 0.41149789, 0.414519056, 0.41754344,
+    0.420570928, 0.423601407, 0.426634763, 0.42967088, 0.432709646,
+    0.435750945, 0.438794662, 0.441840685, 0.444888896, 0.447939183,
+    0.45099143, 0.454045522, 0.457101344, 0.460158781, 0.463217718,
+    0.46627804, 0.469339632, 0.472402378, 0.475466163, 0.478530872,
+    0.481596389, 0.484662598, 0.487729386, 0.490796635, 0.493864231,
+    0.496932058, 0.5, 0.503067942, 0.506135769, 0.509203365,
+    0.512270614, 0.515337402, 0.518403611, 0.521469128, 0.524533837,
+    0.527597622, 0.530660368, 0.53372196, 0.536782282, 0.539841219,
+    0.542898656, 0.545954478, 0.54900857, 0.552060817, 0.555111104,
+    0.558159315, 0.561205338, 0.564249055, 0.567290354, 0.57032912,
+    0.573365237, 0.576398593, 0.579429072, 0.58245656, 0.585480944,
+    0.58850211, 0.591519944, 0.594534332, 0.597545161, 0.600552317,
+    0.603555688, 0.60655516, 0.60955062, 0.612541956, 0.615529054,
+    0.618511803, 0.62149009, 0.624463803, 0.62743283, 0.630397059,
+    0.633356379, 0.636310678, 0.639259845, 0.642203769, 0.645142339,
+    0.648075444, 0.651002975, 0.65392482, 0.65684087, 0.659751015,
+    0.662655146, 0.665553153, 0.668444927, 0.671330359, 0.67420934,
+    0.677081763, 0.679947518, 0.682806499, 0.685658597, 0.688503705,
+    0.691341716, 0.694172523, 0.69699602, 0.6998121, 0.702620657,
+    0.705421586, 0.70821478, 0.711000135, 0.713777547, 0.716546909,
+    0.719308119, 0.722061072, 0.724805665, 0.727541794, 0.730269355,
+    0.732988248, 0.735698368, 0.738399615, 0.741091886, 0.74377508,
+    0.746449096, 0.749113833, 0.751769192, 0.754415071, 0.757051372,
+    0.759677995, 0.762294841, 0.764901812, 0.76749881, 0.770085736,
+    0.772662494, 0.775228986, 0.777785117, 0.780330788, 0.782865905,
+    0.785390373, 0.787904096, 0.790406979, 0.792898929, 0.795379851,
+    0.797849652, 0.80030824, 0.802755521, 0.805191403, 0.807615795,
+    0.810028606, 0.812429744, 0.814819119, 0.817196642, 0.819562222,
+    0.821915771, 0.824257201, 0.826586421, 0.828903347, 0.831207889,
+    0.833499961, 0.835779477, 0.838046352, 0.840300499, 0.842541834,
+    0.844770272, 0.84698573, 0.849188125, 0.851377372, 0.853553391,
+    0.855716098, 0.857865413, 0.860001254, 0.862123541, 0.864232195,
+    0.866327136, 0.868408284, 0.870475563, 0.872528893, 0.874568197,
+    0.8765934, 0.878604423, 0.880601193, 0.882583633, 0.884551669,
+    0.886505227, 0.888444233, 0.890368614, 0.892278299, 0.894173214,
+    0.896053289, 0.897918452, 0.899768635, 0.901603766, 0.903423777,
+    0.905228599, 0.907018165, 0.908792407, 0.910551257, 0.912294651,
+    0.914022523, 0.915734806, 0.917431437, 0.919112353, 0.920777489,
+    0.922426783, 0.924060172, 0.925677597, 0.927278994, 0.928864305,
+    0.930433469, 0.931986428, 0.933523123, 0.935043496, 0.936547489,
+    0.938035047, 0.939506113, 0.940960632, 0.942398549, 0.94381981,
+    0.945224362, 0.946612151, 0.947983125, 0.949337233, 0.950674424,
+    0.951994647, 0.953297852, 0.954583992, 0.955853016, 0.957104878,
+    0.95833953, 0.959556926, 0.96075702, 0.961939766, 0.963105121,
+    0.96425304, 0.965383481, 0.966496399, 0.967591755, 0.968669506,
+    0.969729612, 0.970772033, 0.971796729, 0.972803663, 0.973792796,
+    0.97476409, 0.97571751, 0.97665302, 0.977570584, 0.978470168,
+    0.979351737, 0.98021526, 0.981060702, 0.981888033, 0.982697221,
+    0.983488236, 0.984261047, 0.985015627, 0.985751945, 0.986469976,
+    0.987169691, 0.987851065, 0.988514071, 0.989158685, 0.989784883,
+    0.99039264, 0.990981935, 0.991552744, 0.992105046, 0.992638821,
+    0.993154049, 0.993650709, 0.994128784, 0.994588255, 0.995029105,
+    0.995451318, 0.995854877, 0.996239767, 0.996605975, 0.996953485,
+    0.997282285, 0.997592363, 0.997883707, 0.998156306, 0.99841015,
+    0.998645228, 0.998861533, 0.999059056, 0.99923779, 0.999397728,
+    0.999538864, 0.999661192, 0.999764709, 0.999849409, 0.999915291,
+    0.999962351, 0.999990588, 1, 0.999990588, 0.999962351,
+    0.999915291, 0.999849409, 0.999764709, 0.999661192, 0.999538864,
+    0.999397728, 0.99923779, 0.999059056, 0.998861533, 0.998645228,
+    0.99841015, 0.998156306, 0.997883707, 0.997592363, 0.997282285,
+    0.996953485, 0.996605975, 0.996239767, 0.995854877, 0.995451318,
+    0.995029105, 0.994588255, 0.994128784, 0.993650709, 0.993154049,
+    0.992638821, 0.992105046, 0.991552744, 0.990981935, 0.99039264,
+    0.989784883, 0.989158685, 0.988514071, 0.987851065, 0.987169691,
+    0.986469976, 0.985751945, 0.985015627, 0.984261047, 0.983488236,
+    0.982697221, 0.981888033, 0.981060702, 0.98021526, 0.979351737,
+    0.978470168, 0.977570584, 0.97665302, 0.97571751, 0.97476409,
+    0.973792796, 0.972803663, 0.971796729, 0.970772033, 0.969729612,
+    0.968669506, 0.967591755, 0.966496399, 0.965383481, 0.96425304,
+    0.963105121, 0.961939766, 0.96075702, 0.959556926, 0.95833953,
+    0.957104878, 0.955853016, 0.954583992, 0.953297852, 0.951994647,
+    0.950674424, 0.949337233, 0.947983125, 0.946612151, 0.945224362,
+    0.94381981, 0.942398549, 0.940960632, 0.939506113, 0.938035047,
+    0.936547489, 0.935043496, 0.933523123, 0.931986428, 0.930433469,
+    0.928864305, 0.927278994, 0.925677597, 0.924060172, 0.922426783,
+    0.920777489, 0.919112353, 0.917431437, 0.915734806, 0.914022523,
+    0.912294651, 0.910551257, 0.908792407, 0.907018165, 0.905228599,
+    0.903423777, 0.901603766, 0.899768635, 0.897918452, 0.896053289,
+    0.894173214, 0.892278299, 0.890368614, 0.888444233, 0.886505227,
+    0.884551669, 0.882583633, 0.880601193, 0.878604423, 0.8765934,
+    0.874568197, 0.872528893, 0.870475563, 0.868408284, 0.866327136,
+    0.864232195, 0.862123541, 0.860001254, 0.857865413, 0.855716098,
+    0.853553391, 0.851377372, 0.849188125, 0.84698573, 0.844770272,
+    0.842541834, 0.840300499, 0.838046352, 0.835779477, 0.833499961,
+    0.831207889, 0.828903347, 0.826586421, 0.824257201, 0.821915771,
+    0.819562222, 0.817196642, 0.814819119, 0.812429744, 0.810028606,
+    0.807615795, 0.805191403, 0.802755521, 0.80030824, 0.797849652,
+    0.795379851, 0.792898929, 0.790406979, 0.787904096, 0.785390373,
+    0.782865905, 0.780330788, 0.777785117, 0.775228986, 0.772662494,
+    0.770085736, 0.76749881, 0.764901812, 0.762294841, 0.759677995,
+    0.757051372, 0.754415071, 0.751769192, 0.749113833, 0.746449096,
+    0.74377508, 0.741091886, 0.738399615, 0.735698368, 0.732988248,
+    0.730269355, 0.727541794, 0.724805665, 0.722061072, 0.719308119,
+    0.716546909, 0.713777547, 0.711000135, 0.70821478, 0.705421586,
+    0.702620657, 0.6998121, 0.69699602, 0.694172523, 0.691341716,
+    0.688503705, 0.685658597, 0.682806499, 0.679947518, 0.677081763,
+    0.67420934, 0.671330359, 0.668444927, 0.665553153, 0.662655146,
+    0.659751015, 0.65684087, 0.65392482, 0.651002975, 0.648075444,
+    0.645142339, 0.642203769, 0.639259845, 0.636310678, 0.633356379,
+    0.630397059, 0.62743283, 0.624463803, 0.62149009, 0.618511803,
+    0.615529054, 0.612541956, 0.60955062, 0.60655516, 0.603555688,
+    0.600552317, 0.597545161, 0.594534332, 0.591519944, 0.58850211,
+    0.585480944, 0.58245656, 0.579429072, 0.576398593, 0.573365237,
+    0.57032912, 0.567290354, 0.564249055, 0.561205338, 0.558159315,
+    0.555111104, 0.552060817, 0.54900857, 0.545954478, 0.542898656,
+    0.539841219, 0.536782282, 0.53372196, 0.530660368, 0.527597622,
+    0.524533837, 0.521469128, 0.518403611, 0.515337402, 0.512270614,
+    0.509203365, 0.506135769, 0.503067942, 0.5, 0.496932058,
+    0.493864231, 0.490796635, 0.487729386, 0.484662598, 0.481596389,
+    0.478530872, 0.475466163, 0.472402378, 0.469339632, 0.46627804,
+    0.463217718, 0.460158781, 0.457101344, 0.454045522, 0.45099143,
+    0.447939183, 0.444888896, 0.441840685, 0.438794662, 0.435750945,
+    0.432709646, 0.42967088, 0.426634763, 0.423601407, 0.420570928,
+    0.41754344, 0.414519056, 0.41149789, 0.408480056, 0.405465668,
+    0.402454839, 0.399447683, 0.396444312, 0.39344484, 0.39044938,
+    0.387458044, 0.384470946, 0.381488197, 0.37850991, 0.375536197,
+    0.37256717, 0.369602941, 0.366643621, 0.363689322, 0.360740155,
+    0.357796231, 0.354857661, 0.351924556, 0.348997025, 0.34607518,
+    0.34315913, 0.340248985, 0.337344854, 0.334446847, 0.331555073,
+    0.328669641, 0.32579066, 0.322918237, 0.320052482, 0.317193501,
+    0.314341403, 0.311496295, 0.308658284, 0.305827477, 0.30300398,
+    0.3001879, 0.297379343, 0.294578414, 0.29178522, 0.288999865,
+    0.286222453, 0.283453091, 0.280691881, 0.277938928, 0.275194335,
+    0.272458206, 0.269730645, 0.267011752, 0.264301632, 0.261600385,
+    0.258908114, 0.25622492, 0.253550904, 0.250886167, 0.248230808,
+    0.245584929, 0.242948628, 0.240322005, 0.237705159, 0.235098188,
+    0.23250119, 0.229914264, 0.227337506, 0.224771014, 0.222214883,
+    0.219669212, 0.217134095, 0.214609627, 0.212095904, 0.209593021,
+    0.207101071, 0.204620149, 0.202150348, 0.19969176, 0.197244479,
+    0.194808597, 0.192384205, 0.189971394, 0.187570256, 0.185180881,
+    0.182803358, 0.180437778, 0.178084229, 0.175742799, 0.173413579,
+    0.171096653, 0.168792111, 0.166500039, 0.164220523, 0.161953648,
+    0.159699501, 0.157458166, 0.155229728, 0.15301427, 0.150811875,
+    0.148622628, 0.146446609, 0.144283902, 0.142134587, 0.139998746,
+    0.137876459, 0.135767805, 0.133672864, 0.131591716, 0.129524437,
+    0.127471107, 0.125431803, 0.1234066, 0.121395577, 0.119398807,
+    0.117416367, 0.115448331, 0.113494773, 0.111555767, 0.109631386,
+    0.107721701, 0.105826786, 0.103946711, 0.102081548, 0.100231365,
+    0.0983962343, 0.0965762232, 0.0947714009, 0.0929818351, 0.0912075934,
+    0.0894487425, 0.0877053486, 0.0859774774, 0.0842651938, 0.0825685625,
+    0.0808876472, 0.0792225113, 0.0775732174, 0.0759398276, 0.0743224034,
+    0.0727210058, 0.071135695, 0.0695665307, 0.0680135719, 0.0664768772,
+    0.0649565044, 0.0634525108, 0.0619649529, 0.0604938868, 0.0590393678,
+    0.0576014508, 0.0561801898, 0.0547756384, 0.0533878494, 0.0520168751,
+    0.0506627672, 0.0493255765, 0.0480053534, 0.0467021477, 0.0454160085,
+    0.044146984, 0.0428951221, 0.04166047, 0.0404430742, 0.0392429803,
+    0.0380602337, 0.0368948789, 0.0357469598, 0.0346165195, 0.0335036006,
+    0.032408245, 0.031330494, 0.0302703882, 0.0292279674, 0.0282032709,
+    0.0271963373, 0.0262072045, 0.0252359097, 0.0242824895, 0.0233469798,
+    0.0224294158, 0.0215298321, 0.0206482626, 0.0197847403, 0.0189392979,
+    0.0181119671, 0.0173027792, 0.0165117645, 0.0157389529, 0.0149843734,
+    0.0142480545, 0.0135300239, 0.0128303086, 0.012148935, 0.0114859287,
+    0.0108413146, 0.0102151172, 0.0096073598, 0.00901806545, 0.00844725628,
+    0.00789495381, 0.00736117881, 0.00684595138, 0.00634929092, 0.00587121613,
+    0.00541174502, 0.00497089487, 0.00454868229, 0.00414512317, 0.0037602327,
+    0.00339402538, 0.003046515, 0.00271771463, 0.00240763666, 0.00211629277,
+    0.00184369391, 0.00158985035, 0.00135477166, 0.00113846668, 0.00094094355,
+    0.000762209713, 0.000602271897, 0.000461136124, 0.000338807706, 0.000235291249,
+    0.000150590652, 8.47091021e-05, 3.76490804e-05, 9.4123587e-06
+};
+
+#endif
@@ -0,0 +1,83 @@
+/*! @file fft_tables.c
+ * @brief Generates dsp/fft_tables.h (`make fft_tables`)
+ *
+ * @details Prints the bit reversal permutation of the half-size complex transform, the twiddle
+ * factors and the Hann window for FFT_SIZE samples, so that none of them are computed at runtime.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "../fft.h"
+
+// Values per line, keeping lines within 100 columns
+#define INTS_PER_LINE 12
+#define FLOATS_PER_LINE 5
+
+/**
+ * @brief Separator before the k-th value of an initializer
+ */
+static const char* separator(int k, int per_line) {
+  return k == 0 ? "\n    " : k % per_line ? ", " : ",\n    ";
+}
+
+static void print_floats(const char* name, const char* size, double (*f)(int), int n) {
+  printf("static const float %s[%s] = {", name, size);
+  for (int k = 0; k < n; k++)
+    printf("%s%.9g", separator(k, FLOATS_PER_LINE), f(k));
+  printf("\n};\n\n");
+}
+
+static double twiddle_cos(int k) {
+  return cos(2 * M_PI * k / FFT_SIZE);
+}
+
+static double twiddle_sin(int k) {
+  return sin(2 * M_PI * k / FFT_SIZE);
+}
+
+static double hann(int k) {
+  return 0.5 - 0.5 * cos(2 * M_PI * k / FFT_SIZE);
+}
+
+int main() {
+  const int half = FFT_SIZE / 2;
+  int bits = 0, rev;
+  double power = 0;
+
+  while ((1 << bits) < half)
+    bits++;
+
+  for (int k = 0; k < FFT_SIZE; k++)
+    power += hann(k) * hann(k);
+
+  printf("/*! @file fft_tables.h\n");
+  printf(" * @brief FFT tables for %d samples, generated by dsp/gen/fft_tables.c (do not edit)\n",
+         FFT_SIZE);
+  printf(" */\n\n");
+  printf("#ifndef DSP_FFT_TABLES_H\n#define DSP_FFT_TABLES_H\n\n");
+  printf("#include <stdint.h>\n\n");
+  printf("#define FFT_TABLES_SIZE %d\n", FFT_SIZE);
+  printf("/// Sum of the squared window coefficients\n");
+  printf("#define FFT_WINDOW_POWER %.9g\n\n", power);
+
+  printf("// Bit reversal permutation of the %d-point complex transform\n", half);
+  printf("static const uint16_t fft_bitrev[FFT_SIZE / 2] = {");
+  for (int k = 0; k < half; k++) {
+    rev = 0;
+    for (int b = 0; b < bits; b++)
+      rev |= ((k >> b) & 1) << (bits - 1 - b);
+    printf("%s%d", separator(k, INTS_PER_LINE), rev);
+  }
+  printf("\n};\n\n");
+
+  printf("// cos/sin(2 * pi * k / FFT_SIZE)\n");
+  print_floats("fft_cos", "FFT_SIZE / 2", twiddle_cos, half);
+  print_floats("fft_sin", "FFT_SIZE / 2", twiddle_sin, half);
+
+  printf("// Hann window\n");
+  print_floats("fft_window", "FFT_SIZE", hann, FFT_SIZE);
+
+  printf("#endif\n");
+  return 0;
+}
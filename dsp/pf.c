@@ -0,0 +1,117 @@
+/*! @file pf.c
+ * @brief Per-cycle displacement power factor engine
+ */
+
+#include "pf.h"
+
+#include <math.h>
+
+void pf_reference_update(struct pf_reference* ref, uint64_t crossing) {
+  uint64_t elapsed = crossing - ref->crossing;
+  double known = ref->period > 0 ? ref->period : ref->nominal;
+  int64_t cycles = 1;
+  double period = elapsed;
+
+  // Crossings may be missed, so whole cycles are counted in between. While track is lost, they
+  // are counted at the latest accepted period, so that outlets' cycles stay in step on resync
+  if (ref->crossing && known > 0) {
+    cycles = llround(elapsed / known);
+
+    // Spurious edge within a cycle
+    if (cycles == 0)
+      return;
+    period = (double)elapsed / cycles;
+  }
+
+  if (ref->crossing && period >= PF_PERIOD_MIN_NS && period <= PF_PERIOD_MAX_NS) {
+    ref->period = ref->nominal = period;
+    ref->cycle += cycles;
+  } else if (ref->crossing) {
+    // Lost track (e.g. after a gap): start over from this crossing
+    ref->period = 0;
+    ref->cycle += cycles;
+  }
+
+  ref->crossing = crossing;
+}
+
+void pf_outlet_init(struct pf_outlet* o, float min_rms) {
+  *o = (struct pf_outlet){.min_rms = min_rms, .last = 1};
+}
+
+/**
+ * @brief Closes the accumulated cycle
+ * @retval 1 The cycle's power factor was kept
+ * @retval 0 Not enough samples, or too little current
+ */
+static int8_t pf_complete(struct pf_outlet* o) {
+  double mean, a, b, magnitude;
+
+  if (o->samples < PF_MIN_SAMPLES)
+    return 0;
+
+  // Projections on the voltage (sine) and its quadrature (cosine), without the cycle's mean
+  mean = o->sum / o->samples;
+  a = o->sum_i_cos - mean * o->sum_cos;
+  b = o->sum_i_sin - mean * o->sum_sin;
+  magnitude = sqrt(a * a + b * b);
+
+  // The fundamental's RMS value is sqrt(2) * magnitude / samples
+  if (M_SQRT2 * magnitude / o->samples < o->min_rms)
+    return 0;
+
+  o->last = b / magnitude;
+
+  // Rolling sum: the oldest cycle leaves as the newest one comes in
+  if (o->history_len == PF_ROLLING_CYCLES)
+    o->history_sum -= o->history[o->history_pos];
+  o->history_sum += o->last;
+  o->history[o->history_pos] = o->last;
+  o->history_pos = (o->history_pos + 1) % PF_ROLLING_CYCLES;
+  if (o->history_len < PF_ROLLING_CYCLES)
+    o->history_len++;
+
+  return 1;
+}
+
+int8_t pf_add(struct pf_outlet* o,
+              const struct pf_reference* ref,
+              uint64_t timestamp,
+              float current) {
+  double offset, position, phase;
+  int64_t cycle;
+  int8_t rslt = 0;
+
+  if (ref->period <= 0)
+    return -1;
+
+  // Position in cycles relative to the reference crossing (negative for earlier samples)
+  offset = (double)(int64_t)(timestamp - ref->crossing);
+  position = floor(offset / ref->period);
+  cycle = ref->cycle + (int64_t)position;
+
+  // A sample right at a boundary may land a cycle back as the reference moves; it stays put
+  if (cycle < o->cycle)
+    cycle = o->cycle;
+  phase = 2 * M_PI * (offset / ref->period - position);
+
+  if (cycle > o->cycle) {
+    rslt = pf_complete(o);
+    o->cycle = cycle;
+    o->samples = 0;
+    o->sum = o->sum_cos = o->sum_sin = o->sum_i_cos = o->sum_i_sin = 0;
+  }
+
+  o->samples++;
+  o->sum += current;
+  o->sum_cos += cos(phase);
+  o->sum_sin += sin(phase);
+  o->sum_i_cos += current * cos(phase);
+  o->sum_i_sin += current * sin(phase);
+
+  return rslt;
+}
+
+double pf_rolling(const struct pf_outlet* o) {
+  return o->history_len ? o->history_sum / o->history_len : 1;
+}
@@ -0,0 +1,97 @@
+/*! @file pf.h
+ * @brief Declarations for the per-cycle displacement power factor engine
+ */
+
+#ifndef DSP_PF_H
+#define DSP_PF_H
+
+#include <stdint.h>
+
+/// Cycles in the rolling average
+#define PF_ROLLING_CYCLES 60
+/// Fewest samples a cycle needs for its power factor to count
+#define PF_MIN_SAMPLES 6
+/// Accepted line period range, in ns (45 to 65 Hz)
+#define PF_PERIOD_MIN_NS 15384615
+#define PF_PERIOD_MAX_NS 22222222
+
+/*!
+ * @brief Voltage phase reference, from the line's rising zero crossings
+ */
+struct pf_reference {
+  uint64_t crossing;  ///< Latest rising zero crossing (CLOCK_MONOTONIC, in ns)
+  int64_t cycle;      ///< Cycles elapsed up to `crossing`
+  double period;      ///< Line period, in ns (0 until known, or while track is lost)
+  double nominal;     ///< Latest accepted period, in ns, kept to count cycles while track is lost
+};
+
+/*!
+ * @brief Power factor state of one outlet
+ */
+struct pf_outlet {
+  float min_rms;  ///< Cycles with a weaker fundamental are left out, in A
+
+  /// Sums over the cycle being accumulated (sample, cosine, sine and their products)
+  int64_t cycle;
+  uint32_t samples;
+  double sum, sum_cos, sum_sin, sum_i_cos, sum_i_sin;
+
+  double last;  ///< Power factor of the latest complete cycle
+  double history[PF_ROLLING_CYCLES];
+  double history_sum;
+  uint32_t history_len;
+  uint32_t history_pos;
+};
+
+/**
+ * \ingroup dsp
+ * \defgroup dspPf Power factor
+ * @brief Displacement power factor per line cycle, from timestamped current samples and the
+ * voltage zero crossings
+ *
+ * @details Each sample's phase is its position relative to the latest known zero crossing, so
+ * crossings may arrive later than the samples they apply to. Every cycle, the current's
+ * fundamental is projected on the voltage (a single DFT bin, with the cycle's mean removed),
+ * and its cosine goes into a rolling average. Work is constant per sample and per cycle.
+ */
+
+/**
+ * \ingroup dspPf
+ * @brief Feeds a rising zero crossing of the line voltage
+ * @param[in, out] ref Reference
+ * @param[in] crossing Crossing time (CLOCK_MONOTONIC, in ns), after the previous ones
+ */
+void pf_reference_update(struct pf_reference* ref, uint64_t crossing);
+
+/**
+ * \ingroup dspPf
+ * @brief Initializes an outlet's state
+ * @param[out] o Outlet
+ * @param[in] min_rms Weakest fundamental (RMS, in A) whose cycles are kept
+ */
+void pf_outlet_init(struct pf_outlet* o, float min_rms);
+
+/**
+ * \ingroup dspPf
+ * @brief Adds a current sample, completing the previous cycle when the sample starts a new one
+ * @param[in, out] o Outlet
+ * @param[in] ref Voltage reference
+ * @param[in] timestamp Sample time (CLOCK_MONOTONIC, in ns)
+ * @param[in] current Instantaneous current, in A
+ * @retval 1 A cycle was completed (`o->last` was updated)
+ * @retval 0 Sample accumulated
+ * @retval -1 No reference yet, sample ignored
+ */
+int8_t pf_add(struct pf_outlet* o,
+              const struct pf_reference* ref,
+              uint64_t timestamp,
+              float current);
+
+/**
+ * \ingroup dspPf
+ * @brief Rolling average over the latest PF_ROLLING_CYCLES cycles
+ * @returns Power factor (1 without any complete cycle)
+ */
+double pf_rolling(const struct pf_outlet* o);
+
+#endif
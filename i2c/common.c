@@ -4,13 +4,13 @@
 
 #include <fcntl.h>
 #include <linux/i2c-dev.h>
-#include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <syslog.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "../sim/common.h"
 #include "common.h"
 
 gpio_t mux0 = {.pin = P9_15};  // LSB
@@ -18,9 +18,19 @@ gpio_t mux1 = {.pin = P9_16};  // MSB
 
 int8_t pins_configured = 0;
 
+// Shared I2C bus file descriptor (-1 until the first i2c_open() call)
+static int bus_fd = -1;
+
 uint8_t ext_addr = -1;
 
+// Currently selected channels (-1 if unknown)
+int8_t mux_state = -1;
+int8_t ext_mux_state = -1;
+
 void direct_mux(uint8_t id) {
+  if (mux_state == id)
+    return;
+
   if ((id >> 0) & 1)
     mmio_set_high(mux0);
   else
@@ -30,18 +40,22 @@ void direct_mux(uint8_t id) {
     mmio_set_high(mux1);
   else
     mmio_set_low(mux1);
+
+  mux_state = id;
 }
 
 void direct_ext_mux(uint8_t id) {
-  char* rx;
-  rx = malloc(1 * sizeof(char));
+  if (ext_mux_state == id)
+    return;
 
   char ext_mux_id[1] = {id};
+  char rx[1];
 
-  select_module(ext_addr, 2);
-  spi_transfer(ext_mux_id, rx, 1);
-
-  free(rx);
+  // The extender's channel is unknown after a failed transfer
+  if (select_module(ext_addr, 2) < 0 || spi_transfer(ext_mux_id, rx, 1) < 0)
+    ext_mux_state = -1;
+  else
+    ext_mux_state = id;
 }
 
 int8_t set_ext_addr(uint8_t addr) {
@@ -51,53 +65,108 @@ int8_t set_ext_addr(uint8_t addr) {
   return 0;
 }
 
+void i2c_txn_init(struct i2c_txn* txn) {
+  txn->count = 0;
+}
+
+/**
+ * @brief Queues a message
+ * @retval 0 Queued
+ * @retval -1 Transaction is full
+ */
+static int8_t txn_add(struct i2c_txn* txn,
+                      uint8_t addr,
+                      uint16_t flags,
+                      uint8_t* buf,
+                      uint16_t len) {
+  if (txn->count == I2C_TXN_MAX_MSGS)
+    return -1;
+
+  txn->msgs[txn->count++] = (struct i2c_msg){.addr = addr, .flags = flags, .len = len, .buf = buf};
+  return 0;
+}
+
+int8_t i2c_txn_write(struct i2c_txn* txn, uint8_t addr, const uint8_t* buf, uint16_t len) {
+  // The kernel never writes to the buffers of write messages
+  return txn_add(txn, addr, 0, (uint8_t*)buf, len);
+}
+
+int8_t i2c_txn_read(struct i2c_txn* txn, uint8_t addr, uint8_t* buf, uint16_t len) {
+  return txn_add(txn, addr, I2C_M_RD, buf, len);
+}
+
+int8_t i2c_txn_submit(struct i2c_txn* txn) {
+  struct i2c_rdwr_ioctl_data data = {.msgs = txn->msgs, .nmsgs = txn->count};
+
+  if (txn->count == 0)
+    return 0;
+
+  if (hal_ioctl(bus_fd, I2C_RDWR, &data) != txn->count) {
+    // The failure may come from a wrong channel, which is then selected again on the next switch
+    invalidate_mux();
+    return -1;
+  }
+
+  return 0;
+}
+
 int8_t i2c_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t length, void* intf_ptr) {
-  struct identifier id;
-  id = *((struct identifier*)intf_ptr);
+  const struct identifier* id = intf_ptr;
+  struct i2c_txn txn;
+
+  i2c_txn_init(&txn);
 
+  // Sensirion reads carry no register address, their command is written beforehand
   if (reg_addr != 0)
-    write(id.fd, &reg_addr, 1);
+    i2c_txn_write(&txn, id->addr, &reg_addr, 1);
+  i2c_txn_read(&txn, id->addr, reg_data, length);
 
-  return read(id.fd, reg_data, length) < 0 ? -1 : 0;
+  return i2c_txn_submit(&txn);
 }
 
 int8_t i2c_write(uint8_t reg_addr, const uint8_t* reg_data, uint32_t length, void* intf_ptr) {
-  uint8_t* buf;
+  uint8_t buf[I2C_WRITE_MAX + 1];
 
   // Sensirion adds CRC using their own methods, so we'll assume the address is already added if it
   // is null
   uint8_t address_offset = reg_addr != 0 ? 1 : 0;
 
-  struct identifier id;
-  id = *((struct identifier*)intf_ptr);
+  const struct identifier* id = intf_ptr;
+  struct i2c_txn txn;
 
-  buf = malloc(length + address_offset);
+  if (length > I2C_WRITE_MAX)
+    return -2;
 
   if (address_offset)
     buf[0] = reg_addr;
 
   memcpy(buf + address_offset, reg_data, length);
 
-  if (write(id.fd, buf, length + 1) < (uint16_t)length)
-    return -2;
-
-  free(buf);
+  i2c_txn_init(&txn);
+  i2c_txn_write(&txn, id->addr, buf, length + address_offset);
 
-  return 0;
+  return i2c_txn_submit(&txn) ? -2 : 0;
 }
 
 void unselect_i2c_extender() {
-  char* rx;
-  rx = malloc(1 * sizeof(char));
+  char tx[1] = {0}, rx[1];
 
-  spi_mod_comm("\x00", rx, 1);
+  spi_mod_comm(tx, rx, 1);
 
-  free(rx);
+  ext_mux_state = -1;
+}
+
+void invalidate_mux() {
+  mux_state = -1;
+  ext_mux_state = -1;
 }
 
 int8_t configure_mux() {
   int8_t rslt = 0;
 
+  // Sensors are (re)initialized from a known state
+  invalidate_mux();
+
   if (!pins_configured) {
     rslt |= mmio_get_gpio(&mux0);
     mmio_set_output(mux0);
@@ -114,13 +183,13 @@ void delay_us(uint32_t period, void* intf_ptr) {
   nanosleep((const struct timespec[]){{0, period * 1000}}, NULL);
 }
 
-int8_t i2c_open(int8_t* fd, uint8_t addr) {
-  if (!*fd) {
-    *fd = open("/dev/i2c-2", O_RDWR);
-    if (*fd < 0)
-      return -2;
-    if (ioctl(*fd, I2C_SLAVE, addr) < 0)
+int8_t i2c_open(struct identifier* id, uint8_t addr) {
+  if (bus_fd < 0) {
+    bus_fd = hal_open(I2C_BUS, O_RDWR);
+    if (bus_fd < 0)
       return -2;
   }
+
+  id->addr = addr;
   return 0;
 }
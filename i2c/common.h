@@ -16,6 +16,15 @@ extern "C" {
 
 #define WINDOW_SIZE 5
 #define MAX_NAME_LEN 16
+#define I2C_BUS "/dev/i2c-2"
+
+/// Maximum payload of a single i2c_write() call, excluding the register address
+#define I2C_WRITE_MAX 32
+
+/// Maximum amount of messages in a transaction (I2C_RDWR_IOCTL_MAX_MSGS)
+#define I2C_TXN_MAX_MSGS 42
+
+#include <linux/i2c.h>
 
 #include "../spi/common.h"
 
@@ -25,7 +34,16 @@ extern "C" {
 struct identifier {
   int8_t ext_mux_id;
   uint8_t mux_id;
-  uint8_t fd;
+  uint8_t addr;  ///< I2C slave address
+};
+
+/*!
+ * @brief I2C transaction: messages to one or more slaves, sent as a single I2C_RDWR ioctl
+ * (repeated starts between messages)
+ */
+struct i2c_txn {
+  struct i2c_msg msgs[I2C_TXN_MAX_MSGS];
+  uint8_t count;
 };
 
 /**
@@ -66,23 +84,73 @@ int8_t i2c_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t length, void* intf
  *  @return Execution status
  *
  *  @retval BME280_OK -> Success
- *  @retval BME280_E_COMM_FAIL -> Communication failure.
+ *  @retval BME280_E_COMM_FAIL -> Communication failure, or more than I2C_WRITE_MAX bytes.
  *
  */
 int8_t i2c_write(uint8_t reg_addr, const uint8_t* reg_data, uint32_t length, void* intf_ptr);
 
 /*!
  *  \ingroup i2cComm
- *  @brief Opens communication with the I2C bus at a given address
+ *  @brief Opens communication with a device on the I2C bus
  *
- *  @param[out] fd            : Pointer for the file descriptor
+ *  @details The bus is opened once and shared by every device; the address is only recorded in
+ *  the identification struct, as each transaction carries its own slave addresses.
+ *
+ *  @param[in, out] id        : Identification struct of the device
  *  @param[in] addr           : Address of the connected I2C device
  *
  *  @return Execution status
  *  @retval BME280_OK -> Success
  *  @retval BME280_E_COMM_FAIL -> Communication failure.
  */
-int8_t i2c_open(int8_t* fd, uint8_t addr);
+int8_t i2c_open(struct identifier* id, uint8_t addr);
+
+/**
+ * \ingroup i2c
+ * \defgroup i2cTxn Transactions
+ * @brief Batches of messages, to one or more slaves, submitted with a single system call
+ */
+
+/**
+ * \ingroup i2cTxn
+ * @brief Starts an empty transaction
+ * @param[out] txn Transaction
+ */
+void i2c_txn_init(struct i2c_txn* txn);
+
+/**
+ * \ingroup i2cTxn
+ * @brief Queues a write message
+ * @param[in, out] txn Transaction
+ * @param[in] addr Slave address
+ * @param[in] buf Data to write (must stay valid until the transaction is submitted)
+ * @param[in] len Amount of bytes to write
+ * @retval 0 Queued
+ * @retval -1 Transaction is full
+ */
+int8_t i2c_txn_write(struct i2c_txn* txn, uint8_t addr, const uint8_t* buf, uint16_t len);
+
+/**
+ * \ingroup i2cTxn
+ * @brief Queues a read message
+ * @param[in, out] txn Transaction
+ * @param[in] addr Slave address
+ * @param[out] buf Buffer for the data read (filled when the transaction is submitted)
+ * @param[in] len Amount of bytes to read
+ * @retval 0 Queued
+ * @retval -1 Transaction is full
+ */
+int8_t i2c_txn_read(struct i2c_txn* txn, uint8_t addr, uint8_t* buf, uint16_t len);
+
+/**
+ * \ingroup i2cTxn
+ * @brief Submits every queued message in one I2C_RDWR ioctl, on the shared bus
+ * @details The transaction stops at the first message that is not acknowledged.
+ * @param[in] txn Transaction
+ * @retval 0 All messages transferred
+ * @retval -1 Transfer failed
+ */
+int8_t i2c_txn_submit(struct i2c_txn* txn);
 
 /**
  * \ingroup i2c
@@ -102,6 +170,7 @@ int8_t set_ext_addr(uint8_t addr);
 /**
  * \ingroup i2cMux
  * @brief Unselects the I2C extender (and SPI extender, by proxy)
+ * @details The next direct_ext_mux() call will always reselect the extender channel.
  * @return void
  */
 void unselect_i2c_extender();
@@ -109,6 +178,8 @@ void unselect_i2c_extender();
 /**
  * \ingroup i2cMux
  * @brief Selects an available I2C channel through the SPI and I2C extender boards (0 to 8)
+ * @details Nothing is sent if the channel is already selected. After a failed transfer, the
+ * channel is sent again on the next call.
  * @param[in] id Desired channel ID
  * @param[in] addr Designed extender board address
  * @return void
@@ -118,11 +189,22 @@ void direct_ext_mux(uint8_t id);
 /**
  * \ingroup i2cMux
  * @brief Selects an available I2C channel through the digital interface board (0 to 4)
+ * @details The pins are left untouched if the channel is already selected.
  * @param[in] id Desired channel ID
  * @return void
  */
 void direct_mux(uint8_t id);
 
+/**
+ * \ingroup i2cMux
+ * @brief Forgets the currently selected channels, so that they are set again on the next switch
+ * @details Called whenever the cached state may be stale: when a transaction fails, and when the
+ * multiplexers are (re)configured. Must also be called if anything else (another process, for
+ * instance) may have changed the multiplexers' state.
+ * @return void
+ */
+void invalidate_mux();
+
 /**
  * \ingroup i2cMux
  * @brief Configures pins for the digital interface board multiplexing function
@@ -0,0 +1,527 @@
+/*! @file common.c
+ * @brief Binary time-series datalog
+ */
+
+#include "common.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <syslog.h>
+#include <unistd.h>
+
+#define LOG_MAGIC "SLOG"
+#define LOG_VERSION 1
+#define LOG_HEADER_LEN(channels) (8 + (LOG_NAME_LEN + 1) * (channels) + 4)
+
+/// Block magic numbers share their first three bytes, which is what resynchronization looks for
+#define LOG_BLOCK_DATA "SLGB"
+#define LOG_BLOCK_INDEX "SLGI"
+/// Magic, payload length, record/entry count, first timestamp, CRC-32
+#define LOG_BLOCK_HEADER 20
+#define LOG_INDEX_ENTRY 16
+
+/// Longest record: a 10-byte varint per field
+#define LOG_RECORD_MAX(channels) (10 * (1 + (channels)))
+/// Below this span, seeking walks block headers instead of bisecting
+#define LOG_SEEK_LINEAR 65536
+
+enum log_block { LOG_END = -1, LOG_DAMAGED, LOG_DATA, LOG_INDEX };
+
+static void put_le16(uint8_t* p, uint16_t v) {
+  p[0] = v;
+  p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; i++)
+    p[i] = v >> (8 * i);
+}
+
+static void put_le64(uint8_t* p, uint64_t v) {
+  for (int i = 0; i < 8; i++)
+    p[i] = v >> (8 * i);
+}
+
+static uint16_t get_le16(const uint8_t* p) {
+  return p[0] | p[1] << 8;
+}
+
+static uint32_t get_le32(const uint8_t* p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t get_le64(const uint8_t* p) {
+  uint64_t v = 0;
+
+  for (int i = 7; i >= 0; i--)
+    v = v << 8 | p[i];
+  return v;
+}
+
+/**
+ * @brief CRC-32 (IEEE 802.3), a nibble at a time
+ * @param[in] crc CRC of the preceding data (0 to start)
+ */
+static uint32_t crc32(uint32_t crc, const uint8_t* p, uint32_t len) {
+  static const uint32_t table[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+                                     0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+                                     0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                     0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ table[crc & 15];
+    crc = (crc >> 4) ^ table[crc & 15];
+  }
+  return ~crc;
+}
+
+static uint8_t put_varint(uint8_t* p, int64_t v) {
+  uint64_t u = ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+  uint8_t n = 0;
+
+  while (u >= 0x80) {
+    p[n++] = u | 0x80;
+    u >>= 7;
+  }
+  p[n++] = u;
+  return n;
+}
+
+/**
+ * @brief Decodes a zigzag varint
+ * @returns Bytes read (0 if it runs past `len` or over 10 bytes)
+ */
+static uint8_t get_varint(const uint8_t* p, uint16_t len, int64_t* v) {
+  uint64_t u = 0;
+
+  for (uint8_t n = 0; n < len && n < 10; n++) {
+    u |= (uint64_t)(p[n] & 0x7F) << (7 * n);
+    if (!(p[n] & 0x80)) {
+      *v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+      return n + 1;
+    }
+  }
+  return 0;
+}
+
+static void scales(const struct log_channel* channels, uint8_t count, double* scale) {
+  for (uint8_t i = 0; i < count; i++) {
+    scale[i] = 1;
+    for (uint8_t d = 0; d < channels[i].decimals; d++)
+      scale[i] *= 10;
+  }
+}
+
+/**
+ * @brief Converts a value to fixed point, saturating (NaN is stored as 0)
+ */
+static int64_t fixed(double value, double scale) {
+  value *= scale;
+  if (!(value == value))
+    return 0;
+  if (value > 9e15)
+    return 9e15;
+  if (value < -9e15)
+    return -9e15;
+  return value < 0 ? (int64_t)(value - 0.5) : (int64_t)(value + 0.5);
+}
+
+static uint16_t encode_header(uint8_t* p, const struct log_channel* channels, uint8_t count) {
+  uint16_t n = 8;
+
+  memcpy(p, LOG_MAGIC, 4);
+  p[4] = LOG_VERSION;
+  p[5] = count;
+  p[6] = p[7] = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    memset(p + n, 0, LOG_NAME_LEN);
+    memcpy(p + n, channels[i].name, strnlen(channels[i].name, LOG_NAME_LEN));
+    p[n + LOG_NAME_LEN] = channels[i].decimals;
+    n += LOG_NAME_LEN + 1;
+  }
+
+  put_le32(p + n, crc32(0, p, n));
+  return n + 4;
+}
+
+static void seal(uint8_t* header, const char* magic, uint16_t len, uint16_t count, int64_t ms,
+                 const uint8_t* payload) {
+  memcpy(header, magic, 4);
+  put_le16(header + 4, len);
+  put_le16(header + 6, count);
+  put_le64(header + 8, ms);
+  put_le32(header + 16, crc32(crc32(0, header + 4, 12), payload, len));
+}
+
+/**
+ * @brief Writes a block with a single system call
+ */
+static int8_t write_block(struct log_writer* w, const uint8_t* header, const uint8_t* payload,
+                          uint16_t len) {
+  struct iovec iov[2] = {{(void*)header, LOG_BLOCK_HEADER}, {(void*)payload, len}};
+  ssize_t written = writev(w->fd, iov, 2);
+
+  if (written != LOG_BLOCK_HEADER + len) {
+    // A partial block is skipped by readers, the next one goes after it
+    w->offset = lseek(w->fd, 0, SEEK_END);
+    return -1;
+  }
+
+  w->offset += written;
+  return 0;
+}
+
+static int8_t flush_index(struct log_writer* w) {
+  uint8_t header[LOG_BLOCK_HEADER], payload[LOG_INDEX_INTERVAL * LOG_INDEX_ENTRY];
+
+  if (w->indexed == 0)
+    return 0;
+
+  for (uint8_t i = 0; i < w->indexed; i++) {
+    put_le64(payload + i * LOG_INDEX_ENTRY, w->index[i].ms);
+    put_le64(payload + i * LOG_INDEX_ENTRY + 8, w->index[i].offset);
+  }
+  seal(header, LOG_BLOCK_INDEX, w->indexed * LOG_INDEX_ENTRY, w->indexed, w->index[0].ms, payload);
+
+  if (write_block(w, header, payload, w->indexed * LOG_INDEX_ENTRY))
+    return -1;
+
+  w->indexed = 0;
+  return 0;
+}
+
+static int8_t flush_block(struct log_writer* w) {
+  uint8_t header[LOG_BLOCK_HEADER];
+  off_t offset = w->offset;
+
+  if (w->records == 0)
+    return 0;
+
+  seal(header, LOG_BLOCK_DATA, w->len, w->records, w->first_ms, w->block);
+  if (write_block(w, header, w->block, w->len))
+    return -1;
+
+  // Removable media may be pulled out at any time, so only the block being filled can be lost
+  fdatasync(w->fd);
+
+  w->index[w->indexed++] = (struct log_index_entry){.ms = w->first_ms, .offset = offset};
+  w->len = w->records = 0;
+
+  return w->indexed == LOG_INDEX_INTERVAL ? flush_index(w) : 0;
+}
+
+int8_t log_open(struct log_writer* w, const char* path, const struct log_channel* channels,
+                uint8_t count, int64_t flush_ms) {
+  uint8_t header[LOG_HEADER_LEN(LOG_CHANNELS_MAX)], existing[sizeof(header)];
+  uint16_t len;
+  off_t size;
+
+  if (count == 0 || count > LOG_CHANNELS_MAX)
+    return -2;
+  for (uint8_t i = 0; i < count; i++) {
+    if (channels[i].decimals > LOG_DECIMALS_MAX)
+      return -2;
+  }
+
+  len = encode_header(header, channels, count);
+
+  w->fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (w->fd < 0) {
+    syslog(LOG_ERR, "Could not open datalog %s", path);
+    return -1;
+  }
+
+  size = lseek(w->fd, 0, SEEK_END);
+  if (size == 0) {
+    if (write(w->fd, header, len) != len) {
+      syslog(LOG_ERR, "Could not write the header of datalog %s", path);
+      close(w->fd);
+      return -1;
+    }
+    size = len;
+  } else if (pread(w->fd, existing, len, 0) != len || memcmp(header, existing, len)) {
+    syslog(LOG_ERR, "%s is not a datalog with the same channels", path);
+    close(w->fd);
+    return -2;
+  }
+
+  w->offset = size;
+  w->channels = count;
+  w->flush_ms = flush_ms;
+  w->len = w->records = 0;
+  w->indexed = 0;
+  scales(channels, count, w->scale);
+
+  return 0;
+}
+
+int8_t log_append(struct log_writer* w, int64_t ms, const double* values) {
+  int64_t value;
+
+  if (w->records && w->len + LOG_RECORD_MAX(w->channels) > LOG_BLOCK_MAX && flush_block(w))
+    return -1;
+
+  if (w->records == 0) {
+    w->first_ms = w->last_ms = ms;
+    memset(w->last, 0, sizeof(w->last));
+  }
+
+  w->len += put_varint(w->block + w->len, ms - w->last_ms);
+  for (uint8_t i = 0; i < w->channels; i++) {
+    value = fixed(values[i], w->scale[i]);
+    w->len += put_varint(w->block + w->len, value - w->last[i]);
+    w->last[i] = value;
+  }
+
+  w->last_ms = ms;
+  w->records++;
+
+  return ms - w->first_ms >= w->flush_ms ? flush_block(w) : 0;
+}
+
+int8_t log_flush(struct log_writer* w) {
+  int8_t rslt = flush_block(w);
+
+  return flush_index(w) || rslt ? -1 : 0;
+}
+
+int8_t log_close(struct log_writer* w) {
+  int8_t rslt = log_flush(w);
+
+  close(w->fd);
+  w->fd = -1;
+  return rslt;
+}
+
+int8_t log_reader_open(struct log_reader* r, const char* path) {
+  uint8_t header[LOG_HEADER_LEN(LOG_CHANNELS_MAX)];
+  uint16_t len;
+
+  r->fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (r->fd < 0)
+    return -1;
+
+  if (pread(r->fd, header, 8, 0) != 8 || memcmp(header, LOG_MAGIC, 4) ||
+      header[4] != LOG_VERSION || header[5] == 0 || header[5] > LOG_CHANNELS_MAX) {
+    close(r->fd);
+    return -2;
+  }
+
+  r->channels = header[5];
+  len = LOG_HEADER_LEN(r->channels);
+  if (pread(r->fd, header, len, 0) != len ||
+      get_le32(header + len - 4) != crc32(0, header, len - 4)) {
+    close(r->fd);
+    return -2;
+  }
+
+  for (uint8_t i = 0; i < r->channels; i++) {
+    memcpy(r->channel[i].name, header + 8 + i * (LOG_NAME_LEN + 1), LOG_NAME_LEN);
+    r->channel[i].decimals = header[8 + i * (LOG_NAME_LEN + 1) + LOG_NAME_LEN];
+  }
+  scales(r->channel, r->channels, r->scale);
+
+  r->data = r->offset = len;
+  r->size = lseek(r->fd, 0, SEEK_END);
+  r->from = INT64_MIN;
+  r->damaged = 0;
+  r->left = 0;
+
+  return 0;
+}
+
+/**
+ * @brief Reads and checks the block at an offset
+ * @param[out] header Block header
+ * @param[out] payload Block payload
+ */
+static enum log_block load(struct log_reader* r, off_t offset, uint8_t* header, uint8_t* payload) {
+  uint16_t len;
+
+  if (offset + LOG_BLOCK_HEADER > r->size)
+    return LOG_END;
+  if (pread(r->fd, header, LOG_BLOCK_HEADER, offset) != LOG_BLOCK_HEADER)
+    return LOG_END;
+
+  if (memcmp(header, LOG_BLOCK_DATA, 3) || (header[3] != 'B' && header[3] != 'I'))
+    return LOG_DAMAGED;
+
+  len = get_le16(header + 4);
+  if (len > LOG_BLOCK_MAX || offset + LOG_BLOCK_HEADER + len > r->size ||
+      pread(r->fd, payload, len, offset + LOG_BLOCK_HEADER) != len ||
+      get_le32(header + 16) != crc32(crc32(0, header + 4, 12), payload, len))
+    return LOG_DAMAGED;
+
+  return header[3] == 'B' ? LOG_DATA : LOG_INDEX;
+}
+
+/**
+ * @brief Finds the next candidate block start after a damaged one
+ * @returns Offset of the next block magic, or the file size
+ */
+static off_t resync(struct log_reader* r, off_t offset) {
+  uint8_t buf[4096];
+  ssize_t n;
+
+  for (offset++; offset < r->size; offset += n - 2) {
+    n = pread(r->fd, buf, sizeof(buf), offset);
+    if (n < 3)
+      break;
+
+    for (ssize_t i = 0; i + 2 < n; i++) {
+      if (buf[i] == 'S' && buf[i + 1] == 'L' && buf[i + 2] == 'G')
+        return offset + i;
+    }
+  }
+
+  return r->size;
+}
+
+/**
+ * @brief Loads the first valid block at or after an offset
+ * @param[in, out] offset Where to start, then where the block was found
+ */
+static enum log_block next_block(struct log_reader* r, off_t* offset, uint8_t* header,
+                                 uint8_t* payload) {
+  enum log_block kind;
+  uint8_t skipping = 0;
+
+  for (;;) {
+    kind = load(r, *offset, header, payload);
+    if (kind != LOG_DAMAGED) {
+      // A torn block at the end of the file is damaged too
+      if (kind == LOG_END && *offset < r->size && !skipping)
+        r->damaged++;
+      return kind;
+    }
+
+    if (!skipping)
+      r->damaged++;
+    skipping = 1;
+    *offset = resync(r, *offset);
+  }
+}
+
+void log_seek(struct log_reader* r, int64_t ms) {
+  uint8_t header[LOG_BLOCK_HEADER];
+  struct log_index_entry entries[LOG_INDEX_INTERVAL];
+  off_t lo = r->data, hi = r->size, mid, offset, best;
+  uint32_t damaged = r->damaged;
+  enum log_block kind;
+  int16_t n, j;
+
+  while (hi - lo > LOG_SEEK_LINEAR) {
+    // Bisecting lands inside blocks, so resynchronizing here is expected
+    mid = lo + (hi - lo) / 2;
+    offset = mid;
+    while ((kind = next_block(r, &offset, header, r->block)) == LOG_DATA && offset < hi)
+      offset += LOG_BLOCK_HEADER + get_le16(header + 4);
+
+    if (kind != LOG_INDEX || offset >= hi) {
+      hi = mid;
+      continue;
+    }
+
+    n = get_le16(header + 6);
+    if (n == 0 || n > LOG_INDEX_INTERVAL || n * LOG_INDEX_ENTRY != get_le16(header + 4)) {
+      hi = mid;
+      continue;
+    }
+
+    j = -1;
+    for (int16_t i = 0; i < n; i++) {
+      entries[i].ms = get_le64(r->block + i * LOG_INDEX_ENTRY);
+      entries[i].offset = get_le64(r->block + i * LOG_INDEX_ENTRY + 8);
+      if (entries[i].ms <= ms)
+        j = i;
+    }
+
+    if (j < 0) {
+      if ((off_t)entries[0].offset <= lo)
+        break;
+      hi = entries[0].offset;
+    } else if (j < n - 1) {
+      lo = entries[j].offset;
+      break;
+    } else {
+      if ((off_t)entries[j].offset <= lo)
+        break;
+      lo = entries[j].offset;
+    }
+  }
+
+  // Walk the block headers to the last data block starting at or before the timestamp
+  best = offset = lo;
+  while ((kind = next_block(r, &offset, header, r->block)) != LOG_END) {
+    if (kind == LOG_DATA) {
+      if ((int64_t)get_le64(header + 8) > ms)
+        break;
+      best = offset;
+    }
+    offset += LOG_BLOCK_HEADER + get_le16(header + 4);
+  }
+
+  r->offset = best;
+  r->left = 0;
+  r->from = ms;
+  r->damaged = damaged;
+}
+
+int8_t log_read(struct log_reader* r, int64_t* ms, double* values) {
+  uint8_t header[LOG_BLOCK_HEADER], n;
+  enum log_block kind;
+  int64_t delta = 0;
+
+  for (;;) {
+    if (r->left == 0) {
+      kind = next_block(r, &r->offset, header, r->block);
+      if (kind == LOG_END)
+        return 0;
+
+      r->offset += LOG_BLOCK_HEADER + get_le16(header + 4);
+      if (kind == LOG_INDEX)
+        continue;
+
+      r->len = get_le16(header + 4);
+      r->left = get_le16(header + 6);
+      r->pos = 0;
+      r->ms = get_le64(header + 8);
+      memset(r->last, 0, sizeof(r->last));
+    }
+
+    n = get_varint(r->block + r->pos, r->len - r->pos, &delta);
+    r->pos += n;
+    r->ms += delta;
+
+    for (uint8_t i = 0; n && i < r->channels; i++) {
+      n = get_varint(r->block + r->pos, r->len - r->pos, &delta);
+      r->pos += n;
+      r->last[i] += delta;
+    }
+
+    // The CRC matched, so a malformed record means a writer bug; the rest of the block is dropped
+    if (n == 0) {
+      r->left = 0;
+      r->damaged++;
+      continue;
+    }
+
+    r->left--;
+    if (r->ms < r->from)
+      continue;
+
+    *ms = r->ms;
+    for (uint8_t i = 0; i < r->channels; i++)
+      values[i] = r->last[i] / r->scale[i];
+    return 1;
+  }
+}
+
+void log_reader_close(struct log_reader* r) {
+  close(r->fd);
+  r->fd = -1;
+}
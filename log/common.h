@@ -0,0 +1,184 @@
+/*! @file common.h
+ * @brief Declarations for the binary time-series datalog
+ */
+
+/*!
+ * @defgroup log Datalog
+ * @brief Compact append-only time-series files, converted to CSV on demand (log2csv)
+ *
+ * @details A file starts with a header naming its channels and their fixed-point precision, and
+ * continues with blocks, each written with a single write(). Data blocks hold up to
+ * LOG_BLOCK_MAX bytes of records: the timestamp and every value are stored as the zigzag varint of
+ * their difference from the previous record (values start from 0 in every block), so a
+ * slowly-changing reading costs a byte or two. Every LOG_INDEX_INTERVAL data blocks, an index
+ * block lists their offsets and first timestamps, which lets readers bisect large files by time.
+ *
+ * All blocks carry a magic number, their length and a CRC-32 over both, so a torn or damaged block
+ * is skipped and the reader resynchronizes on the next valid one. Integers are little-endian.
+ */
+
+#ifndef LOG_COMMON_H
+#define LOG_COMMON_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define LOG_CHANNELS_MAX 8
+#define LOG_NAME_LEN 16
+#define LOG_DECIMALS_MAX 9
+/// Payload bytes per block
+#define LOG_BLOCK_MAX 1024
+/// Data blocks listed per index block
+#define LOG_INDEX_INTERVAL 16
+
+/*!
+ * @brief Channel description, stored in the file header
+ */
+struct log_channel {
+  char name[LOG_NAME_LEN];  ///< NUL-terminated, unless all LOG_NAME_LEN bytes are used
+  uint8_t decimals;         ///< Values are stored as integers, in units of 10^-decimals
+};
+
+/*!
+ * @brief Index entry: a data block and the timestamp of its first record
+ */
+struct log_index_entry {
+  int64_t ms;
+  uint64_t offset;
+};
+
+/*!
+ * @brief Appends records to a datalog file, batched per block
+ */
+struct log_writer {
+  int fd;
+  off_t offset;  ///< End of the file
+  uint8_t channels;
+  double scale[LOG_CHANNELS_MAX];
+  int64_t flush_ms;  ///< Age at which an incomplete block is written anyway
+
+  uint8_t block[LOG_BLOCK_MAX];
+  uint16_t len, records;
+  int64_t first_ms, last_ms;
+  int64_t last[LOG_CHANNELS_MAX];
+
+  struct log_index_entry index[LOG_INDEX_INTERVAL];
+  uint8_t indexed;
+};
+
+/*!
+ * @brief Reads records back from a datalog file
+ */
+struct log_reader {
+  int fd;
+  uint8_t channels;
+  struct log_channel channel[LOG_CHANNELS_MAX];
+  double scale[LOG_CHANNELS_MAX];
+  off_t data;    ///< First block
+  off_t offset;  ///< Next block
+  off_t size;
+  int64_t from;       ///< Records before this timestamp are skipped
+  uint32_t damaged;   ///< Damaged regions skipped so far
+
+  uint8_t block[LOG_BLOCK_MAX];
+  uint16_t len, pos, left;
+  int64_t ms;
+  int64_t last[LOG_CHANNELS_MAX];
+};
+
+/**
+ * \ingroup log
+ * \defgroup logWriter Writing
+ * @brief Batched appends, one write() per block
+ */
+
+/**
+ * \ingroup logWriter
+ * @brief Opens a datalog for appending, creating it if needed
+ * @details An existing file must have been created with the same channels.
+ * @param[out] w Writer
+ * @param[in] path File path
+ * @param[in] channels Channel descriptions
+ * @param[in] count Amount of channels (at most LOG_CHANNELS_MAX)
+ * @param[in] flush_ms Longest time records are held before their block is written, in ms
+ * @retval 0 OK
+ * @retval -1 The file could not be opened or its header written
+ * @retval -2 The file is not a datalog, or has different channels
+ */
+int8_t log_open(struct log_writer* w, const char* path, const struct log_channel* channels,
+                uint8_t count, int64_t flush_ms);
+
+/**
+ * \ingroup logWriter
+ * @brief Appends a record
+ * @details Nothing is written until the block fills up or grows older than `flush_ms`.
+ * Timestamps should not decrease.
+ * @param[in, out] w Writer
+ * @param[in] ms Timestamp, in ms since the epoch
+ * @param[in] values One value per channel
+ * @retval 0 OK
+ * @retval -1 A block could not be written (the record is kept for the next attempt)
+ */
+int8_t log_append(struct log_writer* w, int64_t ms, const double* values);
+
+/**
+ * \ingroup logWriter
+ * @brief Writes the current block and index, if they hold anything
+ * @retval 0 OK
+ * @retval -1 Write failed
+ */
+int8_t log_flush(struct log_writer* w);
+
+/**
+ * \ingroup logWriter
+ * @brief Flushes and closes a datalog
+ * @retval 0 OK
+ * @retval -1 The last records could not be written
+ */
+int8_t log_close(struct log_writer* w);
+
+/**
+ * \ingroup log
+ * \defgroup logReader Reading
+ * @brief Sequential decoding, skipping damaged blocks
+ */
+
+/**
+ * \ingroup logReader
+ * @brief Opens a datalog for reading, positioned at its first record
+ * @param[out] r Reader
+ * @param[in] path File path
+ * @retval 0 OK
+ * @retval -1 The file could not be opened
+ * @retval -2 The file is not a datalog
+ */
+int8_t log_reader_open(struct log_reader* r, const char* path);
+
+/**
+ * \ingroup logReader
+ * @brief Positions a reader at the first record at or after a timestamp
+ * @details Bisects the file on its index blocks, then walks the block headers. Assumes that
+ * timestamps increase through the file.
+ * @param[in, out] r Reader
+ * @param[in] ms Timestamp, in ms since the epoch
+ */
+void log_seek(struct log_reader* r, int64_t ms);
+
+/**
+ * \ingroup logReader
+ * @brief Reads the next record
+ * @param[in, out] r Reader
+ * @param[out] ms Timestamp, in ms since the epoch
+ * @param[out] values One value per channel
+ * @retval 1 A record was read
+ * @retval 0 End of file
+ */
+int8_t log_read(struct log_reader* r, int64_t* ms, double* values);
+
+/**
+ * \ingroup logReader
+ * @brief Closes a datalog
+ */
+void log_reader_close(struct log_reader* r);
+
+#endif
@@ -0,0 +1,498 @@
+/*! @file aggregator.c
+ * @brief Main starting point for the node aggregator
+ *
+ * @details Scrapes the local Redis server of every SIMAR node in a list, from a single thread, and
+ * appends what it reads to a Redis stream on the central server: one entry per node and round,
+ * holding the node (`node`, as host:port), the time the round started (`ts`, in milliseconds since
+ * the epoch), string keys under their own name and hash fields as `key.field`. Every connection is
+ * asynchronous and served by the same epoll loop, so a slow or dead node only delays itself.
+ *
+ * The node list holds one `host[:port]` per line; blank lines and `#` comments are skipped.
+ *
+ * Usage: aggregator [-i interval_ms] [-o host[:port]] [-s stream] [-m maxlen] [-k hash]... nodes
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+#include "../bench/common.h"
+#include "../redis/common.h"
+#include "../redis/epoll.h"
+
+#define AGG_INTERVAL_MS 1000
+#define AGG_NODES_MAX 1024
+#define AGG_KEYS_MAX 32
+#define AGG_STREAM "simar:samples"
+#define AGG_STREAM_MAXLEN "1000000"
+
+// Fields per stream entry, and room for their names and values
+#define AGG_FIELDS_MAX 128
+#define AGG_ENTRY_LEN 4096
+// XADD stream MAXLEN ~ maxlen * node id ts time
+#define AGG_ENTRY_HEADER 10
+
+// Entries the central server has yet to acknowledge, past which new ones are dropped
+#define AGG_INFLIGHT_MAX 4096
+
+enum key_type { KEY_STRING, KEY_HASH };
+
+/*!
+ * @brief Key read from every node
+ */
+struct scrape_key {
+  const char* name;
+  enum key_type type;
+};
+
+/*!
+ * @brief Redis server the aggregator reads from (a node) or writes to (the central server)
+ */
+struct node {
+  char host[REDIS_HOST_LEN];
+  int port;
+  char id[REDIS_HOST_LEN + 8];  ///< host:port, identifying the node in the stream
+  redisAsyncContext* ac;
+  uint8_t connected;
+  long backoff;       ///< Next reconnection delay, in milliseconds
+  uint64_t retry_at;  ///< Earliest reconnection time
+
+  // Stream entry being assembled for the current round
+  uint8_t pending;    ///< Scrape replies still expected
+  uint8_t failed;     ///< Whether a scrape command failed
+  uint8_t truncated;  ///< Whether fields were left out for lack of room
+  char ts[24];
+  int argc;
+  const char* argv[AGG_ENTRY_HEADER + 2 * AGG_FIELDS_MAX];
+  size_t argvlen[AGG_ENTRY_HEADER + 2 * AGG_FIELDS_MAX];
+  char buf[AGG_ENTRY_LEN];
+  size_t buf_len;
+};
+
+// Keys the node daemons publish; hashes can be added with -k
+static struct scrape_key keys[AGG_KEYS_MAX] = {
+    {"volt", KEY_STRING}, {"frequency", KEY_STRING}, {"pfactor", KEY_STRING},
+    {"glitch", KEY_STRING}, {"ich", KEY_HASH}, {"ich_pf", KEY_HASH},
+    {"fan", KEY_HASH}, {"leak_detector", KEY_HASH},
+};
+static uint8_t key_count = 8;
+
+static struct node* nodes;
+static uint16_t node_count, connected_count;
+static struct node central;
+static struct redis_epoll loop;
+
+static const char* stream = AGG_STREAM;
+static const char* maxlen = AGG_STREAM_MAXLEN;
+
+// Nodes still being scraped and entries not yet acknowledged, in the current round
+static uint16_t scraping;
+static uint32_t writing;
+static uint8_t round_open;
+static uint64_t round_start;
+
+/*!
+ * @brief Counters published in the `aggregator` hash
+ */
+static struct {
+  uint32_t entries;    ///< Entries written to the stream
+  uint32_t late;       ///< Rounds a node skipped, as it had not answered the previous one yet
+  uint32_t failed;     ///< Rounds lost to a failed scrape (timeout or lost connection)
+  uint32_t dropped;    ///< Entries lost on the way to the central server
+  uint32_t truncated;  ///< Entries written without some of their fields
+  uint32_t round_ms;   ///< Duration of the last complete round
+} stats;
+
+static uint64_t now_ms() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Parses a server address
+ * @param[in] text Address, as host[:port]
+ * @param[out] n Server (host and port)
+ * @retval 0 OK
+ * @retval -1 Not an address
+ */
+static int parse_address(const char* text, struct node* n) {
+  n->port = REDIS_PORT;
+
+  // Width is REDIS_HOST_LEN - 1
+  if (sscanf(text, " %15[^:# \t\r\n]:%d", n->host, &n->port) < 1 || n->port <= 0 ||
+      n->port > 65535)
+    return -1;
+
+  snprintf(n->id, sizeof(n->id), "%s:%d", n->host, n->port);
+  n->backoff = REDIS_BACKOFF_MIN_MS;
+  return 0;
+}
+
+/**
+ * @brief Reads the node list
+ * @param[in] path Node list
+ * @retval 0 OK
+ * @retval -1 The list could not be read, or holds no node
+ */
+static int load_nodes(const char* path) {
+  FILE* file = fopen(path, "r");
+  char line[128];
+
+  if (file == NULL) {
+    syslog(LOG_CRIT, "Could not open node list %s", path);
+    return -1;
+  }
+
+  nodes = calloc(AGG_NODES_MAX, sizeof(struct node));
+
+  while (nodes && fgets(line, sizeof(line), file)) {
+    if (node_count == AGG_NODES_MAX) {
+      syslog(LOG_ERR, "Node list holds more than %d nodes, ignoring the rest", AGG_NODES_MAX);
+      break;
+    }
+    if (parse_address(line, &nodes[node_count]) == 0)
+      node_count++;
+  }
+
+  fclose(file);
+  return node_count ? 0 : -1;
+}
+
+/**
+ * @brief Schedules a reconnection, backing off exponentially
+ * @param[in] n Server
+ */
+static void retry(struct node* n) {
+  n->ac = NULL;
+  n->retry_at = now_ms() + n->backoff;
+  n->backoff = n->backoff * 2 > REDIS_BACKOFF_MAX_MS ? REDIS_BACKOFF_MAX_MS : n->backoff * 2;
+}
+
+/**
+ * @brief Marks the end of a round once every scrape finished and every entry was acknowledged
+ */
+static void round_check() {
+  if (!round_open || scraping || writing)
+    return;
+
+  round_open = 0;
+  stats.round_ms = now_ms() - round_start;
+  BENCH_STAGE("xadd");
+  BENCH_SWEEP_END();
+}
+
+static void on_connect(const redisAsyncContext* ac, int status) {
+  struct node* n = ac->data;
+
+  if (status != REDIS_OK) {
+    // Only the first failure in a row is logged, as a dead node is retried for as long as it is
+    if (n->backoff == REDIS_BACKOFF_MIN_MS)
+      syslog(LOG_ERR, "Aggregator: %s not available: %s", n->id, ac->errstr);
+    retry(n);
+    return;
+  }
+
+  syslog(n == &central ? LOG_NOTICE : LOG_INFO, "Aggregator: connected to %s", n->id);
+  n->connected = 1;
+  n->backoff = REDIS_BACKOFF_MIN_MS;
+  if (n != &central)
+    connected_count++;
+}
+
+static void on_disconnect(const redisAsyncContext* ac, int status) {
+  struct node* n = ac->data;
+
+  if (status != REDIS_OK)
+    syslog(LOG_ERR, "Aggregator: lost connection to %s: %s", n->id, ac->errstr);
+
+  if (n->connected && n != &central)
+    connected_count--;
+  n->connected = 0;
+  retry(n);
+}
+
+/**
+ * @brief Starts a non-blocking connection to a server
+ * @param[in] n Server
+ */
+static void start_connect(struct node* n) {
+  redisOptions options = {0};
+  struct timeval timeout = {1, 500000};
+
+  REDIS_OPTIONS_SET_TCP(&options, n->host, n->port);
+  options.connect_timeout = &timeout;
+  options.command_timeout = &timeout;
+
+  n->ac = redisAsyncConnectWithOptions(&options);
+
+  if (n->ac == NULL || n->ac->err || redis_epoll_attach(&loop, n->ac) != REDIS_OK) {
+    if (n->ac)
+      redisAsyncFree(n->ac);
+    retry(n);
+    return;
+  }
+
+  n->ac->data = n;
+  redisAsyncSetConnectCallback(n->ac, on_connect);
+  redisAsyncSetDisconnectCallback(n->ac, on_disconnect);
+}
+
+/**
+ * @brief Adds a field to a node's stream entry
+ * @param[in] n Node
+ * @param[in] key Key the value was read from
+ * @param[in] field Hash field (NULL for string keys)
+ * @param[in] value Value
+ * @param[in] len Value length
+ */
+static void entry_add(struct node* n,
+                      const char* key,
+                      const char* field,
+                      const char* value,
+                      size_t len) {
+  char* name = n->buf + n->buf_len;
+  size_t room = AGG_ENTRY_LEN - n->buf_len;
+  int name_len;
+
+  if (n->argc + 2 > AGG_ENTRY_HEADER + 2 * AGG_FIELDS_MAX) {
+    n->truncated = 1;
+    return;
+  }
+
+  name_len = field ? snprintf(name, room, "%s.%s", key, field) : snprintf(name, room, "%s", key);
+  if (name_len < 0 || name_len + len >= room) {
+    n->truncated = 1;
+    return;
+  }
+
+  memcpy(name + name_len, value, len);
+
+  n->argv[n->argc] = name;
+  n->argvlen[n->argc++] = name_len;
+  n->argv[n->argc] = name + name_len;
+  n->argvlen[n->argc++] = len;
+  n->buf_len += name_len + len;
+}
+
+static void on_written(redisAsyncContext* ac, void* r, void* privdata) {
+  redisReply* reply = r;
+
+  writing--;
+  if (reply == NULL || reply->type == REDIS_REPLY_ERROR)
+    stats.dropped++;
+  else
+    stats.entries++;
+
+  round_check();
+}
+
+/**
+ * @brief Hands a node's stream entry to the central server, once all its keys were read
+ * @param[in] n Node
+ */
+static void scrape_done(struct node* n) {
+  if (--scraping == 0)
+    BENCH_STAGE("scrape");
+
+  if (n->failed) {
+    stats.failed++;
+  } else if (!central.connected || writing >= AGG_INFLIGHT_MAX) {
+    stats.dropped++;
+  } else if (redisAsyncCommandArgv(central.ac, on_written, NULL, n->argc, n->argv, n->argvlen) ==
+             REDIS_OK) {
+    writing++;
+    stats.truncated += n->truncated;
+  } else {
+    stats.dropped++;
+  }
+
+  round_check();
+}
+
+static void on_scrape(redisAsyncContext* ac, void* r, void* privdata) {
+  const struct scrape_key* key = privdata;
+  struct node* n = ac->data;
+  redisReply* reply = r;
+
+  if (reply == NULL || reply->type == REDIS_REPLY_ERROR) {
+    n->failed = 1;
+  } else if (reply->type == REDIS_REPLY_STRING) {
+    entry_add(n, key->name, NULL, reply->str, reply->len);
+  } else if (reply->type == REDIS_REPLY_ARRAY) {
+    for (size_t i = 0; i + 1 < reply->elements; i += 2) {
+      if (reply->element[i]->type == REDIS_REPLY_STRING &&
+          reply->element[i + 1]->type == REDIS_REPLY_STRING)
+        entry_add(n, key->name, reply->element[i]->str, reply->element[i + 1]->str,
+                  reply->element[i + 1]->len);
+    }
+  }
+
+  if (--n->pending == 0)
+    scrape_done(n);
+}
+
+/**
+ * @brief Starts a stream entry, and pipelines a read of every key to the node
+ * @param[in] n Node (connected, with no scrape pending)
+ * @param[in] ts Round start, in milliseconds since the epoch
+ */
+static void scrape(struct node* n, const char* ts) {
+  const char* header[AGG_ENTRY_HEADER] = {"XADD", stream, "MAXLEN", "~", maxlen,
+                                          "*",    "node", n->id,    "ts", n->ts};
+
+  snprintf(n->ts, sizeof(n->ts), "%s", ts);
+  for (int i = 0; i < AGG_ENTRY_HEADER; i++) {
+    n->argv[i] = header[i];
+    n->argvlen[i] = strlen(header[i]);
+  }
+
+  n->argc = AGG_ENTRY_HEADER;
+  n->buf_len = 0;
+  n->failed = 0;
+  n->truncated = 0;
+  n->pending = key_count;
+  scraping++;
+
+  for (uint8_t k = 0; k < key_count; k++) {
+    if (redisAsyncCommand(n->ac, on_scrape, &keys[k],
+                          keys[k].type == KEY_HASH ? "HGETALL %s" : "GET %s",
+                          keys[k].name) != REDIS_OK) {
+      // The connection is going down; the rest of the round is lost
+      n->failed = 1;
+      if (--n->pending == 0)
+        scrape_done(n);
+    }
+  }
+}
+
+/**
+ * @brief Scrapes every connected node, and (re)connects the others when due
+ * @param[in] now Current time (monotonic, in milliseconds)
+ */
+static void scrape_round(uint64_t now) {
+  struct timespec wall;
+  char ts[24];
+
+  clock_gettime(CLOCK_REALTIME, &wall);
+  snprintf(ts, sizeof(ts), "%lld", wall.tv_sec * 1000LL + wall.tv_nsec / 1000000);
+
+  if (central.ac == NULL && now >= central.retry_at)
+    start_connect(&central);
+
+  BENCH_SWEEP_BEGIN("aggregator");
+  round_start = now;
+  round_open = 1;
+
+  for (uint16_t i = 0; i < node_count; i++) {
+    struct node* n = &nodes[i];
+
+    if (n->ac == NULL) {
+      if (now >= n->retry_at)
+        start_connect(n);
+    } else if (n->connected && n->pending) {
+      stats.late++;
+    } else if (n->connected) {
+      scrape(n, ts);
+    }
+  }
+
+  if (central.connected)
+    redisAsyncCommand(central.ac, NULL, NULL,
+                      "HSET aggregator nodes %u connected %u entries %u late %u failed %u "
+                      "dropped %u truncated %u round_ms %u",
+                      node_count, connected_count, stats.entries, stats.late, stats.failed,
+                      stats.dropped, stats.truncated, stats.round_ms);
+
+  round_check();
+}
+
+/**
+ * @brief Whether the next round is due
+ * @param[in] now Current time (monotonic, in milliseconds)
+ * @param[in] next_round Scheduled start of the next round
+ */
+static uint8_t round_due(uint64_t now, uint64_t next_round) {
+#ifdef SIMAR_BENCH
+  // Rounds run back to back, once every server is connected
+  return !round_open && central.connected && connected_count == node_count;
+#else
+  return now >= next_round;
+#endif
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t interval_ms = AGG_INTERVAL_MS;
+  uint64_t now, next_round = 0;
+  struct rlimit limit;
+  int opt;
+
+  parse_address(redis_local[0], &central);
+
+  while ((opt = getopt(argc, argv, "i:o:s:m:k:")) != -1) {
+    if (opt == 'i' && atoi(optarg) > 0) {
+      interval_ms = atoi(optarg);
+    } else if (opt == 'o' && parse_address(optarg, &central) == 0) {
+      continue;
+    } else if (opt == 's') {
+      stream = optarg;
+    } else if (opt == 'm' && atol(optarg) > 0) {
+      maxlen = optarg;
+    } else if (opt == 'k' && key_count < AGG_KEYS_MAX) {
+      keys[key_count++] = (struct scrape_key){optarg, KEY_HASH};
+    } else {
+      fprintf(stderr,
+              "Usage: %s [-i interval_ms] [-o host[:port]] [-s stream] [-m maxlen] [-k hash]... "
+              "nodes\n",
+              argv[0]);
+      return -1;
+    }
+  }
+
+  if (optind != argc - 1) {
+    fprintf(stderr, "%s: missing node list\n", argv[0]);
+    return -1;
+  }
+
+  openlog("simar", 0, LOG_LOCAL0);
+  syslog(LOG_NOTICE, "Starting up...");
+
+  if (load_nodes(argv[optind])) {
+    syslog(LOG_CRIT, "No node to aggregate");
+    return -1;
+  }
+
+  // One descriptor per node
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+
+  if (redis_epoll_init(&loop)) {
+    syslog(LOG_CRIT, "Could not create the event loop");
+    return -1;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  start_connect(&central);
+  for (uint16_t i = 0; i < node_count; i++)
+    start_connect(&nodes[i]);
+
+  syslog(LOG_NOTICE, "Aggregating %u nodes into %s every %u ms", node_count, stream, interval_ms);
+
+  for (;;) {
+    now = now_ms();
+
+    if (round_due(now, next_round)) {
+      scrape_round(now);
+      next_round = next_round + interval_ms > now ? next_round + interval_ms : now + interval_ms;
+    }
+
+    redis_epoll_run(&loop, next_round > now ? next_round - now : interval_ms);
+  }
+}
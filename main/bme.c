@@ -3,24 +3,29 @@
  */
 
 #include <fcntl.h>
-#include <hiredis/hiredis.h>
 #include <stdlib.h>
 #include <string.h>
 #include <syslog.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "../bench/common.h"
 #include "../bme280/common/common.h"
+#include "../redis/common.h"
 #include "../sht3x/sht3x.h"
 #include "../utils/json/cJSON.h"
 
 // Set to 3 to enable the I2C Expansion Board
 #define ERROR_THRESHOLD 5
 #define EXT_BOARD_I2C_LEN 6
+// Sweeps a periodic SHT3x may go without a new measurement before it is considered failed
+#define SHT_MISSES_MAX 5
 
 uint8_t iface_board_len = 4;
 
-const char servers[3][32] = {"10.0.38.46", "10.0.38.42", "10.0.38.59"};
+const char servers[3][REDIS_HOST_LEN] = {"10.0.38.46", "10.0.38.42", "10.0.38.59"};
+
+struct redis_transport local, remote;
 
 /**
  * @brief Updates door opening status
@@ -112,6 +117,121 @@ void update_open(struct bme_sensor_data* sensor) {
   }
 }
 
+/**
+ * @brief Compares two sensors' multiplexer channels
+ *
+ * @param[in] a : First sensor identifier
+ * @param[in] b : Second sensor identifier
+ *
+ * @return Negative, zero or positive if a's channel comes before, is the same as or comes after b's
+ */
+int compare_id(const struct identifier* a, const struct identifier* b) {
+  if (a->mux_id != b->mux_id)
+    return a->mux_id - b->mux_id;
+  return a->ext_mux_id - b->ext_mux_id;
+}
+
+/// qsort() comparator for BMx sensors, see compare_id()
+int compare_bme(const void* a, const void* b) {
+  return compare_id(&((const struct bme_sensor_data*)a)->id,
+                    &((const struct bme_sensor_data*)b)->id);
+}
+
+/// qsort() comparator for SHT3x sensors, see compare_id()
+int compare_sht(const void* a, const void* b) {
+  return compare_id(&((const struct sht3x_sensor_data*)a)->id,
+                    &((const struct sht3x_sensor_data*)b)->id);
+}
+
+/**
+ * @brief Queues a BMx sensor's readings for publishing
+ *
+ * @param[in] t : Local Redis transport
+ * @param[in] sensor : Pointer to sensor
+ *
+ * @details All fields are written with a single multi-field HSET. The transport pipelines
+ * everything queued during the sweep, so publishing never waits on the server.
+ *
+ * @retval 0 Command queued
+ * @retval -1 Command could not be formatted
+ */
+int publish_bme(struct redis_transport* t, struct bme_sensor_data* sensor) {
+  return redis_enqueue(t,
+                       "HSET %s temperature %.3f pressure %.3f humidity %.3f open %d avg %.3f "
+                       "openavg %.3f",
+                       sensor->name, sensor->data.temperature, sensor->data.pressure,
+                       sensor->data.humidity, sensor->is_open, sensor->average,
+                       sensor->open_average);
+}
+
+/**
+ * @brief Queues a SHT3x sensor's readings for publishing
+ *
+ * @param[in] t : Local Redis transport
+ * @param[in] sensor : Pointer to sensor
+ *
+ * @retval 0 Command queued
+ * @retval -1 Command could not be formatted
+ */
+int publish_sht(struct redis_transport* t, struct sht3x_sensor_data* sensor) {
+  return redis_enqueue(t, "HSET %s temperature %.3f humidity %.3f", sensor->name,
+                       sensor->data.temperature, sensor->data.humidity);
+}
+
+/**
+ * @brief Mirrors the remote external pressure into the local server
+ *
+ * @param[in] reply : Reply to the remote GET (NULL if it was lost)
+ * @param[in] privdata : Local Redis transport
+ *
+ * @return void
+ */
+void mirror_ext_pressure(redisReply* reply, void* privdata) {
+  if (reply != NULL && reply->type == REDIS_REPLY_STRING)
+    redis_enqueue((struct redis_transport*)privdata, "SET last_ext_pressure %s", reply->str);
+}
+
+/**
+ * @brief Reads the SHT3x acquisition mode from the device configuration
+ *
+ * @param[in] json : Parsed /opt/device.json
+ *
+ * @details `sht3xMode` is "single" (single shot measurements, the default), "periodic" or "art"
+ * (accelerated response time, for fast-changing racks). `sht3xRate` sets the periodic rate, in
+ * measurements per second: 0.5, 1, 2 (the default), 4 or 10. Rates under 1 mps leave some sweeps
+ * without a new measurement.
+ *
+ * @return Periodic rate (sht3x_periodic_rate_t), or -1 for single shot measurements
+ */
+int8_t parse_sht_mode(const cJSON* json) {
+  const cJSON* mode = cJSON_GetObjectItemCaseSensitive(json, "sht3xMode");
+  const cJSON* rate = cJSON_GetObjectItemCaseSensitive(json, "sht3xRate");
+  const double rates[] = {0.5, 1, 2, 4, 10};
+
+  if (!cJSON_IsString(mode) || !strcmp(mode->valuestring, "single"))
+    return -1;
+
+  if (!strcmp(mode->valuestring, "art"))
+    return SHT3X_PERIODIC_ART;
+
+  if (strcmp(mode->valuestring, "periodic")) {
+    syslog(LOG_WARNING, "Unknown sht3xMode %s, using single shot measurements", mode->valuestring);
+    return -1;
+  }
+
+  if (!cJSON_IsNumber(rate))
+    return SHT3X_PERIODIC_2_MPS;
+
+  for (int8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+    if (rate->valuedouble == rates[i])
+      return i;
+  }
+
+  syslog(LOG_WARNING, "Unsupported sht3xRate %g, using 2 measurements per second",
+         rate->valuedouble);
+  return SHT3X_PERIODIC_2_MPS;
+}
+
 int main(int argc, char* argv[]) {
   openlog("simar", 0, LOG_LOCAL0);
 
@@ -129,13 +249,15 @@ int main(int argc, char* argv[]) {
   uint8_t valid_bme = 0;
   uint8_t valid_sht = 0;
   uint8_t board_addr;
+  int8_t sht_rate = -1;
 
   int fd = open("/opt/device.json", O_RDONLY);
   if (fd > 0) {
     int len = lseek(fd, 0, SEEK_END);
     char* json_buf = malloc(len + 1);
     lseek(fd, 0, SEEK_SET);
-    read(fd, json_buf, len);
+    len = read(fd, json_buf, len);
+    json_buf[len > 0 ? len : 0] = '\0';
 
     const cJSON* boards = NULL;
     const cJSON* board = NULL;
@@ -154,6 +276,8 @@ int main(int argc, char* argv[]) {
           }
         }
       }
+
+      sht_rate = parse_sht_mode(boards_json);
     }
 
     cJSON_Delete(boards_json);
@@ -247,12 +371,12 @@ int main(int argc, char* argv[]) {
                  sensor_addr, sensor.id.ext_mux_id);
           valid_bme++;
         } else {
-          struct sht3x_sensor_data sht_sensor = {.id.mux_id = i % iface_board_len,
-                                                 .id.ext_mux_id = -1};
+          struct sht3x_sensor_data sht_sensor = {.id.mux_id = sensor.id.mux_id,
+                                                 .id.ext_mux_id = sensor.id.ext_mux_id};
           if (sht3x_init(&sht_sensor, sht_sensor_addr) == BME280_OK) {
             sht_sensors[valid_sht] = sht_sensor;
-            snprintf(sht_sensors[valid_sht].name, MAX_NAME_LEN, "sensor_%d_%x", i % iface_board_len,
-                     sht_sensor_addr);
+            snprintf(sht_sensors[valid_sht].name, MAX_NAME_LEN, "sensor_%d_%x",
+                     i + iface_board_len + 1, sht_sensor_addr);
 
             syslog(LOG_INFO,
                    "Initialized SHT3x on expansion board device with address 0x%x at channel %d",
@@ -271,37 +395,36 @@ int main(int argc, char* argv[]) {
     return SENSOR_FAIL;
   }
 
-  syslog(LOG_NOTICE, "Starting up...");
+  // Sensors sharing a channel are read back to back, so that each channel is selected once per
+  // sweep
+  qsort(bme_sensors, valid_bme, sizeof(bme_sensors[0]), compare_bme);
+  qsort(sht_sensors, valid_sht, sizeof(sht_sensors[0]), compare_sht);
 
-  int server_i = 0;
+  for (int i = 0; i < valid_bme; i++)
+    bme_sensors[i].dev.intf_ptr = &bme_sensors[i].id;
 
-  do {
-    c = redisConnectWithTimeout("127.0.0.1", 6379, (struct timeval){1, 500000});
-    c_remote = redisConnectWithTimeout(servers[server_i], 6379, (struct timeval){1, 500000});
-
-    if (c->err) {
-      if (c->err == 1)
-        syslog(LOG_ERR,
-               "Redis server instance not available. Have you "
-               "initialized the Redis server? (Error code 1)\n");
-      else
-        syslog(LOG_ERR, "Unknown redis error (error code %d)\n", c->err);
-
-      nanosleep((const struct timespec[]){{0, 700000000L}}, NULL);  // 700ms
+  // Periodic SHT3x sensors convert on their own, sweeps only fetch their latest measurement
+  for (int i = 0; sht_rate >= 0 && i < valid_sht; i++) {
+    if (sht3x_start_periodic(&sht_sensors[i], sht_rate) != STATUS_OK) {
+      syslog(LOG_CRIT, "Could not start periodic acquisition on %s", sht_sensors[i].name);
+      return SENSOR_FAIL;
     }
+  }
 
-    if (c_remote->err) {
-      if (server_i == 0) {
-        syslog(LOG_ERR,
-               "No remote Redis server instance for calibration is available. "
-               "Attempting to fetch local mirror.\n");
-        c_remote = c;
-      }
+  if (sht_rate >= 0 && valid_sht)
+    syslog(LOG_NOTICE, "SHT3x sensors in periodic acquisition mode");
 
-      syslog(LOG_ERR, "%s remote Redis server not available, switching...\n", servers[server_i++]);
-    }
+  syslog(LOG_NOTICE, "Starting up...");
+
+  c = redis_connect(redis_local, 1, -1);
+  c_remote = redis_connect(servers, sizeof(servers) / sizeof(servers[0]), 1);
 
-  } while (c->err || c_remote->err);
+  if (c_remote == NULL) {
+    syslog(LOG_ERR,
+           "No remote Redis server instance for calibration is available. "
+           "Attempting to fetch local mirror.\n");
+    c_remote = c;
+  }
 
   syslog(LOG_NOTICE, "Redis DB connected");
   int retries = 0;
@@ -415,40 +538,42 @@ int main(int argc, char* argv[]) {
   reply = (redisReply*)redisCommand(c, "SET retries 0");
   freeReplyObject(reply);
 
+  if (c_remote != c)
+    redisFree(c_remote);
+  redisFree(c);
+
+  if (redis_transport_init(&local, "bme_local", redis_local, 1) ||
+      redis_transport_init(&remote, "bme_remote", servers, sizeof(servers) / sizeof(servers[0]))) {
+    syslog(LOG_CRIT, "Could not start the Redis transport");
+    exit(DB_FAIL);
+  }
+
   uint8_t bme_errors = 0;
+  int8_t bme_rslt[16];
+  int16_t sht_rslt[16];
+  uint8_t sht_misses[16] = {0};
+  long sweep_us = 0;
+  unsigned long sweeps = 0;
+  struct timespec sweep_start, sweep_end;
 
   while (1) {
-    for (i = 0; i < valid_bme; i++) {
-      if (bme_read(&bme_sensors[i].dev, &bme_sensors[i].data) == BME280_OK &&
-          check_alteration(bme_sensors[i]) == BME280_OK) {
-        bme_errors = 0;
-        reply = (redisReply*)redisCommand(c, "HSET %s %s %.3f", bme_sensors[i].name, "temperature",
-                                          bme_sensors[i].data.temperature);
-        if (reply == NULL)
-          return DB_FAIL;
+    clock_gettime(CLOCK_MONOTONIC, &sweep_start);
+    BENCH_SWEEP_BEGIN("bme");
 
-        freeReplyObject(reply);
+    // SHT3x sensors convert while the BMx sensors are read
+    if (sht_rate < 0 && sht3x_measure_batch(sht_sensors, valid_sht, sht_rslt) != STATUS_OK)
+      return SENSOR_FAIL;
 
-        reply = (redisReply*)redisCommand(c, "HSET %s %s %.3f", bme_sensors[i].name, "pressure",
-                                          bme_sensors[i].data.pressure);
-        freeReplyObject(reply);
-
-        reply = (redisReply*)redisCommand(c, "HSET %s %s %.3f", bme_sensors[i].name, "humidity",
-                                          bme_sensors[i].data.humidity);
-        freeReplyObject(reply);
+    // Sensors are sorted by channel, so each channel's sensors are read in one transaction
+    bme_read_burst(bme_sensors, valid_bme, bme_rslt);
 
+    for (i = 0; i < valid_bme; i++) {
+      if (bme_rslt[i] == BME280_OK && check_alteration(bme_sensors[i]) == BME280_OK) {
+        bme_errors = 0;
         update_open(&bme_sensors[i]);
-        reply = (redisReply*)redisCommand(c, "HSET %s %s %d", bme_sensors[i].name, "open",
-                                          bme_sensors[i].is_open);
-        freeReplyObject(reply);
-
-        reply = (redisReply*)redisCommand(c, "HSET %s %s %.3f", bme_sensors[i].name, "avg",
-                                          bme_sensors[i].average);
-        freeReplyObject(reply);
-
-        reply = (redisReply*)redisCommand(c, "HSET %s %s %.3f", bme_sensors[i].name, "openavg",
-                                          bme_sensors[i].open_average);
-        freeReplyObject(reply);
+        BENCH_STAGE("processing");
+        publish_bme(&local, &bme_sensors[i]);
+        BENCH_STAGE("redis");
 
         bme_sensors->past_pres = bme_sensors[i].data.pressure;
       } else {
@@ -457,37 +582,45 @@ int main(int argc, char* argv[]) {
       }
     }
 
-    for (i = 0; i < valid_sht; i++) {
-      if (sht3x_measure_blocking_read(&sht_sensors[i]) != BME280_OK)
+    if (sht_rate < 0) {
+      if (sht3x_read_batch(sht_sensors, valid_sht, sht_rslt) != STATUS_OK)
         return SENSOR_FAIL;
+    } else {
+      // A fetch fails when no measurement completed since the previous one
+      for (i = 0; i < valid_sht; i++) {
+        sht_rslt[i] = sht3x_fetch(&sht_sensors[i]);
+        if (sht_rslt[i] == STATUS_OK)
+          sht_misses[i] = 0;
+        else if (++sht_misses[i] > SHT_MISSES_MAX)
+          return SENSOR_FAIL;
+      }
+    }
+    BENCH_STAGE("bus");
 
-      reply = (redisReply*)redisCommand(c, "HSET %s %s %.3f", sht_sensors[i].name, "temperature",
-                                        sht_sensors[i].data.temperature);
-
-      if (reply == NULL)
-        return DB_FAIL;
-
-      freeReplyObject(reply);
-
-      reply = (redisReply*)redisCommand(c, "HSET %s %s %.3f", sht_sensors[i].name, "humidity",
-                                        sht_sensors[i].data.humidity);
-      freeReplyObject(reply);
+    for (i = 0; i < valid_sht; i++) {
+      if (sht_rslt[i] == STATUS_OK)
+        publish_sht(&local, &sht_sensors[i]);
     }
+    BENCH_STAGE("redis");
 
     if (iface_board_len == 3)
       unselect_i2c_extender();
+    BENCH_STAGE("bus");
 
-    reply_remote = (redisReply*)redisCommand(c_remote, "GET wgen2_pressure");
+    redis_enqueue_cb(&remote, mirror_ext_pressure, &local, "GET wgen2_pressure");
 
-    if (reply_remote->str) {
-      reply = (redisReply*)redisCommand(c, "SET last_ext_pressure %s", reply_remote->str);
-      freeReplyObject(reply);
-    }
+    clock_gettime(CLOCK_MONOTONIC, &sweep_end);
+    sweep_us = (sweep_end.tv_sec - sweep_start.tv_sec) * 1000000L +
+               (sweep_end.tv_nsec - sweep_start.tv_nsec) / 1000L;
 
-    freeReplyObject(reply_remote);
-    nanosleep((const struct timespec[]){{0, 999999999L}}, NULL);
+    redis_enqueue(&local, "HSET bme_sweep latency_us %ld count %lu", sweep_us, ++sweeps);
+    redis_enqueue_metrics(&local, &local);
+    redis_enqueue_metrics(&local, &remote);
+    BENCH_STAGE("redis");
+    BENCH_SWEEP_END();
+
+    BENCH_SKIP(nanosleep((const struct timespec[]){{0, 999999999L}}, NULL));
   }
 
-  redisFree(c);
   return 0;
 }
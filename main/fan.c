@@ -3,11 +3,13 @@
  */
 
 #include <fcntl.h>
-#include <hiredis/hiredis.h>
 #include <stdlib.h>
 #include <syslog.h>
 #include <time.h>
 #include <unistd.h>
+#include "../bench/common.h"
+#include "../redis/common.h"
+#include "../sim/common.h"
 #include "../spi/common.h"
 
 #define AI_PIN "/sys/bus/iio/devices/iio:device0/in_voltage1_raw"
@@ -23,12 +25,12 @@ double get_rpm(double runtime) {
   uint32_t valley_count = 1;
 
   for (uint8_t i = 0; i < 100; i++) {
-    int fd = open(AI_PIN, O_RDONLY);
-    if (read(fd, adc, 4) < 1) {
+    int fd = hal_open(AI_PIN, O_RDONLY);
+    if (hal_read(fd, adc, 4) < 1) {
       syslog(LOG_ERR, "No ADC found for fan sensor");
       exit(-2);
     }
-    close(fd);
+    hal_close(fd);
     new_val = atoi(adc);
     if (abs(new_val - old) > 50 && old != 0) {
       if (new_val > 500)
@@ -55,8 +57,7 @@ int main(int argc, char* argv[]) {
   openlog("simar", 0, LOG_LOCAL0);
 
   clock_t t;
-  redisContext* c;
-  redisReply* reply;
+  struct redis_transport local;
 
   t = clock();
   get_rpm(0.0013);
@@ -64,23 +65,19 @@ int main(int argc, char* argv[]) {
 
   double runtime = ((double)t) / CLOCKS_PER_SEC / 18;
 
-  do {
-    c = redisConnectWithTimeout("127.0.0.1", 6379, (struct timeval){1, 500000});
-
-    if (c->err) {
-      if (c->err == 1)
-        syslog(LOG_ERR,
-               "Redis server instance not available. Have you "
-               "initialized the Redis server? (Error code 1)\n");
-      else
-        syslog(LOG_ERR, "Unknown redis error (error code %d)\n", c->err);
-
-      nanosleep((const struct timespec[]){{0, 700000000L}}, NULL);  // 700ms
-    }
-  } while (c->err);
+  if (redis_transport_init(&local, "fan_local", redis_local, 1)) {
+    syslog(LOG_CRIT, "Could not start the Redis transport");
+    exit(DB_FAIL);
+  }
 
   while (1) {
-    reply = (redisReply*)redisCommand(c, "HSET fan speed %.3f", get_rpm(runtime));
-    freeReplyObject(reply);
+    BENCH_SWEEP_BEGIN("fan");
+    double rpm = get_rpm(runtime);
+    BENCH_STAGE("ain");
+
+    redis_enqueue(&local, "HSET fan speed %.3f", rpm);
+    redis_enqueue_metrics(&local, &local);
+    BENCH_STAGE("redis");
+    BENCH_SWEEP_END();
   }
 }
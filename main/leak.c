@@ -2,7 +2,6 @@
  * @brief Main starting point for fan RPM sensor module
  */
 
-#include <hiredis/hiredis.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,30 +16,19 @@
 #include <linux/can.h>
 #include <linux/can/raw.h>
 
+#include "../redis/common.h"
+#include "../sim/common.h"
 #include "../spi/common.h"
 
 int main(int argc, char* argv[]) {
   openlog("simar", 0, LOG_LOCAL0);
 
-  redisContext* c;
-  redisReply* reply;
+  struct redis_transport local;
 
-  do {
-    c = redisConnectWithTimeout("127.0.0.1", 6379, (struct timeval){1, 500000});
-
-    if (c->err) {
-      if (c->err == 1)
-        syslog(LOG_ERR,
-               "Redis server instance not available. Have you "
-               "initialized the Redis server? (Error code 1)\n");
-      else
-        syslog(LOG_ERR, "Unknown redis error (error code %d)\n", c->err);
-
-      nanosleep((const struct timespec[]){{0, 700000000L}}, NULL);  // 700ms
-    }
-  } while (c->err);
-
-  syslog(LOG_NOTICE, "Redis DB connected");
+  if (redis_transport_init(&local, "leak_local", redis_local, 1)) {
+    syslog(LOG_CRIT, "Could not start the Redis transport");
+    exit(DB_FAIL);
+  }
 
   char digital_buffer[1];
 
@@ -80,7 +68,7 @@ int main(int argc, char* argv[]) {
   for (;;) {
     read_data(3, digital_buffer, 1);
 
-    if (read(fd, digital_buffer, 1)) {
+    if (hal_read(fd, digital_buffer, 1)) {
       for (int i = 0; i < 8; i++) {
         /*if (digital_buffer[0] >> i & 0b00000001) {
           snprintf(frame.data, 4, "%d %d", i, 1);  // TODO: Decide what to write
@@ -89,10 +77,9 @@ int main(int argc, char* argv[]) {
             return -2;
           }
         }*/
-          reply = redisCommand(c, "HSET leak_detector %d %d", i,
-                               !((digital_buffer[0] >> i) & 0b00000001));
-          freeReplyObject(reply);
-        
+          redis_enqueue(&local, "HSET leak_detector %d %d", i,
+                        !((digital_buffer[0] >> i) & 0b00000001));
+
           nanosleep(period, NULL);
         //}
       }
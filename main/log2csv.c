@@ -0,0 +1,119 @@
+/*! @file log2csv.c
+ * @brief Converts a binary datalog (log/common.h) to CSV
+ *
+ * @details Prints a `time` column followed by one column per channel, with as many decimals as the
+ * channel was stored with. Times are local, as `YYYY-MM-DD HH:MM:SS.mmm`, or milliseconds since the
+ * epoch with `-e`. `-f` and `-t` restrict the output to records from `-f` up to, but excluding,
+ * `-t` (local time, as `YYYY-MM-DD[ HH:MM[:SS]]`); the start is found by bisecting the file, not by
+ * reading all of it.
+ * Damaged regions are skipped and counted on stderr.
+ *
+ * Usage: log2csv [-e] [-f from] [-t to] datalog
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../log/common.h"
+
+/**
+ * @brief Parses a local time
+ * @param[in] s Time, as `YYYY-MM-DD[ HH:MM[:SS]]`
+ * @param[out] ms Time, in ms since the epoch
+ * @retval 0 OK
+ * @retval -1 Invalid time
+ */
+static int8_t parse_time(const char* s, int64_t* ms) {
+  struct tm tm = {.tm_isdst = -1};
+  time_t t;
+
+  if (sscanf(s, "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour,
+             &tm.tm_min, &tm.tm_sec) < 3)
+    return -1;
+
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+  t = mktime(&tm);
+  if (t == -1)
+    return -1;
+
+  *ms = t * 1000LL;
+  return 0;
+}
+
+static void print_time(int64_t ms, uint8_t epoch) {
+  char str[32];
+  time_t t;
+  int64_t frac;
+
+  if (epoch) {
+    printf("%lld", (long long)ms);
+    return;
+  }
+
+  frac = ms % 1000;
+  if (frac < 0)
+    frac += 1000;
+  t = (ms - frac) / 1000;
+
+  strftime(str, sizeof(str), "%Y-%m-%d %H:%M:%S", localtime(&t));
+  printf("%s.%03d", str, (int)frac);
+}
+
+int main(int argc, char* argv[]) {
+  struct log_reader r;
+  double values[LOG_CHANNELS_MAX];
+  int64_t ms, from = INT64_MIN, to = INT64_MAX;
+  uint8_t epoch = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "ef:t:")) != -1) {
+    if (opt == 'e') {
+      epoch = 1;
+    } else if (opt == 'f' && parse_time(optarg, &from) == 0) {
+      continue;
+    } else if (opt == 't' && parse_time(optarg, &to) == 0) {
+      continue;
+    } else {
+      fprintf(stderr, "Usage: %s [-e] [-f from] [-t to] datalog\n", argv[0]);
+      return -1;
+    }
+  }
+
+  if (optind != argc - 1) {
+    fprintf(stderr, "%s: missing datalog\n", argv[0]);
+    return -1;
+  }
+
+  switch (log_reader_open(&r, argv[optind])) {
+    case -1:
+      perror(argv[optind]);
+      return -1;
+    case -2:
+      fprintf(stderr, "%s: not a datalog\n", argv[optind]);
+      return -1;
+  }
+
+  if (from != INT64_MIN)
+    log_seek(&r, from);
+
+  printf("time");
+  for (uint8_t i = 0; i < r.channels; i++)
+    printf(",%.*s", LOG_NAME_LEN, r.channel[i].name);
+  printf("\n");
+
+  while (log_read(&r, &ms, values) == 1 && ms < to) {
+    print_time(ms, epoch);
+    for (uint8_t i = 0; i < r.channels; i++)
+      printf(",%.*f", r.channel[i].decimals, values[i]);
+    printf("\n");
+  }
+
+  if (r.damaged)
+    fprintf(stderr, "%s: skipped %u damaged region(s)\n", argv[optind], r.damaged);
+
+  log_reader_close(&r);
+  return 0;
+}
@@ -4,15 +4,28 @@
 
 #include <errno.h>
 #include <fcntl.h>
-#include <hiredis/hiredis.h>
+#include <math.h>
 #include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/poll.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 #include <syslog.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "../bench/common.h"
+#include "../dsp/common.h"
+#include "../dsp/fft.h"
+#include "../dsp/pf.h"
+#include "../pruss/common.h"
+#include "../redis/common.h"
+#include "../sim/common.h"
 #include "../spi/common.h"
+#include "../utils/ring/ring.h"
+#include "../utils/seqlock/seqlock.h"
 
 #define OUTLET_QUANTITY 7
 #define RESOLUTION 0.01953125
@@ -20,82 +33,309 @@
 #define PRU0_DEVICE_NAME "/dev/rpmsg_pru30"
 #define PRU1_DEVICE_NAME "/dev/rpmsg_pru31"
 #define ACTUATION_CHANNEL 3
+// Conversions per SPI message while scanning the ADC. Actuation commands can only take the bus
+// between messages, so this bounds their wait (5 frames, 0.4 ms at 200 kHz)
+#define ADC_SCAN_CHUNK 4
+
+// Outlet commands are applied on keyspace notifications, and reconciled every COMMAND_RECONCILE_S
+// (every COMMAND_POLL_S if the server does not send notifications)
+#define COMMAND_RECONCILE_S 30
+#define COMMAND_POLL_S 2
+#define KEYSPACE_CHANNEL "__keyspace@0__:"
+
+// PRU1 glitch/frequency/duty cycle counter, read over back-to-back windows of PRU_WINDOW_MS
+#define PRU_WINDOW_MS 5000
+#define PRU_MSG_LEN 16
+/// Messages the firmware sends after a window is closed (its counters, then an empty count)
+#define PRU_REPLIES 2
+/// Edge ring drain period (the ring holds about 4 s of edges)
+#define PRU_RING_POLL_MS 100
+
+// Capture mode (-c): continuous sampling, aggregated over windows of CAPTURE_WINDOW_MS (-w), with
+// optional harmonic analysis (-f)
+#define CAPTURE_WINDOW_MS 1000
+#define CAPTURE_RING_LEN 8192
+#define CAPTURE_ROUNDS 7
+#define CAPTURE_INVALID 0xFFFF
+#define CAPTURE_BLOCK 1024
+/// Captures use all 12 bits of the conversion
+#define CAPTURE_LSB (RESOLUTION / 16)
+/// Voltage zero crossings queued from the PRU reader to the capture consumer
+#define CAPTURE_CROSSINGS 64
+/// Outlets drawing less than this (fundamental RMS, in A) have no meaningful power factor
+#define PF_MIN_CURRENT 0.8
+
+/*!
+ * @brief Counters of one PRU measurement window
+ */
+struct pru_window {
+  uint64_t start, end;  ///< Kicks opening and closing the window (CLOCK_MONOTONIC, in ns)
+  uint64_t received;    ///< Arrival of the counters
+  uint32_t glitch;      ///< Glitches detected
+  uint32_t edges;       ///< Line frequency edges
+  uint32_t duty_up;     ///< Loop iterations with the power factor signal high
+  uint32_t duty_down;   ///< Loop iterations with the power factor signal low
+
+  // From the edge timestamp ring, if the firmware streams it
+  uint32_t cycles;         ///< Line cycles timestamped
+  uint32_t edges_lost;     ///< Ring entries overwritten before being read (since startup)
+  double cycle_frequency;  ///< Mean line frequency over those cycles, in Hz
+  double jitter;           ///< Standard deviation of the cycle period, in us
+  double glitch_phase;     ///< Position of the last glitch within its line cycle, in degrees
+};
+
+/*!
+ * @brief One scan of every ADC channel, in scan order
+ */
+struct capture_frame {
+  uint64_t timestamp;           ///< CLOCK_MONOTONIC, in nanoseconds
+  uint16_t code[ADC_CHANNELS];  ///< Conversion results (CAPTURE_INVALID if invalid)
+};
 
-const char servers[11][16] = {
+/*!
+ * @brief Aggregation window: scans are buffered per channel, and handed to the DSP kernels one
+ * block at a time
+ */
+struct capture_window {
+  uint64_t start, end;
+  uint32_t scans;
+  uint16_t block[ADC_CHANNELS][CAPTURE_BLOCK];
+  uint32_t block_len;
+  struct dsp_stats stats[ADC_CHANNELS];
+  float fft[OUTLET_QUANTITY][FFT_SIZE];  ///< Current samples for harmonic analysis, in A
+  uint32_t fft_len;
+
+  // Power factor, kept across windows
+  uint64_t last_scan;
+  struct pf_reference reference;
+  struct pf_outlet pf[OUTLET_QUANTITY];
+};
+
+const char servers[11][REDIS_HOST_LEN] = {
     "10.0.38.59",    "10.0.38.46",    "10.0.38.42",    "10.128.153.81",
     "10.128.153.82", "10.128.153.83", "10.128.153.84", "10.128.153.85",
     "10.128.153.86", "10.128.153.87", "10.128.153.88",
 };
 
-redisContext *c, *c_remote;
+redisContext* c_remote;
+struct redis_transport local;
 char name[72];
-pthread_mutex_t spi_mutex;
-double duty = 1;
-uint32_t glitch;
-uint32_t frequency;
+
+// Latest PRU window, written by pru_reader only
+static struct pru_window pru_storage;
+static struct seqlock pru_snapshot;
+
+// Currents (outlets 1 to 7), then voltage
+static const uint8_t scan_order[ADC_CHANNELS] = {1, 2, 3, 4, 5, 6, 7, 0};
+
+static struct capture_frame capture_storage[CAPTURE_RING_LEN];
+static struct ring capture_ring;
+static atomic_uint capture_dropped;
+static uint8_t capture_enabled;
+static uint8_t harmonics_enabled;
+
+// Line voltage rising zero crossings (CLOCK_MONOTONIC, in ns), from the PRU edge ring
+static uint64_t crossing_storage[CAPTURE_CROSSINGS];
+static struct ring crossing_ring;
 
 /**
- * @brief Connects to a local Redis server (or exits, in case none are available)
+ * @brief Connects to the first available remote Redis server (or exits, in case none are
+ * available)
  * @returns void
  */
-void connect_local() {
-  do {
-    syslog(LOG_NOTICE, "Attempting to reconnect to local Redis database...");
-    c = redisConnectWithTimeout("127.0.0.1", 6379, (struct timeval){1, 500000});
-
-    if (c->err) {
-      if (c->err == 1)
-        syslog(LOG_ERR,
-               "Redis server instance not available. Have you "
-               "initialized the Redis server? (Error code 1)\n");
-      else
-        syslog(LOG_ERR, "Unknown redis error (error code %d)\n", c->err);
-
-      nanosleep((const struct timespec[]){{0, 700000000L}}, NULL);  // 700ms
-    }
+void connect_remote() {
+  syslog(LOG_NOTICE, "Attempting to reconnect to remote Redis database...");
 
-  } while (c->err);
+  c_remote = redis_connect(servers, sizeof(servers) / sizeof(servers[0]), 1);
 
-  redisSetTimeout(c, (struct timeval){0, 500000});
+  if (c_remote == NULL) {
+    syslog(LOG_ERR, "No server found");
+    exit(-3);
+  }
 }
 
 /**
- * @brief Connects to remote Redis server (or exits, in case none are available)
- * @returns void
+ * @brief Makes sure the command server sends keyspace notifications for hashes
+ * @details The server is expected to be configured with `notify-keyspace-events` including `Kh`
+ * (redis.conf). Only when those flags are missing are they added with CONFIG SET, keeping any
+ * flags already set.
+ * @retval 0 Notifications are enabled
+ * @retval -1 Notifications are off and could not be enabled (CONFIG refused or disabled)
  */
-void connect_remote() {
-  int server_i = 0;
-  int server_amount = sizeof(servers) / sizeof(servers[0]);
-  syslog(LOG_NOTICE, "Attempting to reconnect to remote Redis database...");
+static int8_t enable_notifications() {
+  redisReply *reply, *set_reply;
+  char flags[32] = "";
+  int8_t rslt = 0;
 
-  do {
-    c_remote = redisConnectWithTimeout(servers[server_i], 6379, (struct timeval){1, 500000});
+  reply = redisCommand(c_remote, "CONFIG GET notify-keyspace-events");
 
-    if (c_remote->err) {
-      syslog(LOG_ERR, "%s remote Redis server not available, switching...\n", servers[server_i++]);
+  if (reply != NULL && reply->type == REDIS_REPLY_ARRAY && reply->elements == 2 &&
+      reply->element[1]->str != NULL)
+    snprintf(flags, sizeof(flags) - 2, "%s", reply->element[1]->str);
+  freeReplyObject(reply);
 
-      nanosleep((const struct timespec[]){{1, 0}}, NULL);  // 1s
-    }
+  if (strchr(flags, 'K') && (strchr(flags, 'h') || strchr(flags, 'A')))
+    return 0;
+
+  if (!strchr(flags, 'K'))
+    strcat(flags, "K");
+  if (!strchr(flags, 'h'))
+    strcat(flags, "h");
+
+  set_reply = redisCommand(c_remote, "CONFIG SET notify-keyspace-events %s", flags);
+  if (set_reply == NULL || set_reply->type == REDIS_REPLY_ERROR) {
+    syslog(LOG_WARNING, "Keyspace notifications are off on the command server (set "
+           "notify-keyspace-events to include Kh)");
+    rslt = -1;
+  }
+  freeReplyObject(set_reply);
+
+  return rslt;
+}
+
+/**
+ * @brief Subscribes to changes of the outlet command hash, on the command server
+ * @returns Subscribed connection
+ * @retval NULL Subscription failed, or the server does not notify (commands are then polled)
+ */
+static redisContext* subscribe_commands() {
+  redisContext* sub;
+  redisReply* reply;
+
+  if (enable_notifications()) {
+    syslog(LOG_WARNING, "Polling outlet commands every %d s", COMMAND_POLL_S);
+    return NULL;
+  }
+
+  sub = redisConnectWithTimeout(c_remote->tcp.host, REDIS_PORT, (struct timeval){1, 500000});
+  if (sub == NULL || sub->err) {
+    redisFree(sub);
+    return NULL;
+  }
+
+  reply = redisCommand(sub, "SUBSCRIBE " KEYSPACE_CHANNEL "%s", name);
 
-    if (server_i == server_amount) {
-      syslog(LOG_ERR, "No server found");
-      exit(-3);
+  if (reply == NULL || reply->type != REDIS_REPLY_ARRAY) {
+    syslog(LOG_WARNING, "Could not subscribe to outlet commands, polling every %d s",
+           COMMAND_POLL_S);
+    freeReplyObject(reply);
+    redisFree(sub);
+    return NULL;
+  }
+
+  freeReplyObject(reply);
+  syslog(LOG_NOTICE, "Subscribed to outlet commands");
+  return sub;
+}
+
+/**
+ * @brief Waits for a change notification on the outlet command hash
+ * @param[in] sub Subscribed connection
+ * @param[in] timeout_ms Longest wait
+ * @retval 1 The hash changed
+ * @retval 0 Timed out
+ * @retval -1 Connection lost
+ */
+static int8_t wait_notification(redisContext* sub, int timeout_ms) {
+  struct pollfd pfd = {.fd = sub->fd, .events = POLLIN};
+  redisReply* reply;
+  int8_t changed = 0;
+
+  if (poll(&pfd, 1, timeout_ms) <= 0)
+    return 0;
+
+  if (redisBufferRead(sub) != REDIS_OK)
+    return -1;
+
+  // Every notification already received is consumed, so a burst of changes applies once
+  while (redisGetReplyFromReader(sub, (void**)&reply) == REDIS_OK && reply != NULL) {
+    if (reply->type == REDIS_REPLY_ARRAY && reply->elements == 3 &&
+        reply->element[0]->str != NULL && strcmp(reply->element[0]->str, "message") == 0)
+      changed = 1;
+    freeReplyObject(reply);
+  }
+
+  return sub->err ? -1 : changed;
+}
+
+/**
+ * @brief Applies the outlet commands stored on the command server, and records the applied state
+ * @retval 0 OK
+ * @retval -1 Connection lost
+ */
+static int8_t apply_commands() {
+  redisReply *reply, *up_reply, *rb_reply;
+  uint8_t command;
+  char msg_command[1] = {0x00};
+  int8_t rslt = 0;
+
+  reply = redisCommand(c_remote, "HMGET %s 0 1 2 3 4 5 6", name);
+  up_reply = redisCommand(c_remote, "HMGET %s:RB 0 1 2 3 4 5 6", name);
+
+  if (reply == NULL || up_reply == NULL) {
+    // Connection lost, hiredis contexts are unusable after an I/O error
+    freeReplyObject(reply);
+    freeReplyObject(up_reply);
+    return -1;
+  }
+
+  if (reply->type == REDIS_REPLY_ARRAY) {
+    for (int i = 0; i < (int)reply->elements; i++) {
+      // Last applied command, if recorded
+      const char* applied = up_reply->type == REDIS_REPLY_ARRAY && i < (int)up_reply->elements
+                                ? up_reply->element[i]->str
+                                : NULL;
+
+      if (reply->element[i]->str != NULL) {
+        command = reply->element[i]->str[0] - '0';
+
+        if (command != 1 && command != 0) {
+          syslog(LOG_ERR, "Received malformed command: %d", command);
+          // Rolled back to the last applied command, or to off (as the outlet is switched)
+          rb_reply =
+              redisCommand(c_remote, "HSET %s %d %d", name, i, applied ? applied[0] - '0' : 0);
+          freeReplyObject(rb_reply);
+          continue;
+        }
+
+        msg_command[0] += command << (i + 1);
+
+        if (applied == NULL || reply->element[i]->str[0] != applied[0]) {
+          syslog(LOG_NOTICE, "User %s switched outlet %d %s", reply->element[i]->str + 2, i,
+                 command == 1 ? "on" : "off");
+          rb_reply = redisCommand(c_remote, "HSET %s:RB %d %d", name, i, command);
+          freeReplyObject(rb_reply);
+        }
+      }
     }
-  } while (c_remote->err);
+    spi_bus_lock(SPI_URGENT);
+    write_data(ACTUATION_CHANNEL, msg_command, 1);
+    spi_bus_unlock();
+  } else if (reply->type == REDIS_REPLY_ERROR) {
+    rslt = -1;
+  }
+
+  freeReplyObject(reply);
+  freeReplyObject(up_reply);
 
-  redisSetTimeout(c_remote, (struct timeval){0, 500000});
+  return rslt;
 }
 
 /**
  * @brief Listens for commands sent to the Redis key on the main server
+ * @details Outlets are switched as soon as a keyspace notification reports a change to the
+ * command hash. The hash is also read back every COMMAND_RECONCILE_S, in case a notification was
+ * lost, and every COMMAND_POLL_S while no subscription is possible, in which case subscribing is
+ * retried every COMMAND_RECONCILE_S.
  * @returns void
  */
 void* command_listener() {
   redisReply *reply, *up_reply, *rb_reply;
-  uint8_t command;
+  redisContext* sub = NULL;
+  uint8_t command, polls = 0;
   char msg_command[1] = {0x00};
 
-  const struct timespec* period = (const struct timespec[]){{2, 0}};
+  const struct timespec* period = (const struct timespec[]){{COMMAND_POLL_S, 0}};
 
   connect_remote();
   syslog(LOG_NOTICE, "Redis command DB connected");
@@ -117,9 +357,9 @@ void* command_listener() {
         msg_command[0] += command << (i + 1);
       }
     }
-    pthread_mutex_lock(&spi_mutex);
+    spi_bus_lock(SPI_URGENT);
     write_data(ACTUATION_CHANNEL, msg_command, 1);
-    pthread_mutex_unlock(&spi_mutex);
+    spi_bus_unlock();
   } else {
     // Sets default values if they do not exist already
     reply = redisCommand(c_remote, "HSET %s 0 1 1 1 2 1 3 1 4 1 5 1 6 1", name);
@@ -127,106 +367,614 @@ void* command_listener() {
   freeReplyObject(up_reply);
   freeReplyObject(reply);
 
-  while (1) {
-    reply = redisCommand(c_remote, "HMGET %s 0 1 2 3 4 5 6", name);
-    up_reply = redisCommand(c_remote, "HMGET %s:RB 0 1 2 3 4 5 6", name);
-
-    msg_command[0] = 0x00;
-
-    if (reply->type == REDIS_REPLY_ARRAY) {
-      for (int i = 0; i < (int)reply->elements; i++) {
-        if (reply->element[i]->str != NULL) {
-          command = reply->element[i]->str[0] - '0';
-
-          if (command != 1 && command != 0) {
-            syslog(LOG_ERR, "Received malformed command: %d", command);
-            rb_reply = redisCommand(c_remote, "HSET %s %d %d", name, i,
-                                    up_reply->element[i]->str[0] - '0');
-            freeReplyObject(rb_reply);
-            continue;
-          }
-
-          msg_command[0] += command << (i + 1);
-
-          if (up_reply->element[i]->str == NULL ||
-              reply->element[i]->str[0] != up_reply->element[i]->str[0]) {
-            syslog(LOG_NOTICE, "User %s switched outlet %d %s", reply->element[i]->str + 2, i,
-                   command == 1 ? "on" : "off");
-            rb_reply = redisCommand(c_remote, "HSET %s:RB %d %d", name, i, command);
-            freeReplyObject(rb_reply);
-          }
-        }
-      }
-      pthread_mutex_lock(&spi_mutex);
-      write_data(ACTUATION_CHANNEL, msg_command, 1);
-      pthread_mutex_unlock(&spi_mutex);
-    } else if (reply->type == REDIS_REPLY_ERROR) {
+  for (;;) {
+    // Subscribing first, so that no change slips in between reading the hash and waiting
+    if (sub == NULL && polls == 0)
+      sub = subscribe_commands();
+
+    if (apply_commands()) {
+      redisFree(sub);
+      sub = NULL;
+      redisFree(c_remote);
       connect_remote();
+      continue;
     }
 
-    freeReplyObject(reply);
-    freeReplyObject(up_reply);
+    if (sub == NULL) {
+      polls = (polls + 1) % (COMMAND_RECONCILE_S / COMMAND_POLL_S);
+      nanosleep(period, NULL);
+      continue;
+    }
 
-    nanosleep(period, NULL);
+    if (wait_notification(sub, COMMAND_RECONCILE_S * 1000) < 0) {
+      syslog(LOG_WARNING, "Lost outlet command subscription");
+      redisFree(sub);
+      sub = NULL;
+    }
   }
 }
 
+static uint64_t timestamp_ns(const struct timespec* ts) {
+  return ts->tv_sec * 1000000000ULL + ts->tv_nsec;
+}
+
+static uint64_t now_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return timestamp_ns(&ts);
+}
+
+static uint32_t le32(const uint8_t* buf) {
+  return buf[3] << 24 | buf[2] << 16 | buf[1] << 8 | buf[0];
+}
+
 /**
- * @brief Gets glitch count, frequency and duty cycle information from the PRU
+ * @brief Kicks the PRU counter firmware, which opens or closes a window
+ * @returns Time of the kick (CLOCK_MONOTONIC, in ns)
+ */
+static uint64_t pru_kick(int fd) {
+  uint64_t now = now_ns();
+
+  if (hal_write(fd, "-", 1) != 1) {
+    syslog(LOG_ERR, "Failed to kick PRU1: %s", strerror(errno));
+    exit(-9);
+  }
+  return now;
+}
+
+/**
+ * @brief Creates a periodic CLOCK_MONOTONIC timer and adds it to an epoll instance
+ * @returns Timer descriptor (or exits, in case of failure)
+ */
+static int pru_timer(int epoll_fd, uint32_t period_ms) {
+  const struct timespec ts = {period_ms / 1000, period_ms % 1000 * 1000000L};
+  const struct itimerspec period = {ts, ts};
+  struct epoll_event event = {.events = EPOLLIN};
+  int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+
+  event.data.fd = fd;
+  if (fd < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) ||
+      timerfd_settime(fd, 0, &period, NULL)) {
+    syslog(LOG_ERR, "Failed to set up PRU1 timer: %s", strerror(errno));
+    exit(-9);
+  }
+  return fd;
+}
+
+/**
+ * @brief Drains the edge timestamp ring into the window statistics, and hands the voltage zero
+ * crossings over to the capture consumer
+ * @details When the firmware has lapped the reader, cycle and power factor tracking restart at the
+ * next edge, so no period or high time spans the lost entries.
+ * @param[in, out] clock IEP clock mapping (NULL if unavailable)
  * @returns void
  */
-void* glitch_counter() {
-  struct pollfd prufd;
-  const struct timespec* period = (const struct timespec[]){{0, 500000L}};
+static void pru_drain(struct pru_ring_reader* reader,
+                      struct pru_edges* edges,
+                      struct pru_clock* clock) {
+  static struct pru_ring_entry entries[PRU_RING_LEN];
+  uint32_t lost = reader->lost;
+  uint32_t count = pru_ring_read(reader, entries, PRU_RING_LEN);
+  uint64_t crossing;
+
+  // Edges read after a gap cannot be paired with those before it
+  if (reader->lost != lost)
+    edges->cycle_valid = edges->pf_valid = 0;
+
+  pru_edges_update(edges, entries, count);
+
+  if (!capture_enabled || clock == NULL)
+    return;
+
+  pru_clock_sync(clock);
+  for (uint32_t k = 0; k < count; k++) {
+    if (!(entries[k].changed & entries[k].pins & PRU_PIN_FREQUENCY))
+      continue;
 
-  prufd.fd = open(PRU1_DEVICE_NAME, O_RDWR);
-  char buf[16];
+    crossing = pru_clock_ns(clock, entries[k].timestamp);
+    if (ring_push(&crossing_ring, &crossing))
+      break;
+  }
+}
 
-  if (prufd.fd < 0) {
+/**
+ * @brief Gets glitch count, frequency and duty cycle information from the PRU
+ * @details Windows are closed on a CLOCK_MONOTONIC timerfd and a new one is opened as soon as the
+ * firmware has answered, so the thread only wakes up for a timer tick or a message. Each window
+ * carries the timestamps of the kicks bounding it, which makes rates independent of scheduling
+ * delays. If the firmware streams edge timestamps, the ring is drained on a second timer and each
+ * window also gets per-cycle frequency, jitter and glitch timing. Results are published through
+ * pru_snapshot.
+ * @returns void
+ */
+void* pru_reader() {
+  struct epoll_event event = {.events = EPOLLIN}, events[3];
+  struct pru_window window = {0};
+  struct pru_ring_reader reader;
+  struct pru_edges edges = {0};
+  struct pru_clock clock;
+  uint8_t buf[PRU_MSG_LEN], pending = 0, late = 0, streaming;
+  uint64_t ticks;
+  int pru_fd, timer_fd, drain_fd = -1, epoll_fd, ready, rslt;
+  uint8_t synced = 0;
+
+  pru_fd = hal_open(PRU1_DEVICE_NAME, O_RDWR | O_NONBLOCK);
+  epoll_fd = epoll_create1(0);
+
+  if (pru_fd < 0) {
     syslog(LOG_ERR, "Failed to communicate with PRU1");
     exit(-9);
   }
 
+  event.data.fd = pru_fd;
+  if (epoll_fd < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pru_fd, &event)) {
+    syslog(LOG_ERR, "Failed to set up PRU1 event loop: %s", strerror(errno));
+    exit(-9);
+  }
+
+  rslt = pru_ring_open(&reader);
+  streaming = rslt == 0;
+  pru_edges_reset(&edges);
+
+  if (streaming) {
+    drain_fd = pru_timer(epoll_fd, PRU_RING_POLL_MS);
+    synced = pru_clock_open(&clock) == 0;
+  }
+  else if (rslt == -2)
+    syslog(LOG_NOTICE, "PRU1 firmware does not stream edge timestamps");
+
+  window.start = pru_kick(pru_fd);
+  timer_fd = pru_timer(epoll_fd, PRU_WINDOW_MS);
+
   for (;;) {
-    write(prufd.fd, "-", 1);
-    usleep(4999600);
-    write(prufd.fd, "-", 1);
-
-    if (read(prufd.fd, buf, sizeof(buf))) {
-      double duty_up = (buf[11] << 24) | (buf[10] << 16) | (buf[9] << 8) | buf[8];
-      double duty_down = (buf[15] << 24) | (buf[14] << 16) | (buf[13] << 8) | buf[12];
-      frequency = (buf[7] << 24) | (buf[6] << 16) | (buf[5] << 8) | buf[4];
-      duty = duty_up / (duty_up + duty_down);
-      glitch = (buf[3] << 24) | (buf[2] << 16) | (buf[1] << 8) | buf[0];
-
-      read(prufd.fd, buf, 16);
+    ready = epoll_wait(epoll_fd, events, 3, -1);
+
+    for (int i = 0; i < ready; i++) {
+      if (events[i].data.fd == drain_fd) {
+        if (read(drain_fd, &ticks, sizeof(ticks)) == sizeof(ticks))
+          pru_drain(&reader, &edges, synced ? &clock : NULL);
+        continue;
+      }
+
+      if (events[i].data.fd == timer_fd) {
+        if (read(timer_fd, &ticks, sizeof(ticks)) != sizeof(ticks))
+          continue;
+
+        // The previous window is still waiting on the firmware, it is closed on its answer
+        if (pending) {
+          if (!late++)
+            syslog(LOG_WARNING, "PRU1 is late answering a measurement window");
+          continue;
+        }
+
+        window.end = pru_kick(pru_fd);
+        pending = PRU_REPLIES;
+
+        if (streaming) {
+          pru_drain(&reader, &edges, synced ? &clock : NULL);
+          window.cycles = edges.cycles;
+          window.edges_lost = reader.lost;
+          window.cycle_frequency = pru_edges_frequency(&edges);
+          window.jitter = pru_edges_jitter(&edges);
+          window.glitch_phase = pru_edges_glitch_phase(&edges);
+          pru_edges_reset(&edges);
+        }
+        continue;
+      }
+
+      // Messages are drained even when none is expected, as the descriptor stays readable
+      while (hal_read(pru_fd, buf, sizeof(buf)) == sizeof(buf)) {
+        if (pending == PRU_REPLIES) {
+          window.received = now_ns();
+          window.glitch = le32(buf);
+          window.edges = le32(buf + 4);
+          window.duty_up = le32(buf + 8);
+          window.duty_down = le32(buf + 12);
+          seqlock_write(&pru_snapshot, &window);
+        }
+
+        // Both answers are in, the next window opens right away
+        if (pending && --pending == 0) {
+          late = 0;
+          window.start = pru_kick(pru_fd);
+        }
+      }
     }
-    nanosleep(period, NULL);
   }
 }
 
 /**
- * @brief Calculate actual voltage, by picking out the 8 bits in the middle of the ADCs response
- * @param[in] buffer ADC response buffer
+ * @brief Calculate actual voltage, by picking out the 8 most significant bits of the conversion
+ * @param[in] sample ADC conversion
  * @returns Actual voltage value
  */
-double calc_voltage(char* buffer) {
-  return (((buffer[1] & 0x0F) * 16) + ((buffer[0] & 0xF0) >> 4)) * RESOLUTION;
+double calc_voltage(const struct adc_sample* sample) {
+  return (sample->code >> 4) * RESOLUTION;
+}
+
+/**
+ * @brief Publishes power factor, glitch and frequency information
+ * @param[in] low_current Whether every outlet draws little current (power factor is then 1)
+ * @returns void
+ */
+void publish_pru(uint8_t low_current) {
+  struct pru_window window;
+  double duty = 1, seconds;
+
+  seqlock_read(&pru_snapshot, &window);
+  seconds = (window.end - window.start) / 1e9;
+
+  if (window.duty_up + window.duty_down > 0)
+    duty = (double)window.duty_up / ((double)window.duty_up + window.duty_down);
+
+  redis_enqueue(&local, "SET pfactor %.3f", low_current ? 1.0 : duty);
+  redis_enqueue(&local, "SET glitch %u", window.glitch);
+
+  // Cycle periods from the edge ring are exact; the counters are the fallback
+  if (window.cycles > 0) {
+    redis_enqueue(&local, "SET frequency %.3f", window.cycle_frequency);
+    redis_enqueue(&local, "SET frequency_jitter %.2f", window.jitter);
+    redis_enqueue(&local, "SET glitch_phase %.1f", window.glitch_phase);
+    redis_enqueue(&local, "SET pru_edges_lost %u", window.edges_lost);
+  } else if (window.edges > 0 && seconds > 0) {
+    redis_enqueue(&local, "SET frequency %.2f", window.edges / seconds);
+  }
+}
+
+/**
+ * @brief Scans ADC channels, letting actuation commands take the bus between chunks
+ * @details Chunks of ADC_SCAN_CHUNK conversions carry the ADC pipeline from one to the next, so an
+ * uninterrupted scan takes a single frame more than its channels. When an actuation command waits,
+ * the pending conversion is read out before the bus is released. The ADC is selected at the start
+ * of the scan and again whenever the bus comes back, as other threads and processes (leak, bme)
+ * move the module selector; the one-byte selector write is cheap next to a chunk.
+ * @param[in] channels Channels to convert, in order
+ * @param[in] count Amount of channels
+ * @param[out] samples Decoded conversions, in the same order as `channels`
+ * @retval 0 Success
+ * @retval -1 Failure
+ */
+static int scan_adc(const uint8_t* channels, uint8_t count, struct adc_sample* samples) {
+  char adc_select[2];
+  uint8_t done = 0, len, carried = 0;
+  int rslt = 0;
+
+  spi_bus_lock(SPI_BACKGROUND);
+
+  while (done < count && rslt == 0) {
+    if (!carried) {
+      // Selector response is shifted back into the buffer, so it must be writable
+      memcpy(adc_select, "\x01\x01", 2);
+      rslt = transfer_module(adc_select, 2);
+      if (rslt)
+        break;
+    }
+
+    len = count - done < ADC_SCAN_CHUNK ? count - done : ADC_SCAN_CHUNK;
+    rslt = adc_scan_part(channels + done, len, carried, done + len == count, samples + done);
+    done += len;
+    carried = done < count;
+
+    if (rslt == 0 && carried && spi_bus_contended()) {
+      rslt = adc_scan_part(channels + done, 0, 1, 1, samples + done);
+      carried = 0;
+
+      spi_bus_unlock();
+      spi_bus_lock(SPI_BACKGROUND);
+    }
+  }
+
+  spi_bus_unlock();
+  return rslt;
+}
+
+/**
+ * @brief Samples every ADC channel continuously into the capture ring (capture mode producer)
+ * @details Every pass converts CAPTURE_ROUNDS scans through scan_adc(), so actuation commands
+ * still take the bus within ADC_SCAN_CHUNK conversions.
+ * @returns void
+ */
+void* adc_sampler() {
+  uint8_t channels[ADC_CHANNELS * CAPTURE_ROUNDS];
+  struct adc_sample samples[ADC_CHANNELS * CAPTURE_ROUNDS];
+  struct capture_frame frame;
+  struct timespec start, end;
+  uint64_t t0, t1;
+  int rslt;
+
+  for (uint8_t k = 0; k < sizeof(channels); k++)
+    channels[k] = scan_order[k % ADC_CHANNELS];
+
+  for (;;) {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    rslt = scan_adc(channels, sizeof(channels), samples);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (rslt) {
+      syslog(LOG_CRIT, "Communication error while capturing from ADC: %s", strerror(errno));
+      exit(-2);
+    }
+
+    // Scans are evenly spread over the message
+    t0 = timestamp_ns(&start);
+    t1 = timestamp_ns(&end);
+
+    for (uint8_t r = 0; r < CAPTURE_ROUNDS; r++) {
+      const struct adc_sample* scan = &samples[r * ADC_CHANNELS];
+
+      frame.timestamp = t0 + (t1 - t0) * (r + 1) / CAPTURE_ROUNDS;
+      for (uint8_t ch = 0; ch < ADC_CHANNELS; ch++)
+        frame.code[ch] = scan[ch].valid ? scan[ch].code : CAPTURE_INVALID;
+
+      if (ring_push(&capture_ring, &frame))
+        atomic_fetch_add(&capture_dropped, 1);
+    }
+  }
+}
+
+/**
+ * @brief Runs the DSP kernels over the scans buffered in a window
+ * @returns void
+ */
+static void capture_flush(struct capture_window* w) {
+  float values[CAPTURE_BLOCK];
+  uint32_t fft_take = 0;
+
+  // Harmonic analysis takes the first FFT_SIZE scans after each analysis
+  if (harmonics_enabled)
+    fft_take = FFT_SIZE - w->fft_len < w->block_len ? FFT_SIZE - w->fft_len : w->block_len;
+
+  for (uint8_t ch = 0; ch < ADC_CHANNELS; ch++) {
+    // Currents are converted to A, the voltage is kept as seen by the ADC
+    if (scan_order[ch] != 0)
+      dsp_convert(w->block[ch], w->block_len, CAPTURE_LSB / 0.66, -2.5 / 0.66, values);
+    else
+      dsp_convert(w->block[ch], w->block_len, CAPTURE_LSB, 0, values);
+
+    dsp_stats_update(&w->stats[ch], values, w->block_len);
+
+    if (ch < OUTLET_QUANTITY && fft_take)
+      memcpy(&w->fft[ch][w->fft_len], values, fft_take * sizeof(float));
+  }
+
+  w->fft_len += fft_take;
+  w->block_len = 0;
+}
+
+/**
+ * @brief Feeds a scan's currents to the power factor engine
+ * @details Channels are converted one after the other over the scan, so each sample is placed
+ * back at its own conversion time rather than at the end of the scan.
+ * @returns void
+ */
+static void capture_add_pf(struct capture_window* w, const struct capture_frame* frame) {
+  uint64_t scan_ns = frame->timestamp - w->last_scan;
+
+  // Gaps (or the first scan) give no estimate of the scan duration
+  if (w->last_scan == 0 || scan_ns > 5000000)
+    scan_ns = 0;
+  w->last_scan = frame->timestamp;
+
+  for (uint8_t ch = 0; ch < OUTLET_QUANTITY; ch++) {
+    pf_add(&w->pf[ch], &w->reference,
+           frame->timestamp - (ADC_CHANNELS - 1 - ch) * scan_ns / ADC_CHANNELS,
+           (frame->code[ch] * CAPTURE_LSB - 2.5) / 0.66);
+  }
+}
+
+/**
+ * @brief Adds a scan to the window, running the kernels whenever a block fills up
+ * @details Scans with any invalid conversion are skipped, so that every channel stays aligned.
+ * @returns void
+ */
+static void capture_add(struct capture_window* w, const struct capture_frame* frame) {
+  for (uint8_t ch = 0; ch < ADC_CHANNELS; ch++) {
+    if (frame->code[ch] == CAPTURE_INVALID)
+      return;
+  }
+
+  if (w->scans++ == 0) {
+    w->start = frame->timestamp;
+    for (uint8_t ch = 0; ch < ADC_CHANNELS; ch++)
+      dsp_stats_init(&w->stats[ch]);
+  }
+  w->end = frame->timestamp;
+
+  for (uint8_t ch = 0; ch < ADC_CHANNELS; ch++)
+    w->block[ch][w->block_len] = frame->code[ch];
+
+  capture_add_pf(w, frame);
+
+  if (++w->block_len == CAPTURE_BLOCK)
+    capture_flush(w);
+}
+
+/**
+ * @brief Publishes a set of per-outlet values as a single hash
+ * @param[in] key Hash key
+ * @param[in] values Values, in scan order
+ * @returns void
+ */
+static void publish_outlets(const char* key, const double* values) {
+  redis_enqueue(&local, "HSET %s 0 %.3f 1 %.3f 2 %.3f 3 %.3f 4 %.3f 5 %.3f 6 %.3f", key, values[6],
+                values[5], values[4], values[3], values[2], values[1], values[0]);
+}
+
+/**
+ * @brief Runs and publishes the harmonic analysis of every outlet, once FFT_SIZE scans are in
+ * @details Only harmonics below the Nyquist frequency are published (and count in the THD); keys
+ * of the orders above it are deleted rather than left stale or read as 0.
+ * @param[in, out] w Window
+ * @param[in] sample_rate Scan rate, in Hz
+ * @returns void
+ */
+static void capture_publish_harmonics(struct capture_window* w, double sample_rate) {
+  static uint8_t warned, published = FFT_HARMONICS;
+  struct fft_harmonics h;
+  double fundamental[OUTLET_QUANTITY], thd[OUTLET_QUANTITY];
+  double orders[FFT_HARMONICS + 1][OUTLET_QUANTITY];
+  double frequency = 0, strongest = 0;
+  uint8_t resolved = 1;
+  char key[16];
+
+  if (w->fft_len < FFT_SIZE)
+    return;
+  w->fft_len = 0;
+
+  for (uint8_t i = 0; i < OUTLET_QUANTITY; i++) {
+    if (fft_harmonics(w->fft[i], sample_rate, &h)) {
+      if (!warned++)
+        syslog(LOG_WARNING, "Scan rate too low for harmonic analysis (%.1f Hz)", sample_rate);
+      return;
+    }
+
+    fundamental[i] = h.magnitude[1];
+    thd[i] = h.thd;
+    for (uint8_t order = 2; order <= FFT_HARMONICS; order++)
+      orders[order][i] = h.magnitude[order];
+
+    // The most loaded outlet gives the best estimate of the line frequency, and so of the orders
+    if (h.magnitude[1] > strongest) {
+      strongest = h.magnitude[1];
+      frequency = h.frequency;
+      resolved = h.orders;
+    }
+  }
+
+  publish_outlets("ich_fund", fundamental);
+  publish_outlets("ich_thd", thd);
+  for (uint8_t order = 2; order <= resolved; order++) {
+    snprintf(key, sizeof(key), "ich_h%d", order);
+    publish_outlets(key, orders[order]);
+  }
+  for (uint8_t order = resolved + 1; order <= published; order++) {
+    snprintf(key, sizeof(key), "ich_h%d", order);
+    redis_enqueue(&local, "DEL %s", key);
+  }
+  published = resolved;
+
+  redis_enqueue(&local, "SET fft_orders %d", resolved);
+  redis_enqueue(&local, "SET fft_frequency %.2f", frequency);
+}
+
+/**
+ * @brief Computes and publishes a window's aggregates
+ * @details RMS and peak are taken around the window's mean, so that transducer offset drift does
+ * not show up as current. Energy is apparent energy (line voltage times RMS current), accumulated
+ * since startup.
+ * @param[in, out] w Window (its remaining scans are flushed)
+ * @param[in, out] energy Accumulated energy per outlet, in Wh
+ * @returns void
+ */
+static void capture_publish(struct capture_window* w, double* energy) {
+  double rms[OUTLET_QUANTITY], peak[OUTLET_QUANTITY], crest[OUTLET_QUANTITY];
+  double pf[OUTLET_QUANTITY], pf_cycle[OUTLET_QUANTITY];
+  double seconds = (w->end - w->start) / 1e9;
+  double voltage;
+  uint8_t low_current = 1;
+
+  capture_flush(w);
+  voltage = dsp_mean(&w->stats[OUTLET_QUANTITY]) * VOLTAGE_CONST;
+
+  for (uint8_t i = 0; i < OUTLET_QUANTITY; i++) {
+    rms[i] = dsp_ac_rms(&w->stats[i]);
+    peak[i] = dsp_peak(&w->stats[i]);
+    crest[i] = rms[i] > 0 ? peak[i] / rms[i] : 0;
+    pf[i] = pf_rolling(&w->pf[i]);
+    pf_cycle[i] = w->pf[i].last;
+    energy[i] += voltage * rms[i] * seconds / 3600;
+
+    if (rms[i] > 0.8)
+      low_current = 0;
+  }
+
+  if (voltage != 0.0)
+    redis_enqueue(&local, "SET volt %.3f", voltage);
+
+  publish_outlets("ich", rms);
+  publish_outlets("ich_peak", peak);
+  publish_outlets("ich_crest", crest);
+  publish_outlets("ich_energy", energy);
+  publish_pru(low_current);
+
+  if (w->reference.period > 0) {
+    publish_outlets("ich_pf", pf);
+    publish_outlets("ich_pf_cycle", pf_cycle);
+  }
+
+  if (harmonics_enabled && seconds > 0)
+    capture_publish_harmonics(w, (w->scans - 1) / seconds);
+
+  redis_enqueue(&local, "SET capture_rate %.1f", seconds > 0 ? (w->scans - 1) / seconds : 0);
+  redis_enqueue(&local, "SET capture_dropped %u", atomic_load(&capture_dropped));
+  redis_enqueue_metrics(&local, &local);
+}
+
+/**
+ * @brief Aggregates captured scans into windows and publishes them (capture mode consumer)
+ * @param[in] window_ms Window length, in milliseconds
+ * @returns void
+ */
+void capture_consume(uint32_t window_ms) {
+  const struct timespec* idle = (const struct timespec[]){{0, 1000000L}};
+  double energy[OUTLET_QUANTITY] = {0};
+  static struct capture_window w;
+  struct capture_frame frame;
+  uint64_t crossing;
+
+  for (uint8_t i = 0; i < OUTLET_QUANTITY; i++)
+    pf_outlet_init(&w.pf[i], PF_MIN_CURRENT);
+
+  for (;;) {
+    while (ring_pop(&crossing_ring, &crossing) == 0)
+      pf_reference_update(&w.reference, crossing);
+
+    if (ring_pop(&capture_ring, &frame)) {
+      nanosleep(idle, NULL);
+      continue;
+    }
+
+    capture_add(&w, &frame);
+
+    if (w.end - w.start >= window_ms * 1000000ULL) {
+      capture_publish(&w, energy);
+      w.scans = 0;
+      w.start = w.end = 0;
+    }
+  }
 }
 
 int main(int argc, char* argv[]) {
   const struct timespec* inner_period = (const struct timespec[]){{1, 500000000L}};
+  uint32_t window_ms = CAPTURE_WINDOW_MS;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "cfw:")) != -1) {
+    if (opt == 'c') {
+      capture_enabled = 1;
+    } else if (opt == 'f') {
+      capture_enabled = 1;
+      harmonics_enabled = 1;
+    } else if (opt == 'w' && atoi(optarg) > 0) {
+      window_ms = atoi(optarg);
+    } else {
+      fprintf(stderr, "Usage: %s [-c] [-f] [-w window_ms]\n", argv[0]);
+      return -1;
+    }
+  }
 
   openlog("simar", 0, LOG_LOCAL0);
+  redisContext* c;
   redisReply* reply;
 
   syslog(LOG_NOTICE, "Starting up...");
 
-  connect_local();
+  c = redis_connect(redis_local, 1, -1);
 
   syslog(LOG_NOTICE, "Redis voltage DB connected");
 
-  char message[2] = {16, 0};
+  struct adc_sample samples[ADC_CHANNELS];
   char buffer[3];
   double current[7];
   double voltage = 0;
@@ -234,29 +982,28 @@ int main(int argc, char* argv[]) {
   uint8_t bpw = 16;
   uint32_t speed = 200000;
 
-  pthread_mutex_init(&spi_mutex, NULL);
+  seqlock_init(&pru_snapshot, &pru_storage, sizeof(pru_storage));
+  ring_init(&crossing_ring, crossing_storage, CAPTURE_CROSSINGS, sizeof(uint64_t));
 
-  int spi_fd = spi_open("/dev/spidev0.0", &mode, &bpw, &speed);
+  spi_open("/dev/spidev0.0", &mode, &bpw, &speed);
 
   pthread_t cmd_thread;
   pthread_create(&cmd_thread, NULL, command_listener, NULL);
 
-  pthread_t glitch_thread;
-  pthread_create(&glitch_thread, NULL, glitch_counter, NULL);
+  pthread_t pru_thread;
+  pthread_create(&pru_thread, NULL, pru_reader, NULL);
 
   syslog(LOG_NOTICE, "All threads initialized");
 
   // Dummy conversions
-  pthread_mutex_lock(&spi_mutex);
+  spi_bus_lock(SPI_BACKGROUND);
 
   spi_transfer("\x0F\x0F", buffer, 2);
   spi_transfer("\x0F\x0F", buffer, 2);
 
-  pthread_mutex_unlock(&spi_mutex);
+  spi_bus_unlock();
 
   uint8_t i, read_fails = 0, low_current;
-  struct timeval timeout = {5, 0};
-  redisSetTimeout(c, timeout);
 
   syslog(LOG_NOTICE, "Main loop starting...");
 
@@ -268,48 +1015,40 @@ int main(int argc, char* argv[]) {
     exit(-9);
 
   freeReplyObject(reply);
+  redisFree(c);
 
-  for (;;) {
-    pthread_mutex_lock(&spi_mutex);
-    transfer_module("\x01\x01", 2);
-
-    // Current
-    for (i = 1; i < 8; i++) {
-      message[1] = 131 + i * 4;
-
-      if (write(spi_fd, message, 2) < 1) {
-        syslog(LOG_CRIT,
-               "Communication error while writing to ADC, reading current from channel %d: %s", i,
-               strerror(errno));
-        return -2;
-      }
+  if (redis_transport_init(&local, "volt_local", redis_local, 1)) {
+    syslog(LOG_CRIT, "Could not start the Redis transport");
+    exit(DB_FAIL);
+  }
 
-      if (read(spi_fd, buffer, 2) < 1) {
-        syslog(LOG_CRIT, "Communication error while reading back current from channel %d: %s", i,
-               strerror(errno));
-        return -2;
-      }
+  if (capture_enabled) {
+    syslog(LOG_NOTICE, "Capture mode, %u ms windows%s", window_ms,
+           harmonics_enabled ? ", harmonic analysis" : "");
 
-      if (buffer[0] != 255 || buffer[1] != 255)
-        current[i - 1] = (calc_voltage(buffer) - 2.5) / 0.66;
-    }
+    ring_init(&capture_ring, capture_storage, CAPTURE_RING_LEN, sizeof(struct capture_frame));
 
-    // Throwaway value, only used to read 2 bytes from the ADC
-    if (write(spi_fd, "\x10\x83", 2) < 1) {
-      syslog(LOG_CRIT,
-             "Communication error while writing to ADC, reading voltage from channel %d: %s", i,
-             strerror(errno));
+    pthread_t sampler_thread;
+    pthread_create(&sampler_thread, NULL, adc_sampler, NULL);
+
+    capture_consume(window_ms);
+  }
+
+  for (;;) {
+    BENCH_SWEEP_BEGIN("volt");
+    if (scan_adc(scan_order, ADC_CHANNELS, samples)) {
+      syslog(LOG_CRIT, "Communication error while scanning ADC: %s", strerror(errno));
       return -2;
     }
+    BENCH_STAGE("adc");
 
-    if (read(spi_fd, buffer, 2) < 1) {
-      syslog(LOG_CRIT, "Communication error while reading back voltage: %s", strerror(errno));
-      return -2;
+    for (i = 0; i < 7; i++) {
+      if (samples[i].valid)
+        current[i] = (calc_voltage(&samples[i]) - 2.5) / 0.66;
     }
-    pthread_mutex_unlock(&spi_mutex);
 
-    if (buffer[0] != 255 || buffer[1] != 255) {
-      voltage = calc_voltage(buffer);
+    if (samples[7].valid) {
+      voltage = calc_voltage(&samples[7]);
     } else {
       syslog(LOG_ERR, "Voltage reading failure");
       if (read_fails++ > 10)
@@ -317,36 +1056,25 @@ int main(int argc, char* argv[]) {
       continue;
     }
 
-    if (voltage * VOLTAGE_CONST != 0.0) {
-      reply = redisCommand(c, "SET volt %.3f", voltage * VOLTAGE_CONST);
-      if (reply == NULL || reply->type == REDIS_REPLY_ERROR)
-        connect_local();
-      freeReplyObject(reply);
-    }
+    if (voltage * VOLTAGE_CONST != 0.0)
+      redis_enqueue(&local, "SET volt %.3f", voltage * VOLTAGE_CONST);
 
     low_current = 1;
 
     for (i = 0; i < 7; i++) {
       if (current[i] > 100 || current[i] < -2)
         continue;
-      reply = redisCommand(c, "HSET ich %d %.3f", 6 - i, current[i]);
-      freeReplyObject(reply);
+      redis_enqueue(&local, "HSET ich %d %.3f", 6 - i, current[i]);
 
       if (current[i] > 0.8)
         low_current = 0;
     }
 
-    reply = redisCommand(c, "SET pfactor %.3f", low_current ? 1.0 : duty);
-    freeReplyObject(reply);
-
-    reply = redisCommand(c, "SET glitch %d", glitch);
-    freeReplyObject(reply);
-
-    if (frequency > 0) {
-      reply = redisCommand(c, "SET frequency %d", frequency / 5);
-      freeReplyObject(reply);
-    }
+    publish_pru(low_current);
+    redis_enqueue_metrics(&local, &local);
+    BENCH_STAGE("redis");
+    BENCH_SWEEP_END();
 
-    nanosleep(inner_period, NULL);
+    BENCH_SKIP(nanosleep(inner_period, NULL));
   }
 }
@@ -3,7 +3,6 @@
  */
 
 #include <dirent.h>
-#include <hiredis/hiredis.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,31 +10,28 @@
 #include <time.h>
 
 #include "../bme280/common/common.h"
+#include "../log/common.h"
+#include "../redis/common.h"
+
+/// Datalog written to the first removable drive mounted under /media
+#define DATALOG_DIR "/media"
+#define DATALOG_NAME "datalog.slog"
+/// Readings are written to the drive in blocks, at least once a minute
+#define DATALOG_FLUSH_MS 60000
+#define DATALOG_CHANNELS 3
 
 redisContext *c, *local_c;
-const char servers[12][16] = {"10.0.38.59",    "10.0.38.46",    "10.0.38.42",    "10.128.153.81",
-                              "10.128.153.82", "10.128.153.83", "10.128.153.84", "10.128.153.85",
-                              "10.128.153.86", "10.128.153.87", "10.128.153.88", "10.128.255.5"};
+struct redis_transport local, remote;
+const char servers[12][REDIS_HOST_LEN] = {
+    "10.0.38.59",    "10.0.38.46",    "10.0.38.42",    "10.128.153.81",
+    "10.128.153.82", "10.128.153.83", "10.128.153.84", "10.128.153.85",
+    "10.128.153.86", "10.128.153.87", "10.128.153.88", "10.128.255.5"};
 gpio_t led = {.pin = USR_3};
 gpio_t dec_led = {.pin = USR_2};
 int8_t sensor_number = -1;
 
-uint8_t redis_connect() {
-  int server_i = 0;
-  do {
-    c = redisConnectWithTimeout(servers[server_i], 6379, (struct timeval){1, 500000});
-
-    if (c->err) {
-      if (server_i == 2) {
-        syslog(LOG_ERR, "No remote Redis server instance found");
-        return 0;
-      }
-
-      syslog(LOG_ERR, "%s remote Redis server not available, switching...\n", servers[server_i++]);
-    }
-  } while (c->err);
-  return 1;
-}
+const struct log_channel datalog_channels[DATALOG_CHANNELS] = {
+    {"temperature", 2}, {"pressure", 3}, {"humidity", 3}};
 
 void* blink_led() {
   const struct timespec blink_delay = {0, 250000000L};
@@ -84,22 +80,17 @@ int main(int argc, char* argv[]) {
     return -2;
   }
 
-  for (int i = 0; i < 20; i++) {
-    local_c = redisConnectWithTimeout("127.0.0.1", 6379, (struct timeval){1, 500000});
-    if (!local_c->err)
-      break;
-
-    sensor.dev.delay_us(500000, NULL);
-  }
+  local_c = redis_connect(redis_local, 1, 20);
 
-  if (local_c->err) {
+  if (local_c == NULL) {
     syslog(LOG_CRIT, "Could not find a local Redis server");
     return -2;
   }
 
-  if (redis_connect()) {
-    redisSetTimeout(c, (struct timeval){1, 500000});
+  // Only the first three servers are used for sensor data
+  c = redis_connect(servers, 3, 1);
 
+  if (c != NULL) {
     reply = (redisReply*)redisCommand(local_c, "HGET device simar_gia");
 
     if (reply->str) {
@@ -136,6 +127,7 @@ int main(int argc, char* argv[]) {
     syslog(LOG_NOTICE, "Sensor connected, utilizing id %d", sensor_number);
     reply = (redisReply*)redisCommand(local_c, "HSET device simar_gia %d", sensor_number);
     freeReplyObject(reply);
+    redisFree(c);
   } else {
     sensor_number = 99;
   }
@@ -143,6 +135,12 @@ int main(int argc, char* argv[]) {
   reply = (redisReply*)redisCommand(local_c, "SET retries 0");
   freeReplyObject(reply);
 
+  if (redis_transport_init(&local, "wireless_local", redis_local, 1) ||
+      redis_transport_init(&remote, "wireless_remote", servers, 3)) {
+    syslog(LOG_CRIT, "Could not start the Redis transport");
+    exit(DB_FAIL);
+  }
+
   syslog(LOG_NOTICE, "Starting readings...");
   for (int i = 0; i < 10; i++) {
     bme_read(&sensor.dev, &sensor.data);  // Perform "calibration" readings
@@ -157,84 +155,85 @@ int main(int argc, char* argv[]) {
   pthread_t led_thread;
   pthread_create(&led_thread, NULL, blink_led, NULL);
 
-  FILE* file = fopen("/log.csv", "a");
-  char* filename;
-  filename = (char*)calloc(512, sizeof(char));
-  DIR* dr = opendir("/media/");
+  struct log_writer datalog;
+  char mount[256] = "", failed[256] = "", path[512];
+  DIR* dr = opendir(DATALOG_DIR);
   struct dirent* de;
-  int found_loc = 0;
+  struct timespec now;
+  double values[DATALOG_CHANNELS];
 
   const struct timespec period = {0, 999999999L};
 
-  time_t t = time(NULL);
-  struct tm* current_time = localtime(&t);
-  char time_str[64];
-
   if (dr == NULL) {
     syslog(LOG_ERR, "Could not open logging directory");
     return -4;
   }
 
   for (;;) {
-    found_loc = 0;
-
-    while ((de = readdir(dr)) != NULL) {
-      if (strcmp(de->d_name, ".") && strcmp(de->d_name, "..")) {
-        if (strcmp(de->d_name, filename)) {
-          snprintf(filename, 512, "/media/%s/datalog.csv", de->d_name);
-          fclose(file);
-          fopen(filename, "a");
-        }
-        found_loc = 1;
-        break;
-      }
-    }
-
-    if (!found_loc)
-      strcpy(filename, "");
+    // Follow the drive: close the datalog when it goes away, open one on the next drive found. A
+    // drive that could not be written to is not retried until it is mounted again.
+    while ((de = readdir(dr)) != NULL && (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..")))
+      continue;
     rewinddir(dr);
 
-    if (sensor_number == 99 && redis_connect())
-      return DB_FAIL;
+    if (de == NULL || strcmp(de->d_name, failed))
+      *failed = '\0';
 
-    bme_read(&sensor.dev, &sensor.data);
-    if (check_alteration(sensor)) {
-      reply = (redisReply*)redisCommand(c, "SET wgen%d_%s %.3f EX 5", sensor_number, "temperature",
-                                        sensor.data.temperature);
+    if (*mount && (de == NULL || strcmp(de->d_name, mount))) {
+      log_close(&datalog);
+      *mount = '\0';
+    }
 
-      if (reply == NULL || reply->type == REDIS_REPLY_ERROR)
-        return DB_FAIL;
-      freeReplyObject(reply);
+    if (!*mount && de != NULL && !*failed) {
+      snprintf(path, sizeof(path), DATALOG_DIR "/%s/" DATALOG_NAME, de->d_name);
+      if (log_open(&datalog, path, datalog_channels, DATALOG_CHANNELS, DATALOG_FLUSH_MS) == 0)
+        snprintf(mount, sizeof(mount), "%s", de->d_name);
+      else
+        snprintf(failed, sizeof(failed), "%s", de->d_name);
+    }
 
-      reply = (redisReply*)redisCommand(c, "SET wgen%d_%s %.3f EX 5", sensor_number, "pressure",
-                                        sensor.data.pressure);
-      freeReplyObject(reply);
+    // Restart once a server is available, so that the sensor can be allocated an ID
+    if (sensor_number == 99 && atomic_load(&remote.connected)) {
+      if (*mount)
+        log_close(&datalog);
+      return DB_FAIL;
+    }
 
-      reply = (redisReply*)redisCommand(c, "SET wgen%d_%s %.3f EX 5", sensor_number, "humidity",
-                                        sensor.data.humidity);
-      freeReplyObject(reply);
+    bme_read(&sensor.dev, &sensor.data);
+    if (check_alteration(sensor) == BME280_OK) {
+      redis_enqueue(&remote, "SET wgen%d_%s %.3f EX 5", sensor_number, "temperature",
+                    sensor.data.temperature);
+      redis_enqueue(&remote, "SET wgen%d_%s %.3f EX 5", sensor_number, "pressure",
+                    sensor.data.pressure);
+      redis_enqueue(&remote, "SET wgen%d_%s %.3f EX 5", sensor_number, "humidity",
+                    sensor.data.humidity);
+      redis_enqueue_metrics(&local, &remote);
 
       sensor.past_pres = sensor.data.pressure;
-      if (strcmp(filename, "")) {
-        t = time(0);
-        current_time = localtime(&t);
-        strftime(time_str, sizeof(time_str), "%c", current_time);
-
-        fprintf(file, "%s,%.4f,%.4f,%.4f\n", time_str, sensor.data.temperature,
-                sensor.data.pressure, sensor.data.humidity);
-        fflush(file);
+      if (*mount) {
+        clock_gettime(CLOCK_REALTIME, &now);
+        values[0] = sensor.data.temperature;
+        values[1] = sensor.data.pressure;
+        values[2] = sensor.data.humidity;
+
+        if (log_append(&datalog, now.tv_sec * 1000LL + now.tv_nsec / 1000000, values)) {
+          syslog(LOG_ERR, "Could not write to the datalog on %s", mount);
+          log_close(&datalog);
+          snprintf(failed, sizeof(failed), "%s", mount);
+          *mount = '\0';
+        }
       }
     } else {
       syslog(LOG_ERR, "Invalid sensor reading");
+      if (*mount)
+        log_close(&datalog);
       return SENSOR_FAIL;
     }
     nanosleep(&period, NULL);
   }
 
   // Unreachable
-  free(filename);
   pthread_join(led_thread, NULL);
-  redisFree(c);
   redisFree(local_c);
   closedir(dr);
   return 0;
@@ -9,6 +9,19 @@
 	.define r18,		CYCLE_SET
 	.define r19,		CYCLE_CLEAR
 
+	; Edge timestamp ring (ring.h), its address comes in r15
+	.define r15,		RING
+	.define r20,		PINS
+	.define r21,		PREV
+	.define r22,		HEAD
+	.define r23,		MASK
+	.define r24,		STAMP				; Entry: timestamp, then changed/pins (r25)
+	.define r25,		EVENT
+	.define r26,		OFFSET
+
+	.asg	1023,		PRU_RING_MASK		; PRU_RING_LEN - 1
+	.asg	0x15,		PRU_PINS			; Frequency, glitch and power factor inputs
+
 	.global asm_count
 
 asm_count:
@@ -18,6 +31,10 @@ asm_count:
 	ZERO		&CYCLE_CLEAR,4
 	SET			OUT1
 	SET			OUT2
+	ZERO		&EVENT,4
+	LDI			MASK, PRU_RING_MASK
+	LBBO		&HEAD, RING, 0, 4
+	MOV			PREV.b0, r31.b0
 
 count1:
 	SET			OUT1
@@ -50,10 +67,23 @@ cycle_down:
 	ADD			CYCLE_CLEAR, CYCLE_CLEAR, 1
 
 ret_loop:
-	NOP
-	NOP
-	NOP
-	NOP
+	MOV			PINS.b0, r31.b0				; Same cycle count as the four NOPs this replaces
+	XOR			EVENT.b0, PINS.b0, PREV.b0
+	MOV			PREV.b0, PINS.b0
+	QBEQ		no_edge, EVENT.b0, 0
+
+	AND			EVENT.b0, EVENT.b0, PRU_PINS
+	QBEQ		no_edge, EVENT.b0, 0
+	MOV			EVENT.b1, PINS.b0
+	LBCO		&STAMP, C26, 0x0C, 4		; IEP counter
+	AND			OFFSET, HEAD, MASK
+	LSL			OFFSET, OFFSET, 3
+	ADD			OFFSET, OFFSET, 8			; Entries follow the head and magic words
+	SBBO		&STAMP, RING, OFFSET, 8
+	ADD			HEAD, HEAD, 1
+	SBBO		&HEAD, RING, 0, 4			; Published after the entry is in place
+
+no_edge:
 	QBBC   		count1, r31, 31				; If kick bit is set (message received), return
 
 end_count:
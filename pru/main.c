@@ -1,12 +1,14 @@
 #include <pru_cfg.h>
+#include <pru_iep.h>
 #include <pru_intc.h>
 #include <pru_rpmsg.h>
 #include <rsc_types.h>
 #include <stdint.h>
 #include "intc_map_1.h"
 #include "resource_table.h"
+#include "ring.h"
 
-extern void asm_count(uint32_t* data_ptr);
+extern void asm_count(uint32_t* data_ptr, volatile struct pru_ring* ring);
 
 volatile register uint32_t __R31;
 
@@ -41,8 +43,14 @@ void main(void) {
   uint16_t src, dst, len;
   volatile uint8_t* status;
   uint32_t data[4];
+  volatile struct pru_ring* ring = (volatile struct pru_ring*)PRU_RING_PRU_ADDR;
 
   CT_CFG.SYSCFG_bit.STANDBY_INIT = 0;
+
+  // Free-running IEP counter (increments by 1 every cycle) timestamps the edge ring
+  CT_IEP.TMR_GLB_CFG = 0x11;
+  ring->head = 0;
+  ring->magic = PRU_RING_MAGIC;
   // Clear the status of the PRU-ICSS system event that the ARM will use to
   // 'kick' us
   CT_INTC.SICR_bit.STS_CLR_IDX = FROM_ARM_HOST;
@@ -65,7 +73,7 @@ void main(void) {
     if (__R31 & HOST_INT) {
       CT_INTC.SICR_bit.STS_CLR_IDX = FROM_ARM_HOST;
       while (pru_rpmsg_receive(&transport, &src, &dst, payload, &len) == PRU_RPMSG_SUCCESS) {
-        asm_count(&data);
+        asm_count(data, ring);
         pru_rpmsg_send(&transport, dst, src, data, 16);
       }
     }
@@ -0,0 +1,51 @@
+/*! @file ring.h
+ * @brief Edge timestamp ring shared between the PRU1 firmware and the ARM (PRU shared RAM)
+ *
+ * @details PRU1 appends an entry every time one of the monitored inputs changes and then advances
+ * `head`; it never waits for the ARM. The ARM maps the ring through /dev/mem and keeps its own
+ * read index, detecting overruns from the distance to `head`. Included by both the firmware
+ * (clpru) and the host (gcc), so only fixed-size types are used. The layout is mirrored by
+ * count.asm.
+ */
+
+#ifndef PRU_RING_H
+#define PRU_RING_H
+
+#include <stdint.h>
+
+/// Ring location, as seen by the PRU and by the ARM (12 kB shared RAM)
+#define PRU_RING_PRU_ADDR 0x00010000
+#define PRU_RING_ARM_ADDR 0x4A310000
+/// Entries (power of two, PRU_RING_MASK in count.asm)
+#define PRU_RING_LEN 1024
+/// Written by the firmware once the ring is initialized
+#define PRU_RING_MAGIC 0x45444745
+/// IEP timer rate (timestamp resolution)
+#define PRU_IEP_HZ 200000000
+
+/// Monitored inputs (R31 bits)
+#define PRU_PIN_FREQUENCY (1 << 0)  ///< P8_45
+#define PRU_PIN_GLITCH (1 << 2)     ///< P8_43
+#define PRU_PIN_PFACTOR (1 << 4)    ///< P8_41
+#define PRU_PINS (PRU_PIN_FREQUENCY | PRU_PIN_GLITCH | PRU_PIN_PFACTOR)
+
+/*!
+ * @brief Input change
+ */
+struct pru_ring_entry {
+  uint32_t timestamp;  ///< IEP counter (wraps every 2^32 / PRU_IEP_HZ s)
+  uint8_t changed;     ///< Inputs that changed (PRU_PIN_*)
+  uint8_t pins;        ///< Input levels after the change
+  uint16_t reserved;
+};
+
+/*!
+ * @brief Ring header and entries
+ */
+struct pru_ring {
+  volatile uint32_t head;   ///< Entries written since the firmware started (free running)
+  volatile uint32_t magic;  ///< PRU_RING_MAGIC
+  volatile struct pru_ring_entry entries[PRU_RING_LEN];
+};
+
+#endif
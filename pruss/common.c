@@ -0,0 +1,201 @@
+/*! @file common.c
+ * @brief PRU edge timestamp ring reader
+ */
+
+#include "common.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../sim/common.h"
+
+int8_t pru_ring_open(struct pru_ring_reader* r) {
+  void* map;
+  int fd;
+
+  fd = hal_open("/dev/mem", O_RDWR | O_SYNC);
+  if (fd < 0) {
+    syslog(LOG_ERR, "Could not open /dev/mem for the PRU ring");
+    return -1;
+  }
+
+  map = hal_mmap(NULL, sizeof(struct pru_ring), PROT_READ, MAP_SHARED, fd, PRU_RING_ARM_ADDR);
+  hal_close(fd);
+
+  if (map == MAP_FAILED) {
+    syslog(LOG_ERR, "Could not map the PRU ring");
+    return -1;
+  }
+
+  r->ring = map;
+  if (r->ring->magic != PRU_RING_MAGIC) {
+    munmap(map, sizeof(struct pru_ring));
+    r->ring = NULL;
+    return -2;
+  }
+
+  r->tail = r->ring->head;
+  r->lost = 0;
+
+  return 0;
+}
+
+uint32_t pru_ring_read(struct pru_ring_reader* r, struct pru_ring_entry* entries, uint32_t max) {
+  uint32_t head = r->ring->head, count, overwritten;
+  const volatile struct pru_ring_entry* entry;
+
+  // Entries up to head are complete once head is seen
+  atomic_thread_fence(memory_order_acquire);
+
+  if (head - r->tail > PRU_RING_LEN) {
+    r->lost += head - r->tail - PRU_RING_LEN;
+    r->tail = head - PRU_RING_LEN;
+  }
+
+  count = head - r->tail < max ? head - r->tail : max;
+  for (uint32_t k = 0; k < count; k++) {
+    entry = &r->ring->entries[(r->tail + k) & (PRU_RING_LEN - 1)];
+    entries[k].timestamp = entry->timestamp;
+    entries[k].changed = entry->changed;
+    entries[k].pins = entry->pins;
+  }
+
+  // The firmware may have lapped the copy meanwhile, the overwritten entries are dropped
+  atomic_thread_fence(memory_order_acquire);
+  head = r->ring->head;
+  overwritten = head - r->tail > PRU_RING_LEN ? head - r->tail - PRU_RING_LEN : 0;
+  overwritten = overwritten < count ? overwritten : count;
+
+  for (uint32_t k = overwritten; k < count; k++)
+    entries[k - overwritten] = entries[k];
+
+  r->tail += count;
+  r->lost += overwritten;
+
+  return count - overwritten;
+}
+
+int8_t pru_clock_open(struct pru_clock* c) {
+  void* map;
+  int fd;
+
+  fd = hal_open("/dev/mem", O_RDWR | O_SYNC);
+  if (fd < 0) {
+    syslog(LOG_ERR, "Could not open /dev/mem for the PRU IEP timer");
+    return -1;
+  }
+
+  map = hal_mmap(NULL, PRU_IEP_COUNT + 4, PROT_READ, MAP_SHARED, fd, PRU_IEP_ARM_ADDR);
+  hal_close(fd);
+
+  if (map == MAP_FAILED) {
+    syslog(LOG_ERR, "Could not map the PRU IEP timer");
+    return -1;
+  }
+
+  c->counter = (volatile uint32_t*)map + PRU_IEP_COUNT / 4;
+  pru_clock_sync(c);
+
+  return 0;
+}
+
+void pru_clock_sync(struct pru_clock* c) {
+  struct timespec before, after;
+  uint32_t ticks;
+
+  clock_gettime(CLOCK_MONOTONIC, &before);
+  ticks = hal_pru_iep(c->counter);
+  clock_gettime(CLOCK_MONOTONIC, &after);
+
+  c->ticks = ticks;
+  c->ns = ((before.tv_sec + after.tv_sec) * 1000000000ULL + before.tv_nsec + after.tv_nsec) / 2;
+}
+
+uint64_t pru_clock_ns(const struct pru_clock* c, uint32_t timestamp) {
+  // Signed, so that timestamps from before the sync point convert as well
+  return c->ns + (int64_t)(int32_t)(timestamp - c->ticks) * 1000000000LL / PRU_IEP_HZ;
+}
+
+void pru_edges_reset(struct pru_edges* e) {
+  e->cycles = 0;
+  e->period_sum = 0;
+  e->period_sum_sq = 0;
+  e->period_min = UINT32_MAX;
+  e->period_max = 0;
+  e->pf_high = 0;
+  e->pf_total = 0;
+  e->glitches = 0;
+  e->cycle_valid = 0;
+  e->pf_valid = 0;
+}
+
+void pru_edges_update(struct pru_edges* e, const struct pru_ring_entry* entries, uint32_t count) {
+  const struct pru_ring_entry* entry;
+  uint32_t period, elapsed;
+  uint8_t rising;
+
+  for (uint32_t k = 0; k < count; k++) {
+    entry = &entries[k];
+    rising = entry->changed & entry->pins;
+
+    // Timestamps wrap, differences stay exact as long as edges are less than 21 s apart
+    if (entry->changed & PRU_PIN_PFACTOR) {
+      elapsed = entry->timestamp - e->pf_edge;
+      if (e->pf_valid && elapsed <= PRU_PERIOD_MAX) {
+        e->pf_total += elapsed;
+        if (e->pins & PRU_PIN_PFACTOR)
+          e->pf_high += elapsed;
+      }
+      e->pf_edge = entry->timestamp;
+      e->pf_valid = 1;
+    }
+
+    if (rising & PRU_PIN_GLITCH) {
+      e->glitches++;
+      e->glitch_phase = e->cycle_valid ? entry->timestamp - e->cycle_start : 0;
+    }
+
+    if (rising & PRU_PIN_FREQUENCY) {
+      period = entry->timestamp - e->cycle_start;
+      if (e->cycle_valid && period >= PRU_PERIOD_MIN && period <= PRU_PERIOD_MAX) {
+        e->cycles++;
+        e->period_sum += period;
+        e->period_sum_sq += (double)period * period;
+        e->period_min = period < e->period_min ? period : e->period_min;
+        e->period_max = period > e->period_max ? period : e->period_max;
+      }
+      e->cycle_start = entry->timestamp;
+      e->cycle_valid = 1;
+    }
+
+    e->pins = entry->pins;
+  }
+}
+
+double pru_edges_frequency(const struct pru_edges* e) {
+  return e->cycles ? (double)PRU_IEP_HZ * e->cycles / e->period_sum : 0;
+}
+
+double pru_edges_jitter(const struct pru_edges* e) {
+  double mean, variance;
+
+  if (e->cycles < 2)
+    return 0;
+
+  mean = (double)e->period_sum / e->cycles;
+  variance = e->period_sum_sq / e->cycles - mean * mean;
+  return variance > 0 ? sqrt(variance) * 1e6 / PRU_IEP_HZ : 0;
+}
+
+double pru_edges_duty(const struct pru_edges* e) {
+  return e->pf_total ? (double)e->pf_high / e->pf_total : 1;
+}
+
+double pru_edges_glitch_phase(const struct pru_edges* e) {
+  return e->glitches && e->cycles ? 360.0 * e->glitch_phase * e->cycles / e->period_sum : 0;
+}
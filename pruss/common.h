@@ -0,0 +1,163 @@
+/*! @file common.h
+ * @brief Declarations for the PRU edge timestamp ring reader
+ */
+
+/*!
+ * @defgroup pruss PRU
+ * @brief Host side of the PRU1 edge timestamp ring (pru/ring.h)
+ *
+ * @details The ring lives in PRU shared RAM and is mapped through /dev/mem (a file-backed ring
+ * under simulation), so edges are read without any rpmsg round-trip. Edges are then reduced to
+ * per-cycle line frequency, period jitter, power factor duty cycle and glitch timing.
+ */
+
+#ifndef PRUSS_COMMON_H
+#define PRUSS_COMMON_H
+
+#include <stdint.h>
+
+#include "../pru/ring.h"
+
+/// IEP timer, as seen by the ARM, and its counter register
+#define PRU_IEP_ARM_ADDR 0x4A32E000
+#define PRU_IEP_COUNT 0x0C
+
+/// Accepted line period range, in IEP ticks (45 to 65 Hz, as PF_PERIOD_*_NS in dsp/pf.h)
+#define PRU_PERIOD_MIN (PRU_IEP_HZ / 65)
+#define PRU_PERIOD_MAX (PRU_IEP_HZ / 45)
+
+/*!
+ * @brief Ring mapping and read position
+ */
+struct pru_ring_reader {
+  struct pru_ring* ring;
+  uint32_t tail;  ///< Next entry to read (free running, like the ring's head)
+  uint32_t lost;  ///< Entries overwritten before they could be read
+};
+
+/*!
+ * @brief Correspondence between the IEP counter and CLOCK_MONOTONIC
+ */
+struct pru_clock {
+  volatile uint32_t* counter;  ///< Mapped IEP counter register
+  uint32_t ticks;              ///< IEP counter at `ns`
+  uint64_t ns;                 ///< CLOCK_MONOTONIC, in ns
+};
+
+/*!
+ * @brief Edge statistics, accumulated over a window
+ */
+struct pru_edges {
+  uint32_t cycles;          ///< Complete line cycles (frequency input rising edge to rising edge)
+  uint64_t period_sum;      ///< Sum of cycle periods, in IEP ticks
+  double period_sum_sq;     ///< Sum of squared cycle periods
+  uint32_t period_min;      ///< Shortest period, in IEP ticks
+  uint32_t period_max;      ///< Longest period, in IEP ticks
+  uint64_t pf_high;         ///< Time the power factor input spent high, in IEP ticks
+  uint64_t pf_total;        ///< Time the power factor input was observed, in IEP ticks
+  uint32_t glitches;        ///< Glitch input rising edges
+  uint32_t glitch_phase;    ///< Last glitch, in IEP ticks since the preceding cycle start
+
+  /// Tracking state, restarted with every window
+  uint8_t pins;
+  uint8_t cycle_valid, pf_valid;
+  uint32_t cycle_start;
+  uint32_t pf_edge;
+};
+
+/**
+ * \ingroup pruss
+ * @brief Maps the edge ring
+ * @param[out] r Reader, positioned at the current head
+ * @retval 0 OK
+ * @retval -1 The ring could not be mapped
+ * @retval -2 The PRU firmware does not stream edges
+ */
+int8_t pru_ring_open(struct pru_ring_reader* r);
+
+/**
+ * \ingroup pruss
+ * @brief Copies out the entries written since the last read
+ * @details If the firmware laps the reader, the oldest entries are skipped and counted in `lost`.
+ * @param[in, out] r Reader
+ * @param[out] entries Entries, oldest first
+ * @param[in] max Room in `entries`
+ * @returns Amount of entries copied
+ */
+uint32_t pru_ring_read(struct pru_ring_reader* r, struct pru_ring_entry* entries, uint32_t max);
+
+/**
+ * \ingroup pruss
+ * @brief Maps the IEP counter and takes a first sync point
+ * @param[out] c Clock
+ * @retval 0 OK
+ * @retval -1 The counter could not be mapped
+ */
+int8_t pru_clock_open(struct pru_clock* c);
+
+/**
+ * \ingroup pruss
+ * @brief Takes a new sync point (the counter is read between two CLOCK_MONOTONIC reads)
+ * @details The IEP and system clocks drift apart, so this should be repeated every few seconds.
+ * @param[in, out] c Clock
+ */
+void pru_clock_sync(struct pru_clock* c);
+
+/**
+ * \ingroup pruss
+ * @brief Converts an IEP timestamp to CLOCK_MONOTONIC
+ * @param[in] c Clock
+ * @param[in] timestamp IEP counter value, within 10 s of the latest sync point
+ * @returns Time, in ns
+ */
+uint64_t pru_clock_ns(const struct pru_clock* c, uint32_t timestamp);
+
+/**
+ * \ingroup pruss
+ * @brief Clears the window statistics and restarts edge tracking
+ * @details The firmware only records edges while a window is open, so no period or high time may
+ * span the gap between the end of one window and the kick opening the next.
+ * @param[in, out] e Statistics
+ */
+void pru_edges_reset(struct pru_edges* e);
+
+/**
+ * \ingroup pruss
+ * @brief Accumulates a batch of ring entries
+ * @details Periods outside PRU_PERIOD_MIN..PRU_PERIOD_MAX, and power factor input phases longer
+ * than PRU_PERIOD_MAX, span missed edges: they are left out, and tracking restarts at their end.
+ * @param[in, out] e Statistics
+ * @param[in] entries Entries, oldest first
+ * @param[in] count Amount of entries
+ */
+void pru_edges_update(struct pru_edges* e, const struct pru_ring_entry* entries, uint32_t count);
+
+/**
+ * \ingroup pruss
+ * @brief Mean line frequency over the window
+ * @returns Frequency, in Hz (0 without a complete cycle)
+ */
+double pru_edges_frequency(const struct pru_edges* e);
+
+/**
+ * \ingroup pruss
+ * @brief Standard deviation of the cycle period over the window
+ * @returns Jitter, in microseconds
+ */
+double pru_edges_jitter(const struct pru_edges* e);
+
+/**
+ * \ingroup pruss
+ * @brief Fraction of the window the power factor input spent high
+ * @returns Duty cycle (1 if the input never changed)
+ */
+double pru_edges_duty(const struct pru_edges* e);
+
+/**
+ * \ingroup pruss
+ * @brief Position of the window's last glitch within its line cycle
+ * @returns Phase, in degrees (0 without glitches)
+ */
+double pru_edges_glitch_phase(const struct pru_edges* e);
+
+#endif
@@ -0,0 +1,297 @@
+/*! @file common.c
+ * @brief Common functions for Redis communication
+ */
+
+#include "common.h"
+
+#include <hiredis/adapters/poll.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <syslog.h>
+#include <time.h>
+
+const char redis_local[1][REDIS_HOST_LEN] = {"127.0.0.1"};
+
+redisContext* redis_connect(const char (*hosts)[REDIS_HOST_LEN], uint8_t host_count, int rounds) {
+  redisContext* c;
+
+#ifdef SIMAR_BENCH
+  // Benchmarks run every server role against the local stand-in
+  hosts = redis_local;
+  host_count = 1;
+#endif
+
+  for (int round = 0; rounds < 0 || round < rounds; round++) {
+    for (uint8_t i = 0; i < host_count; i++) {
+      c = redisConnectWithTimeout(hosts[i], REDIS_PORT, (struct timeval){1, 500000});
+
+      if (c != NULL && !c->err) {
+        redisSetTimeout(c, (struct timeval){1, 500000});
+        return c;
+      }
+
+      if (c == NULL)
+        syslog(LOG_ERR, "Could not allocate Redis context for %s\n", hosts[i]);
+      else if (c->err == 1)
+        syslog(LOG_ERR,
+               "Redis server instance at %s not available. Have you "
+               "initialized the Redis server? (Error code 1)\n",
+               hosts[i]);
+      else
+        syslog(LOG_ERR, "Unknown redis error for %s (error code %d)\n", hosts[i], c->err);
+
+      redisFree(c);
+    }
+
+    nanosleep((const struct timespec[]){{0, 700000000L}}, NULL);  // 700ms
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Hands a reply to the oldest in-flight command's callback
+ * @param[in] ac Async context
+ * @param[in] r Reply (NULL if the connection was lost)
+ * @param[in] privdata Transport
+ */
+static void on_reply(redisAsyncContext* ac, void* r, void* privdata) {
+  struct redis_transport* t = privdata;
+  struct redis_command* cmd = &t->inflight[t->inflight_head];
+
+  t->inflight_head = (t->inflight_head + 1) % REDIS_INFLIGHT_MAX;
+  atomic_fetch_sub(&t->inflight_count, 1);
+
+  if (cmd->fn)
+    cmd->fn(r, cmd->privdata);
+}
+
+static void on_connect(const redisAsyncContext* ac, int status) {
+  struct redis_transport* t = ac->data;
+
+  if (status != REDIS_OK) {
+    syslog(LOG_ERR, "%s: %s Redis server not available: %s", t->name, t->hosts[t->host_i],
+           ac->errstr);
+    t->ac = NULL;
+    t->host_i = (t->host_i + 1) % t->host_count;
+    return;
+  }
+
+  syslog(LOG_NOTICE, "%s: connected to %s", t->name, t->hosts[t->host_i]);
+  atomic_store(&t->connected, 1);
+}
+
+static void on_disconnect(const redisAsyncContext* ac, int status) {
+  struct redis_transport* t = ac->data;
+
+  if (status != REDIS_OK)
+    syslog(LOG_ERR, "%s: lost connection to %s: %s", t->name, t->hosts[t->host_i], ac->errstr);
+
+  atomic_store(&t->connected, 0);
+  t->ac = NULL;
+}
+
+/**
+ * @brief Starts a non-blocking connection to the current server
+ * @param[in] t Transport
+ * @retval 0 Connection in progress
+ * @retval -1 Connection could not be started
+ */
+static int start_connect(struct redis_transport* t) {
+  redisOptions options = {0};
+  struct timeval timeout = {1, 500000};
+
+  REDIS_OPTIONS_SET_TCP(&options, t->hosts[t->host_i], REDIS_PORT);
+  options.connect_timeout = &timeout;
+  options.command_timeout = &timeout;
+
+  t->ac = redisAsyncConnectWithOptions(&options);
+
+  if (t->ac == NULL || t->ac->err) {
+    if (t->ac)
+      redisAsyncFree(t->ac);
+    t->ac = NULL;
+    t->host_i = (t->host_i + 1) % t->host_count;
+    return -1;
+  }
+
+  t->ac->data = t;
+  redisPollAttach(t->ac);
+  redisAsyncSetConnectCallback(t->ac, on_connect);
+  redisAsyncSetDisconnectCallback(t->ac, on_disconnect);
+
+  return 0;
+}
+
+/**
+ * @brief Moves queued commands to the connection, as long as there is room in flight
+ * @param[in] t Transport
+ */
+static void drain(struct redis_transport* t) {
+  struct redis_command cmd;
+
+  while (t->ac && atomic_load(&t->inflight_count) < REDIS_INFLIGHT_MAX) {
+    pthread_mutex_lock(&t->lock);
+    if (!t->count) {
+      pthread_mutex_unlock(&t->lock);
+      break;
+    }
+    cmd = t->queue[t->head];
+    t->head = (t->head + 1) % REDIS_QUEUE_LEN;
+    t->count--;
+    pthread_mutex_unlock(&t->lock);
+
+    t->inflight[(t->inflight_head + atomic_load(&t->inflight_count)) % REDIS_INFLIGHT_MAX] = cmd;
+
+    if (redisAsyncFormattedCommand(t->ac, on_reply, t, cmd.cmd, cmd.len) == REDIS_OK) {
+      atomic_fetch_add(&t->inflight_count, 1);
+    } else {
+      atomic_fetch_add(&t->dropped, 1);
+      if (cmd.fn)
+        cmd.fn(NULL, cmd.privdata);
+    }
+
+    redisFreeCommand(cmd.cmd);
+  }
+}
+
+/**
+ * @brief Event loop: connects, drains the queue and handles replies, forever
+ * @param[in] arg Transport
+ */
+static void* redis_loop(void* arg) {
+  struct redis_transport* t = arg;
+  long backoff = REDIS_BACKOFF_MIN_MS;
+
+  for (;;) {
+    if (t->ac == NULL) {
+      if (start_connect(t)) {
+        nanosleep((const struct timespec[]){{backoff / 1000, (backoff % 1000) * 1000000L}}, NULL);
+        backoff = backoff * 2 > REDIS_BACKOFF_MAX_MS ? REDIS_BACKOFF_MAX_MS : backoff * 2;
+        continue;
+      }
+    }
+
+    if (atomic_load(&t->connected)) {
+      backoff = REDIS_BACKOFF_MIN_MS;
+      drain(t);
+    }
+
+    redisPollTick(t->ac, REDIS_TICK_S);
+
+    // Connection failed or was lost during this tick; wait before trying the next server
+    if (t->ac == NULL && !atomic_load(&t->connected)) {
+      nanosleep((const struct timespec[]){{backoff / 1000, (backoff % 1000) * 1000000L}}, NULL);
+      backoff = backoff * 2 > REDIS_BACKOFF_MAX_MS ? REDIS_BACKOFF_MAX_MS : backoff * 2;
+    }
+  }
+
+  return NULL;
+}
+
+int redis_transport_init(struct redis_transport* t,
+                         const char* name,
+                         const char (*hosts)[REDIS_HOST_LEN],
+                         uint8_t host_count) {
+#ifdef SIMAR_BENCH
+  hosts = redis_local;
+  host_count = 1;
+#endif
+
+  *t = (struct redis_transport){.name = name, .hosts = hosts, .host_count = host_count};
+
+  atomic_init(&t->inflight_count, 0);
+  atomic_init(&t->dropped, 0);
+  atomic_init(&t->connected, 0);
+  pthread_mutex_init(&t->lock, NULL);
+
+  if (pthread_create(&t->thread, NULL, redis_loop, t)) {
+    syslog(LOG_CRIT, "%s: could not start Redis event loop", name);
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Appends a formatted command to the queue, dropping the oldest one if it is full
+ * @param[in] t Transport
+ * @param[in] cmd Queued command
+ */
+static void push(struct redis_transport* t, struct redis_command cmd) {
+  struct redis_command old = {0};
+
+  pthread_mutex_lock(&t->lock);
+  if (t->count == REDIS_QUEUE_LEN) {
+    old = t->queue[t->head];
+    t->head = (t->head + 1) % REDIS_QUEUE_LEN;
+    t->count--;
+    atomic_fetch_add(&t->dropped, 1);
+  }
+  t->queue[(t->head + t->count) % REDIS_QUEUE_LEN] = cmd;
+  t->count++;
+  pthread_mutex_unlock(&t->lock);
+
+  if (old.cmd) {
+    if (old.fn)
+      old.fn(NULL, old.privdata);
+    redisFreeCommand(old.cmd);
+  }
+}
+
+static int venqueue(struct redis_transport* t,
+                    redis_reply_fn* fn,
+                    void* privdata,
+                    const char* format,
+                    va_list ap) {
+  struct redis_command cmd = {.fn = fn, .privdata = privdata};
+
+  cmd.len = redisvFormatCommand(&cmd.cmd, format, ap);
+  if (cmd.len < 0)
+    return -1;
+
+  push(t, cmd);
+  return 0;
+}
+
+int redis_enqueue(struct redis_transport* t, const char* format, ...) {
+  va_list ap;
+  int rslt;
+
+  va_start(ap, format);
+  rslt = venqueue(t, NULL, NULL, format, ap);
+  va_end(ap);
+
+  return rslt;
+}
+
+int redis_enqueue_cb(struct redis_transport* t,
+                     redis_reply_fn* fn,
+                     void* privdata,
+                     const char* format,
+                     ...) {
+  va_list ap;
+  int rslt;
+
+  va_start(ap, format);
+  rslt = venqueue(t, fn, privdata, format, ap);
+  va_end(ap);
+
+  return rslt;
+}
+
+unsigned int redis_queue_depth(struct redis_transport* t) {
+  unsigned int depth;
+
+  pthread_mutex_lock(&t->lock);
+  depth = t->count;
+  pthread_mutex_unlock(&t->lock);
+
+  return depth + atomic_load(&t->inflight_count);
+}
+
+int redis_enqueue_metrics(struct redis_transport* dst, struct redis_transport* t) {
+  return redis_enqueue(dst, "HSET transport %s_depth %u %s_dropped %u %s_connected %d", t->name,
+                       redis_queue_depth(t), t->name, atomic_load(&t->dropped), t->name,
+                       atomic_load(&t->connected));
+}
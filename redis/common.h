@@ -0,0 +1,170 @@
+/*! @file common.h
+ * @brief Common declarations for Redis communication
+ */
+
+/*!
+ * @defgroup redis Redis
+ * @brief Shared Redis connection handling and non-blocking transport
+ */
+
+#ifndef REDIS_COMMON_H
+#define REDIS_COMMON_H
+
+#include <hiredis/async.h>
+#include <hiredis/hiredis.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define REDIS_PORT 6379
+#define REDIS_HOST_LEN 16
+#define REDIS_QUEUE_LEN 256
+#define REDIS_INFLIGHT_MAX 64
+#define REDIS_TICK_S 0.05
+#define REDIS_BACKOFF_MIN_MS 500
+#define REDIS_BACKOFF_MAX_MS 8000
+
+/// Local Redis server, for use with redis_connect() and redis_transport_init()
+extern const char redis_local[1][REDIS_HOST_LEN];
+
+/**
+ * @brief Reply callback, run from the transport's event loop thread
+ * @param[in] reply Server reply, or NULL if the command was dropped or the connection was lost
+ * @param[in] privdata User data given when the command was queued
+ */
+typedef void(redis_reply_fn)(redisReply* reply, void* privdata);
+
+/*!
+ * @brief Queued command, already serialized to the Redis protocol
+ */
+struct redis_command {
+  char* cmd;
+  int len;
+  redis_reply_fn* fn;
+  void* privdata;
+};
+
+/*!
+ * @brief Non-blocking Redis transport: a bounded outgoing queue drained by a background event
+ * loop, which also handles (re)connection
+ */
+struct redis_transport {
+  const char* name;
+  const char (*hosts)[REDIS_HOST_LEN];
+  uint8_t host_count;
+  uint8_t host_i;
+
+  redisAsyncContext* ac;
+  pthread_t thread;
+  pthread_mutex_t lock;
+
+  struct redis_command queue[REDIS_QUEUE_LEN];
+  uint16_t head;
+  uint16_t count;
+
+  struct redis_command inflight[REDIS_INFLIGHT_MAX];
+  uint16_t inflight_head;
+  atomic_uint inflight_count;
+
+  atomic_uint dropped;
+  atomic_int connected;
+};
+
+/**
+ * \ingroup redis
+ * \defgroup redisSync Blocking connections
+ * @brief Blocking connection helpers, for startup and request/response work
+ */
+
+/**
+ * \ingroup redisSync
+ * @brief Connects to the first available server in a list
+ *
+ * @param[in] hosts Server addresses, tried in order
+ * @param[in] host_count Amount of servers in the list
+ * @param[in] rounds Amount of passes through the whole list before giving up (<0 retries forever)
+ *
+ * @returns Connected context
+ * @retval NULL No server could be reached
+ */
+redisContext* redis_connect(const char (*hosts)[REDIS_HOST_LEN], uint8_t host_count, int rounds);
+
+/**
+ * \ingroup redis
+ * \defgroup redisTransport Transport
+ * @brief Non-blocking, queued command transport
+ */
+
+/**
+ * \ingroup redisTransport
+ * @brief Initializes a transport and starts its event loop thread
+ *
+ * @param[out] t Transport
+ * @param[in] name Transport name, used in logs and metrics
+ * @param[in] hosts Server addresses, tried in order on every (re)connection (must outlive the
+ * transport)
+ * @param[in] host_count Amount of servers in the list
+ *
+ * @retval 0 OK
+ * @retval -1 Event loop thread could not be created
+ */
+int redis_transport_init(struct redis_transport* t,
+                         const char* name,
+                         const char (*hosts)[REDIS_HOST_LEN],
+                         uint8_t host_count);
+
+/**
+ * \ingroup redisTransport
+ * @brief Queues a command, never blocking on the network
+ *
+ * @details If the queue is full, the oldest command is dropped to make room.
+ *
+ * @param[in] t Transport
+ * @param[in] format hiredis-style command format
+ *
+ * @retval 0 Command queued
+ * @retval -1 Command could not be formatted
+ */
+int redis_enqueue(struct redis_transport* t, const char* format, ...);
+
+/**
+ * \ingroup redisTransport
+ * @brief Queues a command whose reply is handed to a callback
+ *
+ * @details The callback runs in the event loop thread. It is called with a NULL reply if the
+ * command is dropped (in which case it runs in the calling thread) or if the connection is lost.
+ *
+ * @param[in] t Transport
+ * @param[in] fn Reply callback
+ * @param[in] privdata User data passed to the callback
+ * @param[in] format hiredis-style command format
+ *
+ * @retval 0 Command queued
+ * @retval -1 Command could not be formatted
+ */
+int redis_enqueue_cb(struct redis_transport* t,
+                     redis_reply_fn* fn,
+                     void* privdata,
+                     const char* format,
+                     ...);
+
+/**
+ * \ingroup redisTransport
+ * @brief Amount of commands not yet answered by the server (queued and in flight)
+ * @param[in] t Transport
+ * @returns Queue depth
+ */
+unsigned int redis_queue_depth(struct redis_transport* t);
+
+/**
+ * \ingroup redisTransport
+ * @brief Queues a transport's metrics (queue depth, dropped commands and connection status) into
+ * the `transport` hash
+ * @param[in] dst Transport to publish through
+ * @param[in] t Transport to report on
+ * @retval 0 Command queued
+ * @retval -1 Command could not be formatted
+ */
+int redis_enqueue_metrics(struct redis_transport* dst, struct redis_transport* t);
+
+#endif
@@ -0,0 +1,188 @@
+/*! @file epoll.c
+ * @brief epoll event loop for asynchronous Redis connections
+ */
+
+#include "epoll.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <time.h>
+
+/*!
+ * @brief Adapter state of an attached connection
+ */
+struct redis_epoll_events {
+  struct redis_epoll* loop;
+  redisAsyncContext* ac;
+  int fd;
+  uint32_t events;    ///< Events hiredis waits for
+  uint64_t deadline;  ///< Timeout, in milliseconds of the monotonic clock (0 if none)
+  uint8_t released;   ///< Whether hiredis is done with the connection
+  struct redis_epoll_events *prev, *next;
+};
+
+static uint64_t now_ms() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Changes the events a connection waits for
+ * @param[in] e Adapter state
+ * @param[in] events epoll events
+ */
+static void wait_for(struct redis_epoll_events* e, uint32_t events) {
+  struct epoll_event ev = {.events = events, .data.ptr = e};
+
+  if (events == e->events)
+    return;
+
+  epoll_ctl(e->loop->fd, EPOLL_CTL_MOD, e->fd, &ev);
+  e->events = events;
+}
+
+static void add_read(void* privdata) {
+  struct redis_epoll_events* e = privdata;
+  wait_for(e, e->events | EPOLLIN);
+}
+
+static void del_read(void* privdata) {
+  struct redis_epoll_events* e = privdata;
+  wait_for(e, e->events & ~EPOLLIN);
+}
+
+static void add_write(void* privdata) {
+  struct redis_epoll_events* e = privdata;
+  wait_for(e, e->events | EPOLLOUT);
+}
+
+static void del_write(void* privdata) {
+  struct redis_epoll_events* e = privdata;
+  wait_for(e, e->events & ~EPOLLOUT);
+}
+
+static void schedule_timer(void* privdata, struct timeval tv) {
+  struct redis_epoll_events* e = privdata;
+  e->deadline = now_ms() + tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+/**
+ * @brief Detaches a connection that hiredis is freeing
+ * @details Events for it may still be waiting to be handled in the current run, so its state is
+ * only freed at the end of the run.
+ * @param[in] privdata Adapter state
+ */
+static void cleanup(void* privdata) {
+  struct redis_epoll_events* e = privdata;
+  struct redis_epoll* loop = e->loop;
+
+  epoll_ctl(loop->fd, EPOLL_CTL_DEL, e->fd, NULL);
+
+  if (e->prev)
+    e->prev->next = e->next;
+  else
+    loop->attached = e->next;
+  if (e->next)
+    e->next->prev = e->prev;
+
+  e->released = 1;
+  e->next = loop->released;
+  loop->released = e;
+}
+
+int redis_epoll_init(struct redis_epoll* loop) {
+  *loop = (struct redis_epoll){.fd = epoll_create1(EPOLL_CLOEXEC)};
+
+  return loop->fd < 0 ? -1 : 0;
+}
+
+int redis_epoll_attach(struct redis_epoll* loop, redisAsyncContext* ac) {
+  struct redis_epoll_events* e;
+  struct epoll_event ev = {0};
+
+  if (ac->ev.data != NULL)
+    return REDIS_ERR;
+
+  e = calloc(1, sizeof(*e));
+  if (e == NULL)
+    return REDIS_ERR;
+
+  *e = (struct redis_epoll_events){.loop = loop, .ac = ac, .fd = ac->c.fd, .next = loop->attached};
+  ev.data.ptr = e;
+
+  if (epoll_ctl(loop->fd, EPOLL_CTL_ADD, e->fd, &ev)) {
+    free(e);
+    return REDIS_ERR;
+  }
+
+  if (loop->attached)
+    loop->attached->prev = e;
+  loop->attached = e;
+
+  ac->ev.data = e;
+  ac->ev.addRead = add_read;
+  ac->ev.delRead = del_read;
+  ac->ev.addWrite = add_write;
+  ac->ev.delWrite = del_write;
+  ac->ev.cleanup = cleanup;
+  ac->ev.scheduleTimer = schedule_timer;
+
+  return REDIS_OK;
+}
+
+int redis_epoll_run(struct redis_epoll* loop, int timeout_ms) {
+  struct epoll_event events[REDIS_EPOLL_EVENTS];
+  struct redis_epoll_events *e, *next;
+  uint64_t now = now_ms(), nearest = 0;
+  int count;
+
+  // Command timeouts are rare, so a linear pass is cheaper than keeping them sorted
+  for (e = loop->attached; e; e = e->next) {
+    if (e->deadline && (nearest == 0 || e->deadline < nearest))
+      nearest = e->deadline;
+  }
+
+  if (nearest && (timeout_ms < 0 || nearest < now + timeout_ms))
+    timeout_ms = nearest > now ? nearest - now : 0;
+
+  count = epoll_wait(loop->fd, events, REDIS_EPOLL_EVENTS, timeout_ms);
+  if (count < 0)
+    return errno == EINTR ? 0 : -1;
+
+  for (int i = 0; i < count; i++) {
+    uint32_t ready = events[i].events;
+
+    e = events[i].data.ptr;
+
+    // Errors and hangups are reported through whichever handler hiredis waits on
+    if (ready & (EPOLLERR | EPOLLHUP))
+      ready |= e->events;
+
+    if (!e->released && (ready & e->events & EPOLLIN))
+      redisAsyncHandleRead(e->ac);
+    if (!e->released && (ready & e->events & EPOLLOUT))
+      redisAsyncHandleWrite(e->ac);
+  }
+
+  now = now_ms();
+  for (e = loop->attached; e; e = next) {
+    next = e->next;
+
+    if (!e->released && e->deadline && e->deadline <= now) {
+      e->deadline = 0;
+      redisAsyncHandleTimeout(e->ac);
+      count++;
+    }
+  }
+
+  while (loop->released) {
+    e = loop->released;
+    loop->released = e->next;
+    free(e);
+  }
+
+  return count;
+}
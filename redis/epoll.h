@@ -0,0 +1,66 @@
+/*! @file epoll.h
+ * @brief Declarations for the epoll event loop of asynchronous Redis connections
+ */
+
+#ifndef REDIS_EPOLL_H
+#define REDIS_EPOLL_H
+
+#include <hiredis/async.h>
+#include <stdint.h>
+
+/// Most events handled per wait
+#define REDIS_EPOLL_EVENTS 64
+
+struct redis_epoll_events;
+
+/*!
+ * @brief Event loop serving many asynchronous Redis connections from a single thread
+ */
+struct redis_epoll {
+  int fd;
+  struct redis_epoll_events* attached;  ///< Attached connections, for command timeouts
+  struct redis_epoll_events* released;  ///< Detached during the current run, freed at its end
+};
+
+/**
+ * \ingroup redis
+ * \defgroup redisEpoll Event loop
+ * @brief hiredis adapter multiplexing asynchronous connections over one epoll instance
+ * @details Unlike the poll adapter, which waits on a single connection, a loop serves every
+ * connection attached to it at once, so one thread can talk to hundreds of servers. Command and
+ * connection timeouts set through redisOptions are honored.
+ */
+
+/**
+ * \ingroup redisEpoll
+ * @brief Creates an event loop
+ * @param[out] loop Event loop
+ * @retval 0 OK
+ * @retval -1 The epoll instance could not be created
+ */
+int redis_epoll_init(struct redis_epoll* loop);
+
+/**
+ * \ingroup redisEpoll
+ * @brief Attaches an asynchronous connection to an event loop
+ * @details Must be called before setting the connection's connect callback, which is what starts
+ * waiting for the connection to complete. The connection detaches itself when it is freed.
+ * @param[in] loop Event loop
+ * @param[in] ac Asynchronous connection (not attached to any other event loop)
+ * @retval REDIS_OK OK
+ * @retval REDIS_ERR Already attached, or out of memory
+ */
+int redis_epoll_attach(struct redis_epoll* loop, redisAsyncContext* ac);
+
+/**
+ * \ingroup redisEpoll
+ * @brief Waits for events on the attached connections and handles them
+ * @details Returns early when a command or connection times out, after handling it.
+ * @param[in] loop Event loop
+ * @param[in] timeout_ms Longest wait, in milliseconds (<0 waits until something happens)
+ * @returns Amount of events handled
+ * @retval -1 Wait failed
+ */
+int redis_epoll_run(struct redis_epoll* loop, int timeout_ms);
+
+#endif
@@ -60,21 +60,7 @@ float sensirion_bytes_to_float(const uint8_t* bytes) {
 }
 
 uint8_t sensirion_common_generate_crc(const uint8_t* data, uint16_t count) {
-  uint16_t current_byte;
-  uint8_t crc = CRC8_INIT;
-  uint8_t crc_bit;
-
-  /* calculates 8-Bit checksum with given polynomial */
-  for (current_byte = 0; current_byte < count; ++current_byte) {
-    crc ^= (data[current_byte]);
-    for (crc_bit = 8; crc_bit > 0; --crc_bit) {
-      if (crc & 0x80)
-        crc = (crc << 1) ^ CRC8_POLYNOMIAL;
-      else
-        crc = (crc << 1);
-    }
-  }
-  return crc;
+  return sensirion_crc8(data, count);
 }
 
 int8_t sensirion_common_check_crc(const uint8_t* data, uint16_t count, uint8_t checksum) {
@@ -119,7 +105,6 @@ int8_t sensirion_i2c_read_words_as_bytes(struct sht3x_sensor_data* sensor,
                                          uint8_t* data,
                                          uint16_t num_words) {
   int8_t ret;
-  uint16_t i, j;
   uint32_t size = num_words * (SENSIRION_WORD_SIZE + CRC8_LEN);
   uint16_t word_buf[SENSIRION_MAX_BUFFER_WORDS];
   uint8_t* const buf8 = (uint8_t*)word_buf;
@@ -134,17 +119,8 @@ int8_t sensirion_i2c_read_words_as_bytes(struct sht3x_sensor_data* sensor,
   if (ret != NO_ERROR)
     return ret;
 
-  /* check the CRC for each word */
-  for (i = 0, j = 0; i < size; i += SENSIRION_WORD_SIZE + CRC8_LEN) {
-    ret = sensirion_common_check_crc(&buf8[i], SENSIRION_WORD_SIZE, buf8[i + SENSIRION_WORD_SIZE]);
-    if (ret != NO_ERROR)
-      return ret;
-
-    data[j++] = buf8[i];
-    data[j++] = buf8[i + 1];
-  }
-
-  return NO_ERROR;
+  /* check the CRC of every word in one pass */
+  return sensirion_crc8_unpack_words(buf8, data, num_words) ? STATUS_FAIL : NO_ERROR;
 }
 
 int8_t sensirion_i2c_read_words(struct sht3x_sensor_data* sensor,
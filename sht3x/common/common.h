@@ -47,10 +47,6 @@ extern "C" {
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof(*(x)))
 #endif
 
-#define CRC8_POLYNOMIAL 0x31
-#define CRC8_INIT 0xFF
-#define CRC8_LEN 1
-
 #define SENSIRION_COMMAND_SIZE 2
 #define SENSIRION_WORD_SIZE 2
 #define SENSIRION_NUM_WORDS(x) (sizeof(x) / SENSIRION_WORD_SIZE)
@@ -59,6 +55,7 @@ extern "C" {
 #define MAX_NAME_LEN 16
 
 #include "../sht3x.h"
+#include "crc8.h"
 
 /**
  * @brief Convert an array of bytes to an uint16_t
@@ -0,0 +1,49 @@
+/*! @file crc8.c
+ * @brief Sensirion CRC-8
+ */
+
+#include "crc8.h"
+
+#include "crc8_table.h"
+
+#if CRC8_TABLE_POLYNOMIAL != CRC8_POLYNOMIAL
+#error "sht3x/common/crc8_table.h is out of date, run make crc8_table"
+#endif
+
+// Word and CRC
+#define SENSIRION_CRC8_WORD 3
+
+uint8_t sensirion_crc8(const uint8_t* data, uint16_t count) {
+  uint8_t crc = CRC8_INIT;
+
+  for (uint16_t i = 0; i < count; i++)
+    crc = sensirion_crc8_table[crc ^ data[i]];
+  return crc;
+}
+
+uint8_t sensirion_crc8_scalar(const uint8_t* data, uint16_t count) {
+  uint8_t crc = CRC8_INIT;
+
+  for (uint16_t i = 0; i < count; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++)
+      crc = crc & 0x80 ? (crc << 1) ^ CRC8_POLYNOMIAL : crc << 1;
+  }
+  return crc;
+}
+
+int8_t sensirion_crc8_unpack_words(const uint8_t* buf, uint8_t* data, uint16_t num_words) {
+  uint8_t mismatch = 0, b0, b1, crc;
+
+  for (uint16_t i = 0; i < num_words; i++, buf += SENSIRION_CRC8_WORD) {
+    b0 = buf[0];
+    b1 = buf[1];
+    crc = buf[2];
+
+    mismatch |= sensirion_crc8_table[sensirion_crc8_table[CRC8_INIT ^ b0] ^ b1] ^ crc;
+    data[2 * i] = b0;
+    data[2 * i + 1] = b1;
+  }
+
+  return mismatch ? -1 : 0;
+}
@@ -0,0 +1,53 @@
+/*! @file crc8.h
+ * @brief Declarations for the Sensirion CRC-8
+ */
+
+#ifndef SENSIRION_CRC8_H
+#define SENSIRION_CRC8_H
+
+#include <stdint.h>
+
+/// CRC-8 of every Sensirion I2C sensor; regenerate sht3x/common/crc8_table.h after changing it
+#define CRC8_POLYNOMIAL 0x31
+#define CRC8_INIT 0xFF
+#define CRC8_LEN 1
+
+/**
+ * \ingroup sht3x
+ * \defgroup sensirionCrc CRC-8
+ * @brief Table-driven CRC-8 for Sensirion sensors, with precomputed tables
+ * (sht3x/common/crc8_table.h)
+ *
+ * @details Sensirion sensors (SHT3x, SHT4x, SGP, SCD...) send their responses as 16-bit words,
+ * each followed by its CRC-8, so any of their drivers can validate and unpack a response with
+ * sensirion_crc8_unpack_words().
+ */
+
+/**
+ * \ingroup sensirionCrc
+ * @brief Computes the CRC-8 of a buffer, a byte at a time
+ * @param[in] data Data
+ * @param[in] count Amount of bytes
+ * @returns CRC-8
+ */
+uint8_t sensirion_crc8(const uint8_t* data, uint16_t count);
+
+/**
+ * \ingroup sensirionCrc
+ * @brief Scalar reference for sensirion_crc8(), a bit at a time
+ */
+uint8_t sensirion_crc8_scalar(const uint8_t* data, uint16_t count);
+
+/**
+ * \ingroup sensirionCrc
+ * @brief Checks every word of a response and strips their CRCs, in a single pass
+ * @details Mismatches are accumulated and checked once, at the end.
+ * @param[in] buf Response: 2-byte words, each followed by its CRC-8
+ * @param[out] data Word bytes, without their CRCs (2 bytes per word, may be `buf`)
+ * @param[in] num_words Amount of words
+ * @retval 0 Every CRC matched
+ * @retval -1 At least one CRC did not match (`data` holds every word anyway)
+ */
+int8_t sensirion_crc8_unpack_words(const uint8_t* buf, uint8_t* data, uint16_t num_words);
+
+#endif
@@ -0,0 +1,39 @@
+/*! @file crc8_table.c
+ * @brief Generates sht3x/common/crc8_table.h (`make crc8_table`)
+ *
+ * @details Prints the CRC-8 of every byte value for CRC8_POLYNOMIAL, so that the CRC is computed
+ * a byte at a time instead of a bit at a time.
+ */
+
+#include <stdio.h>
+
+#include "../common/crc8.h"
+
+// Values per line, keeping lines within 100 columns
+#define BYTES_PER_LINE 12
+
+int main() {
+  uint8_t crc;
+
+  printf("/*! @file crc8_table.h\n");
+  printf(" * @brief CRC-8 table for polynomial 0x%02X, generated by sht3x/gen/crc8_table.c "
+         "(do not edit)\n",
+         CRC8_POLYNOMIAL);
+  printf(" */\n\n");
+  printf("#ifndef SENSIRION_CRC8_TABLE_H\n#define SENSIRION_CRC8_TABLE_H\n\n");
+  printf("#include <stdint.h>\n\n");
+  printf("#define CRC8_TABLE_POLYNOMIAL 0x%02X\n\n", CRC8_POLYNOMIAL);
+
+  printf("// CRC-8 of each byte value, starting from 0\n");
+  printf("static const uint8_t sensirion_crc8_table[256] = {");
+  for (int k = 0; k < 256; k++) {
+    crc = k;
+    for (int bit = 0; bit < 8; bit++)
+      crc = crc & 0x80 ? (crc << 1) ^ CRC8_POLYNOMIAL : crc << 1;
+    printf("%s0x%02X", k == 0 ? "\n    " : k % BYTES_PER_LINE ? ", " : ",\n    ", crc);
+  }
+  printf("\n};\n\n");
+
+  printf("#endif\n");
+  return 0;
+}
@@ -43,6 +43,7 @@
 #include <stddef.h>
 #include <sys/ioctl.h>
 #include <syslog.h>
+#include <time.h>
 #include <unistd.h>
 #include "arch_config.h"
 #include "common/common.h"
@@ -75,11 +76,21 @@ static const uint16_t SHT3X_CMD_WRITE_HIALRT_LIM_SET = 0x611D;
 static const uint16_t SHT3X_CMD_WRITE_HIALRT_LIM_CLR = 0x6116;
 static const uint16_t SHT3X_CMD_WRITE_LOALRT_LIM_CLR = 0x610B;
 static const uint16_t SHT3X_CMD_WRITE_LOALRT_LIM_SET = 0x6100;
+/* periodic acquisition commands */
+static const uint16_t SHT3X_CMD_FETCH_DATA = 0xE000;
+static const uint16_t SHT3X_CMD_ART = 0x2B32;
+static const uint16_t SHT3X_CMD_BREAK = 0x3093;
+/* periodic measurement commands per rate, in low/medium/high repeatability */
+static const uint16_t SHT3X_CMD_PERIODIC[][3] = {
+    {0x202F, 0x2024, 0x2032}, /* 0.5 mps */
+    {0x212D, 0x2126, 0x2130}, /* 1 mps */
+    {0x222B, 0x2220, 0x2236}, /* 2 mps */
+    {0x2329, 0x2322, 0x2334}, /* 4 mps */
+    {0x272A, 0x2721, 0x2737}, /* 10 mps */
+};
 
 static uint16_t sht3x_cmd_measure = SHT3X_CMD_MEASURE_HPM;
-
-int8_t fd_44 = 0;
-int8_t fd_45 = 0;
+static sht3x_measurement_mode_t sht3x_repeatability = SHT3X_MEAS_MODE_HPM;
 
 int8_t sht3x_init(struct sht3x_sensor_data* sht, uint8_t addr) {
   int8_t rslt = STATUS_OK;
@@ -89,16 +100,15 @@ int8_t sht3x_init(struct sht3x_sensor_data* sht, uint8_t addr) {
     exit(1);
   }
 
-  int8_t* fd = addr == SHT3X_I2C_ADDR_DFLT ? &fd_44 : &fd_45;
-
-  if (i2c_open(fd, addr)) {
+  if (i2c_open(&sht->id, addr)) {
     syslog(LOG_CRIT, "Failed to open bus");
     exit(SENSOR_FAIL);
   }
 
-  ioctl(*fd, 0x0703, addr);
+  // A sensor left in periodic mode (by a previous run) only answers fetch and break commands
+  if (sensirion_i2c_write_cmd(sht, SHT3X_CMD_BREAK) == STATUS_OK)
+    delay_us(SHT3X_CMD_DURATION_USEC, NULL);
 
-  sht->id.fd = *fd;
   rslt = sht3x_probe(sht);
 
   return rslt;
@@ -117,9 +127,56 @@ int16_t sht3x_measure(struct sht3x_sensor_data* sht) {
   return sensirion_i2c_write_cmd(sht, sht3x_cmd_measure);
 }
 
+static uint64_t now_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int16_t sht3x_measure_batch(struct sht3x_sensor_data* sensors, uint8_t count, int16_t* rslt) {
+  int16_t ret = STATUS_OK;
+
+  for (uint8_t i = 0; i < count; i++) {
+    rslt[i] = sht3x_measure(&sensors[i]);
+    sensors[i].ready_ns = now_ns() + SHT3X_MEASUREMENT_DURATION_USEC * 1000ULL;
+
+    if (rslt[i] != STATUS_OK && ret == STATUS_OK)
+      ret = rslt[i];
+  }
+
+  return ret;
+}
+
+int16_t sht3x_read_batch(struct sht3x_sensor_data* sensors, uint8_t count, int16_t* rslt) {
+  int16_t ret = STATUS_OK;
+  struct timespec ready;
+
+  for (uint8_t i = 0; i < count; i++) {
+    if (rslt[i] == STATUS_OK) {
+      // Sensors are read in the order they were started, so only the first wait is usually long
+      ready.tv_sec = sensors[i].ready_ns / 1000000000ULL;
+      ready.tv_nsec = sensors[i].ready_ns % 1000000000ULL;
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ready, NULL))
+        continue;
+
+      rslt[i] = sht3x_read(&sensors[i]);
+    }
+
+    if (rslt[i] != STATUS_OK && ret == STATUS_OK)
+      ret = rslt[i];
+  }
+
+  return ret;
+}
+
 int16_t sht3x_read(struct sht3x_sensor_data* sht) {
   uint16_t words[2];
   int16_t ret = sensirion_i2c_read_words(sht, words, SENSIRION_NUM_WORDS(words));
+
+  if (ret != STATUS_OK)
+    return ret;
+
   /**
    * formulas for conversion of the sensor signals, optimized for fixed point
    * algebra: Temperature = 175 * S_T / 2^16 - 45
@@ -152,9 +209,12 @@ int16_t sht3x_clear_status(struct sht3x_sensor_data* sht) {
 
 void sht3x_enable_low_power_mode(uint8_t enable_low_power_mode) {
   sht3x_cmd_measure = enable_low_power_mode ? SHT3X_CMD_MEASURE_LPM : SHT3X_CMD_MEASURE_HPM;
+  sht3x_repeatability = enable_low_power_mode ? SHT3X_MEAS_MODE_LPM : SHT3X_MEAS_MODE_HPM;
 }
 
 void sht3x_set_power_mode(sht3x_measurement_mode_t mode) {
+  sht3x_repeatability = mode <= SHT3X_MEAS_MODE_HPM ? mode : SHT3X_MEAS_MODE_HPM;
+
   switch (mode) {
     case SHT3X_MEAS_MODE_LPM: {
       sht3x_cmd_measure = SHT3X_CMD_MEASURE_LPM;
@@ -175,6 +235,32 @@ void sht3x_set_power_mode(sht3x_measurement_mode_t mode) {
   }
 }
 
+int16_t sht3x_start_periodic(struct sht3x_sensor_data* sht, sht3x_periodic_rate_t rate) {
+  if (rate == SHT3X_PERIODIC_ART)
+    return sensirion_i2c_write_cmd(sht, SHT3X_CMD_ART);
+
+  if (rate > SHT3X_PERIODIC_10_MPS)
+    return STATUS_ERR_INVALID_PARAMS;
+
+  return sensirion_i2c_write_cmd(sht, SHT3X_CMD_PERIODIC[rate][sht3x_repeatability]);
+}
+
+int16_t sht3x_stop_periodic(struct sht3x_sensor_data* sht) {
+  int16_t ret = sensirion_i2c_write_cmd(sht, SHT3X_CMD_BREAK);
+
+  if (ret == STATUS_OK)
+    delay_us(SHT3X_CMD_DURATION_USEC, NULL);
+  return ret;
+}
+
+int16_t sht3x_fetch(struct sht3x_sensor_data* sht) {
+  int16_t ret = sensirion_i2c_write_cmd(sht, SHT3X_CMD_FETCH_DATA);
+
+  if (ret != STATUS_OK)
+    return ret;
+  return sht3x_read(sht);
+}
+
 int16_t sht3x_read_serial(struct sht3x_sensor_data* sht, uint32_t* serial) {
   int16_t ret;
   uint8_t serial_bytes[4];
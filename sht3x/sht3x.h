@@ -86,6 +86,7 @@ struct sht3x_sensor_data {
   struct sht3x_data data;
   struct identifier id;
   char name[MAX_NAME_LEN];
+  uint64_t ready_ns;  ///< When the pending measurement completes, in ns of CLOCK_MONOTONIC
 };
 
 /**
@@ -105,6 +106,18 @@ typedef enum _sht3x_measurement_mode {
   SHT3X_MEAS_MODE_HPM  /*high power mode*/
 } sht3x_measurement_mode_t;
 
+/**
+ * @brief SHT3x periodic acquisition rates, in measurements per second (mps)
+ */
+typedef enum _sht3x_periodic_rate {
+  SHT3X_PERIODIC_0_5_MPS,
+  SHT3X_PERIODIC_1_MPS,
+  SHT3X_PERIODIC_2_MPS,
+  SHT3X_PERIODIC_4_MPS,
+  SHT3X_PERIODIC_10_MPS,
+  SHT3X_PERIODIC_ART /*accelerated response time, 4 mps*/
+} sht3x_periodic_rate_t;
+
 /**
  * @brief SHT3x Alert Thresholds
  */
@@ -215,6 +228,37 @@ int16_t sht3x_measure(struct sht3x_sensor_data* sensor);
  */
 int16_t sht3x_read(struct sht3x_sensor_data* sensor);
 
+/**
+ * \ingroup sht3xSensorData
+ * @brief Starts a measurement on several sensors, without waiting for any of them
+ *
+ * @details Sensors convert in parallel, so collecting them all with sht3x_read_batch() costs a
+ * single measurement duration instead of one per sensor. The bus is free in between. Sensors
+ * should be sorted by channel, to keep multiplexer switching to a minimum.
+ *
+ * @param[in, out] sensors          : Sensors
+ * @param[in] count                 : Amount of sensors
+ * @param[out] rslt                 : Result for each sensor (0 or an error code)
+ *
+ * @return 0 if every measurement was started, else the first error code.
+ */
+int16_t sht3x_measure_batch(struct sht3x_sensor_data* sensors, uint8_t count, int16_t* rslt);
+
+/**
+ * \ingroup sht3xSensorData
+ * @brief Reads out the measurements started by sht3x_measure_batch()
+ *
+ * @details Waits for each sensor's measurement to complete before reading it. Sensors whose
+ * measurement could not be started are skipped and keep their error code.
+ *
+ * @param[in, out] sensors          : Sensors, as given to sht3x_measure_batch()
+ * @param[in] count                 : Amount of sensors
+ * @param[in, out] rslt             : Result for each sensor (0 or an error code)
+ *
+ * @return 0 if every sensor was read, else the first error code.
+ */
+int16_t sht3x_read_batch(struct sht3x_sensor_data* sensors, uint8_t count, int16_t* rslt);
+
 /**
  * \ingroup sht3x
  * \defgroup sht3xSensorPower Sensor Power
@@ -237,6 +281,54 @@ void sht3x_enable_low_power_mode(uint8_t enable_low_power_mode);
  */
 void sht3x_set_power_mode(sht3x_measurement_mode_t mode);
 
+/**
+ * \ingroup sht3x
+ * \defgroup sht3xPeriodic Periodic Acquisition
+ * @brief Continuous conversions in the sensor, read out with fetch commands
+ *
+ * @details Once started, the sensor converts on its own at the selected rate, so reading it
+ * costs a single short transaction and no conversion wait. In this mode, the sensor only answers
+ * sht3x_fetch() and sht3x_stop_periodic() (sht3x_init() stops it, in case a previous run left it
+ * converting).
+ */
+
+/**
+ * \ingroup sht3xPeriodic
+ * @brief Starts periodic acquisition
+ *
+ * @details Measurements use the repeatability set by sht3x_set_power_mode(), except in
+ * accelerated response time mode (SHT3X_PERIODIC_ART).
+ *
+ * @param[in] sensor            : Sensor struct
+ * @param[in] rate              : Measurements per second
+ *
+ * @return 0 if the command was successful, else an error code.
+ */
+int16_t sht3x_start_periodic(struct sht3x_sensor_data* sensor, sht3x_periodic_rate_t rate);
+
+/**
+ * \ingroup sht3xPeriodic
+ * @brief Stops periodic acquisition, returning the sensor to single shot mode
+ *
+ * @param[in] sensor            : Sensor struct
+ *
+ * @return 0 if the command was successful, else an error code.
+ */
+int16_t sht3x_stop_periodic(struct sht3x_sensor_data* sensor);
+
+/**
+ * \ingroup sht3xPeriodic
+ * @brief Reads out the latest periodic measurement
+ *
+ * @details The sensor returns each measurement once: if none completed since the last fetch, it
+ * does not acknowledge the read, an error is returned and the sensor data is left as it was.
+ *
+ * @param[in, out] sensor       : Sensor struct
+ *
+ * @return 0 if a new measurement was read, else an error code.
+ */
+int16_t sht3x_fetch(struct sht3x_sensor_data* sensor);
+
 /**
  * @brief Read out the serial number
  *
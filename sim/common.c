@@ -0,0 +1,505 @@
+/*! @file common.c
+ * @brief Simulation backend for hardware access
+ */
+
+#include "common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <linux/spi/spidev.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../spi/common.h"
+#include "devices.h"
+
+#define SIM_MAX_FDS 1024
+#define SIM_SPI_MAX_LEN 4096
+#define SIM_I2C_HZ 100000.0
+#define SIM_PRU_RING_PATH "/tmp/simar_pru_ring"
+#define SIM_PRU_RING_PERIOD_NS 10000000L
+#define SIM_PRU_IEP_ADDR 0x4A32E000
+
+enum sim_fd_type { SIM_FD_NONE, SIM_FD_I2C, SIM_FD_SPI, SIM_FD_MEM, SIM_FD_PRU, SIM_FD_AIN };
+
+/*!
+ * @brief Simulated file descriptor state
+ */
+struct sim_fd {
+  enum sim_fd_type type;
+  uint8_t addr;    ///< I2C slave address
+  uint8_t mode;    ///< SPI mode
+  uint8_t bits;    ///< SPI bits per word
+  uint32_t speed;  ///< SPI clock (Hz)
+};
+
+static struct sim_fd fds[SIM_MAX_FDS];
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t sim_once = PTHREAD_ONCE_INIT;
+static struct sim_stats stats;
+static uint8_t timing = 1;
+
+static const uint32_t gpio_addresses[4] = {GPIO0_ADDR, GPIO1_ADDR, GPIO2_ADDR, GPIO3_ADDR};
+static uint32_t gpio_banks[4][GPIO_LENGTH / 4] __attribute__((aligned(GPIO_LENGTH)));
+
+// SPI module selector, and the registers behind each address
+static uint8_t selector;
+static uint8_t ext_latch[16];
+static uint8_t out_latch[16];
+
+static struct sim_pru pru;
+static uint32_t pru_iep_page[1024];
+static struct sim_pru_ring pru_ring = {.seed = 0xED6E};
+
+static void sim_init() {
+  const char* env = getenv("SIMAR_SIM_TIMING");
+
+  timing = env == NULL || strcmp(env, "0") != 0;
+  sim_devices_init();
+}
+
+/**
+ * @brief Sleeps for the time a transfer would take on the bus
+ * @param[in] seconds Transfer duration
+ */
+static void bus_delay(double seconds) {
+  if (timing && seconds > 0)
+    nanosleep((const struct timespec[]){{0, seconds * 1e9}}, NULL);
+}
+
+/**
+ * @brief Checks whether a GPIO output is driven high
+ */
+static uint8_t gpio_level(int pin) {
+  return (gpio_banks[pin / 32][MMIO_GPIO_DATAOUT / 4] >> (pin % 32)) & 1;
+}
+
+static struct sim_fd* lookup(int fd) {
+  if (fd < 0 || fd >= SIM_MAX_FDS || fds[fd].type == SIM_FD_NONE)
+    return NULL;
+  return &fds[fd];
+}
+
+/**
+ * @brief Runs one I2C message against the device currently reachable at an address
+ * @details The digital interface board channel comes from the mux GPIOs (P9_15 and P9_16). On
+ * channel 3, if the SPI module selector points to an expansion board's multiplexer, the channel
+ * latched into that board is used as well.
+ * @retval 0 ACK
+ * @retval -1 NACK
+ */
+static int i2c_message(uint8_t addr, uint8_t* buf, uint16_t len, uint8_t read) {
+  uint8_t channel = gpio_level(P9_16) << 1 | gpio_level(P9_15);
+  int8_t ext_channel = SIM_NO_EXT;
+  struct sim_device* dev;
+
+  if (channel == 3 && (selector & 0x07) == 2)
+    ext_channel = ext_latch[(selector >> 3) & 0x0F];
+
+  stats.i2c_bytes += len + 1;
+  bus_delay((len + 1) * 9 / SIM_I2C_HZ);
+
+  dev = sim_device_find(channel, ext_channel, addr);
+  if (dev == NULL)
+    return -1;
+
+  return read ? sim_device_read(dev, buf, len) : sim_device_write(dev, buf, len);
+}
+
+/**
+ * @brief Clocks a full-duplex transfer through the SPI bus
+ * @details With the data select pin (P9_14) low, bytes go to the module selector; otherwise they
+ * reach the module it points to: the ADC at address 0, output latches (module 1), expansion board
+ * multiplexers (module 2) and digital inputs (module 3) elsewhere.
+ */
+static void spi_xfer(struct sim_fd* f,
+                     const uint8_t* tx,
+                     uint8_t* rx,
+                     uint32_t len,
+                     uint32_t speed) {
+  uint8_t addr = (selector >> 3) & 0x0F, module = selector & 0x07;
+  uint8_t last = tx && len ? tx[len - 1] : 0;
+  uint16_t frame;
+
+  stats.spi_bytes += len;
+  bus_delay(len * 8.0 / (speed ? speed : f->speed));
+
+  if (!gpio_level(P9_14)) {
+    // tx and rx may be the same buffer
+    for (uint32_t i = 0; i < len; i++) {
+      uint8_t shifted = selector;
+
+      selector = tx ? tx[i] : 0;
+      if (rx)
+        rx[i] = shifted;
+    }
+    return;
+  }
+
+  if (addr == 0 && module == 1) {
+    for (uint32_t i = 0; i + 1 < len; i += 2) {
+      frame = sim_adc_frame(tx ? tx[i] | tx[i + 1] << 8 : 0);
+      if (rx) {
+        rx[i] = frame;
+        rx[i + 1] = frame >> 8;
+      }
+    }
+    return;
+  }
+
+  if (module == 1)
+    out_latch[addr] = last;
+  else if (module == 2)
+    ext_latch[addr] = last;
+
+  if (rx)
+    memset(rx, module == 3 ? 0xFF : 0x00, len);
+}
+
+int sim_open(const char* path, int flags, ...) {
+  enum sim_fd_type type = SIM_FD_NONE;
+  va_list ap;
+  mode_t mode;
+  int fd;
+
+  pthread_once(&sim_once, sim_init);
+
+  pthread_mutex_lock(&sim_lock);
+  stats.syscalls++;
+  pthread_mutex_unlock(&sim_lock);
+
+  if (strncmp(path, "/dev/i2c-", 9) == 0)
+    type = SIM_FD_I2C;
+  else if (strncmp(path, "/dev/spidev", 11) == 0)
+    type = SIM_FD_SPI;
+  else if (strcmp(path, "/dev/mem") == 0)
+    type = SIM_FD_MEM;
+  else if (strncmp(path, "/dev/rpmsg_pru", 14) == 0)
+    type = SIM_FD_PRU;
+  else if (strncmp(path, "/sys/bus/iio/devices/", 21) == 0)
+    type = SIM_FD_AIN;
+
+  if (type == SIM_FD_NONE) {
+    va_start(ap, flags);
+    mode = flags & O_CREAT ? va_arg(ap, mode_t) : 0;
+    va_end(ap);
+    return open(path, flags, mode);
+  }
+
+  // Simulated files are backed by an eventfd, so that they get a unique descriptor and can be
+  // waited on with poll()/epoll()
+  fd = eventfd(0, EFD_SEMAPHORE | (flags & O_NONBLOCK ? EFD_NONBLOCK : 0));
+  if (fd < 0)
+    return -1;
+
+  if (fd >= SIM_MAX_FDS) {
+    close(fd);
+    errno = EMFILE;
+    return -1;
+  }
+
+  pthread_mutex_lock(&sim_lock);
+  fds[fd] = (struct sim_fd){.type = type, .bits = 8, .speed = 500000};
+  pthread_mutex_unlock(&sim_lock);
+
+  return fd;
+}
+
+int sim_close(int fd) {
+  pthread_mutex_lock(&sim_lock);
+  stats.syscalls++;
+  if (lookup(fd))
+    fds[fd].type = SIM_FD_NONE;
+  pthread_mutex_unlock(&sim_lock);
+
+  return close(fd);
+}
+
+ssize_t sim_read(int fd, void* buf, size_t len) {
+  struct sim_fd* f;
+  uint64_t pending;
+  ssize_t ret = len;
+  char value[8];
+
+  pthread_mutex_lock(&sim_lock);
+  stats.syscalls++;
+  f = lookup(fd);
+
+  if (f == NULL) {
+    pthread_mutex_unlock(&sim_lock);
+    return read(fd, buf, len);
+  }
+
+  switch (f->type) {
+    case SIM_FD_I2C:
+      if (i2c_message(f->addr, buf, len, 1)) {
+        errno = ENXIO;
+        ret = -1;
+      }
+      break;
+    case SIM_FD_SPI:
+      spi_xfer(f, NULL, buf, len, 0);
+      break;
+    case SIM_FD_AIN:
+      ret = snprintf(value, sizeof(value), "%d\n", sim_fan_value());
+      ret = (size_t)ret < len ? ret : (ssize_t)len;
+      memcpy(buf, value, ret);
+      break;
+    case SIM_FD_PRU:
+      // Blocks (outside the lock) until the firmware has a message queued
+      pthread_mutex_unlock(&sim_lock);
+      if (read(fd, &pending, sizeof(pending)) < 0)
+        return -1;
+      pthread_mutex_lock(&sim_lock);
+
+      ret = len < SIM_PRU_MSG_LEN ? len : SIM_PRU_MSG_LEN;
+      memcpy(buf, pru.queue[pru.head], ret);
+      pru.head = (pru.head + 1) % SIM_PRU_QUEUE_LEN;
+      pru.count--;
+      break;
+    default:
+      errno = EINVAL;
+      ret = -1;
+  }
+
+  pthread_mutex_unlock(&sim_lock);
+  return ret;
+}
+
+ssize_t sim_write(int fd, const void* buf, size_t len) {
+  struct sim_fd* f;
+  ssize_t ret = len;
+  uint8_t queued;
+
+  pthread_mutex_lock(&sim_lock);
+  stats.syscalls++;
+  f = lookup(fd);
+
+  if (f == NULL) {
+    pthread_mutex_unlock(&sim_lock);
+    return write(fd, buf, len);
+  }
+
+  switch (f->type) {
+    case SIM_FD_I2C:
+      if (i2c_message(f->addr, (uint8_t*)buf, len, 0)) {
+        errno = ENXIO;
+        ret = -1;
+      }
+      break;
+    case SIM_FD_SPI:
+      spi_xfer(f, buf, NULL, len, 0);
+      break;
+    case SIM_FD_PRU:
+      queued = sim_pru_kick(&pru);
+      if (queued)
+        eventfd_write(fd, queued);
+      break;
+    default:
+      errno = EINVAL;
+      ret = -1;
+  }
+
+  pthread_mutex_unlock(&sim_lock);
+  return ret;
+}
+
+/**
+ * @brief Handles the I2C_RDWR ioctl: every message of the transaction, in order
+ */
+static int i2c_rdwr(struct i2c_rdwr_ioctl_data* data) {
+  for (uint32_t i = 0; i < data->nmsgs; i++) {
+    struct i2c_msg* msg = &data->msgs[i];
+
+    if (i2c_message(msg->addr, msg->buf, msg->len, msg->flags & I2C_M_RD)) {
+      errno = ENXIO;
+      return -1;
+    }
+  }
+
+  return data->nmsgs;
+}
+
+/**
+ * @brief Handles the SPI_IOC_MESSAGE ioctl: every transfer of the message, in order
+ */
+static int spi_message(struct sim_fd* f, struct spi_ioc_transfer* tr, uint32_t count) {
+  int ret = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (tr[i].len > SIM_SPI_MAX_LEN) {
+      errno = EMSGSIZE;
+      return -1;
+    }
+
+    spi_xfer(f, (const uint8_t*)(uintptr_t)tr[i].tx_buf, (uint8_t*)(uintptr_t)tr[i].rx_buf,
+             tr[i].len, tr[i].speed_hz);
+    ret += tr[i].len;
+  }
+
+  return ret;
+}
+
+int sim_ioctl(int fd, unsigned long request, ...) {
+  struct sim_fd* f;
+  va_list ap;
+  void* arg;
+  int ret = 0;
+
+  va_start(ap, request);
+  arg = va_arg(ap, void*);
+  va_end(ap);
+
+  pthread_mutex_lock(&sim_lock);
+  stats.syscalls++;
+  f = lookup(fd);
+
+  if (f == NULL) {
+    pthread_mutex_unlock(&sim_lock);
+    return ioctl(fd, request, arg);
+  }
+
+  if (f->type == SIM_FD_I2C && (request == I2C_SLAVE || request == I2C_SLAVE_FORCE)) {
+    f->addr = (uintptr_t)arg;
+  } else if (f->type == SIM_FD_I2C && request == I2C_RDWR) {
+    ret = i2c_rdwr(arg);
+  } else if (f->type == SIM_FD_SPI && _IOC_TYPE(request) == SPI_IOC_MAGIC &&
+             _IOC_NR(request) == 0) {
+    ret = spi_message(f, arg, _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer));
+  } else if (f->type == SIM_FD_SPI && request == SPI_IOC_WR_MODE) {
+    f->mode = *(uint8_t*)arg;
+  } else if (f->type == SIM_FD_SPI && request == SPI_IOC_RD_MODE) {
+    *(uint8_t*)arg = f->mode;
+  } else if (f->type == SIM_FD_SPI && request == SPI_IOC_WR_BITS_PER_WORD) {
+    f->bits = *(uint8_t*)arg;
+  } else if (f->type == SIM_FD_SPI && request == SPI_IOC_RD_BITS_PER_WORD) {
+    *(uint8_t*)arg = f->bits;
+  } else if (f->type == SIM_FD_SPI && request == SPI_IOC_WR_MAX_SPEED_HZ) {
+    f->speed = *(uint32_t*)arg;
+  } else if (f->type == SIM_FD_SPI && request == SPI_IOC_RD_MAX_SPEED_HZ) {
+    *(uint32_t*)arg = f->speed;
+  } else {
+    errno = ENOTTY;
+    ret = -1;
+  }
+
+  pthread_mutex_unlock(&sim_lock);
+  return ret;
+}
+
+/**
+ * @brief Keeps the file-backed PRU ring fed, as the firmware would
+ */
+static void* pru_ring_feeder() {
+  const struct timespec* period = (const struct timespec[]){{0, SIM_PRU_RING_PERIOD_NS}};
+
+  for (;;) {
+    sim_pru_ring_update(&pru_ring);
+    nanosleep(period, NULL);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Maps the PRU edge ring onto a file (`SIMAR_SIM_PRU_RING`), fed by the model unless
+ * `SIMAR_SIM_PRU_FEED` is 0
+ */
+static void* pru_ring_map(size_t len, int prot, int flags) {
+  const char* path = getenv("SIMAR_SIM_PRU_RING");
+  const char* feed = getenv("SIMAR_SIM_PRU_FEED");
+  static pthread_t feeder;
+  void* map;
+  int fd;
+
+  if (len > sizeof(struct pru_ring)) {
+    errno = EINVAL;
+    return MAP_FAILED;
+  }
+
+  fd = open(path ? path : SIM_PRU_RING_PATH, O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    return MAP_FAILED;
+
+  if (ftruncate(fd, sizeof(struct pru_ring)) < 0) {
+    close(fd);
+    return MAP_FAILED;
+  }
+
+  // The model writes through its own mapping, as the PRU would through shared RAM
+  pthread_mutex_lock(&sim_lock);
+  if (pru_ring.ring == NULL && (feed == NULL || strcmp(feed, "0") != 0)) {
+    map = mmap(NULL, sizeof(struct pru_ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (map != MAP_FAILED) {
+      pru_ring.ring = map;
+      pru_ring.ring->head = 0;
+      pru_ring.ring->magic = PRU_RING_MAGIC;
+      pthread_create(&feeder, NULL, pru_ring_feeder, NULL);
+    }
+  }
+  pthread_mutex_unlock(&sim_lock);
+
+  map = mmap(NULL, len, prot, flags, fd, 0);
+  close(fd);
+
+  return map;
+}
+
+void* sim_mmap(void* addr, size_t len, int prot, int flags, int fd, off_t offset) {
+  struct sim_fd* f;
+
+  pthread_mutex_lock(&sim_lock);
+  stats.syscalls++;
+  f = lookup(fd);
+  pthread_mutex_unlock(&sim_lock);
+
+  if (f == NULL)
+    return mmap(addr, len, prot, flags, fd, offset);
+
+  if (f->type == SIM_FD_MEM && offset == PRU_RING_ARM_ADDR)
+    return pru_ring_map(len, prot, flags);
+
+  // Only mapped for hal_pru_iep, which does not read it
+  if (f->type == SIM_FD_MEM && offset == SIM_PRU_IEP_ADDR && len <= sizeof(pru_iep_page))
+    return pru_iep_page;
+
+  for (uint8_t i = 0; f->type == SIM_FD_MEM && i < 4; i++) {
+    if (offset == gpio_addresses[i] && len <= GPIO_LENGTH)
+      return gpio_banks[i];
+  }
+
+  errno = ENODEV;
+  return MAP_FAILED;
+}
+
+void sim_gpio_latch(volatile uint32_t* base) {
+  pthread_mutex_lock(&sim_lock);
+
+  base[MMIO_GPIO_DATAOUT / 4] |= base[MMIO_GPIO_SETDATAOUT / 4];
+  base[MMIO_GPIO_DATAOUT / 4] &= ~base[MMIO_GPIO_CLEARDATAOUT / 4];
+  base[MMIO_GPIO_SETDATAOUT / 4] = base[MMIO_GPIO_CLEARDATAOUT / 4] = 0;
+  base[MMIO_GPIO_DATAIN / 4] = base[MMIO_GPIO_DATAOUT / 4];
+
+  pthread_mutex_unlock(&sim_lock);
+}
+
+uint32_t sim_pru_iep() {
+  return (uint64_t)(sim_now() * PRU_IEP_HZ);
+}
+
+void sim_get_stats(struct sim_stats* s) {
+  pthread_mutex_lock(&sim_lock);
+  *s = stats;
+  pthread_mutex_unlock(&sim_lock);
+}
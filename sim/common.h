@@ -0,0 +1,108 @@
+/*! @file common.h
+ * @brief Common declarations for the hardware access layer and its simulation backend
+ */
+
+/*!
+ * @defgroup sim Simulation
+ * @brief Hardware-free backend for I2C, SPI, MMIO GPIO, PRU and ADC access
+ *
+ * @details Every hardware access in the bus layers and daemons goes through the hal_* names
+ * declared here. On regular builds they are the plain system calls. When built with
+ * `-DSIMAR_SIM` (`make SIM=1`), they are routed to an in-process model of the SIMAR boards:
+ * BME280 and SHT3x sensors behind the I2C multiplexers, the SPI module selector, I2C extender
+ * and 8-channel ADC of the AC board, the GPIO banks, the PRU glitch/frequency counter and the
+ * fan tachometer analog input. Any path or file descriptor the model does not know is passed
+ * through to the real system call.
+ *
+ * The model is configured through environment variables:
+ * - `SIMAR_SIM_DEVICES`: comma-separated `channel:address` list of I2C sensors (hex address,
+ *   0x76/0x77 are BME280s and 0x44/0x45 are SHT3xs). Sensors on an expansion board are given as
+ *   `3.<expansion channel>:address`. Defaults to `0:76,1:76,2:44,0:45,3:77`.
+ * - `SIMAR_SIM_TIMING`: set to 0 to skip emulating bus transfer times.
+ * - `SIMAR_SIM_PRU_RING`: file backing the PRU edge timestamp ring (pru/ring.h) mapped from
+ *   /dev/mem. Defaults to `/tmp/simar_pru_ring`.
+ * - `SIMAR_SIM_PRU_FEED`: set to 0 to leave the ring to another writer (a recording or a test)
+ *   instead of the simulated firmware.
+ */
+
+#ifndef SIM_COMMON_H
+#define SIM_COMMON_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef SIMAR_SIM
+
+/*!
+ * @brief Simulated hardware access counters
+ */
+struct sim_stats {
+  uint64_t syscalls;   ///< Calls that would have reached the kernel on hardware
+  uint64_t i2c_bytes;  ///< Bytes transferred on the I2C bus
+  uint64_t spi_bytes;  ///< Bytes transferred on the SPI bus
+};
+
+/**
+ * \ingroup sim
+ * \defgroup simCalls System calls
+ * @brief Simulated replacements for the system calls used to access hardware
+ */
+
+/// \ingroup simCalls
+int sim_open(const char* path, int flags, ...);
+/// \ingroup simCalls
+int sim_close(int fd);
+/// \ingroup simCalls
+ssize_t sim_read(int fd, void* buf, size_t len);
+/// \ingroup simCalls
+ssize_t sim_write(int fd, const void* buf, size_t len);
+/// \ingroup simCalls
+int sim_ioctl(int fd, unsigned long request, ...);
+/// \ingroup simCalls
+void* sim_mmap(void* addr, size_t len, int prot, int flags, int fd, off_t offset);
+
+/**
+ * \ingroup sim
+ * @brief Applies pending set/clear register writes of a GPIO bank to its data out register, as
+ * the GPIO module does in hardware
+ * @param[in] base GPIO bank base
+ */
+void sim_gpio_latch(volatile uint32_t* base);
+
+/**
+ * \ingroup sim
+ * @brief Reads the PRU IEP counter, which the simulated edge ring is timestamped with
+ * @returns IEP counter
+ */
+uint32_t sim_pru_iep();
+
+/**
+ * \ingroup sim
+ * @brief Copies the simulated hardware access counters
+ * @param[out] stats Counters
+ */
+void sim_get_stats(struct sim_stats* stats);
+
+#define hal_open sim_open
+#define hal_close sim_close
+#define hal_read sim_read
+#define hal_write sim_write
+#define hal_ioctl sim_ioctl
+#define hal_mmap sim_mmap
+#define hal_gpio_latch(gpio) sim_gpio_latch((gpio).base)
+#define hal_pru_iep(counter) sim_pru_iep()
+
+#else
+
+#define hal_open open
+#define hal_close close
+#define hal_read read
+#define hal_write write
+#define hal_ioctl ioctl
+#define hal_mmap mmap
+#define hal_gpio_latch(gpio)
+#define hal_pru_iep(counter) (*(counter))
+
+#endif
+
+#endif
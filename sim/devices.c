@@ -0,0 +1,428 @@
+/*! @file devices.c
+ * @brief Simulated device models
+ */
+
+#include "devices.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_DEVICES "0:76,1:76,2:44,0:45,3:77"
+
+#define BME280_CHIP_ID_ADDR 0xD0
+#define BME280_RESET_ADDR 0xE0
+#define BME280_RESET_CMD 0xB6
+#define BME280_DATA_ADDR 0xF7
+
+#define SHT3X_CMD_READ_STATUS_REG 0xF32D
+#define SHT3X_CMD_READ_SERIAL_ID 0x3780
+#define SHT3X_CMD_FETCH_DATA 0xE000
+#define SHT3X_CMD_ART 0x2B32
+#define SHT3X_CMD_BREAK 0x3093
+
+#define ADC_WRITE (1 << 15)
+#define ADC_VREF 5.0
+#define LINE_FREQUENCY 60.0
+
+#define PRU_LOOP_HZ 9200000.0
+#define PRU_DUTY 0.95
+#define PRU_JITTER_TICKS 400
+
+#define FAN_RPM 1200.0
+#define FAN_PULSES 3.0
+#define FAN_VALLEY_S 0.003
+
+static struct sim_device devices[SIM_MAX_DEVICES];
+static uint8_t device_count;
+
+/// Datasheet example calibration (dig_T1 through dig_H6), as laid out in the register file
+static const uint8_t bme280_calib_00[26] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,  // T1 = 27504, T2 = 26435, T3 = -1000
+    0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B,  // P1 = 36477, P2 = -10685, P3 = 3024
+    0x27, 0x0B, 0x8C, 0x00, 0xF9, 0xFF,  // P4 = 2855, P5 = 140, P6 = -7
+    0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17,  // P7 = 15500, P8 = -14600, P9 = 6000
+    0x00, 0x4B,                          // H1 = 75
+};
+static const uint8_t bme280_calib_26[7] = {
+    0x6A, 0x01, 0x00,  // H2 = 362, H3 = 0
+    0x13, 0x29, 0x03,  // H4 = 313, H5 = 50
+    0x1E,              // H6 = 30
+};
+
+double sim_now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Pseudo-random measurement noise
+ * @param[in, out] seed Generator state
+ * @param[in] amplitude Maximum absolute value
+ * @returns Noise in [-amplitude, amplitude]
+ */
+static int32_t noise(uint32_t* seed, int32_t amplitude) {
+  *seed = *seed * 1103515245 + 12345;
+  return (int32_t)((*seed >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+static void bme280_reset(struct sim_device* dev) {
+  memset(dev->regs, 0, sizeof(dev->regs));
+  memcpy(&dev->regs[0x88], bme280_calib_00, sizeof(bme280_calib_00));
+  memcpy(&dev->regs[0xE1], bme280_calib_26, sizeof(bme280_calib_26));
+  dev->regs[BME280_CHIP_ID_ADDR] = 0x60;
+
+  // Data registers hold 0x80000 (0x8000 for humidity) until the first conversion
+  dev->regs[0xF7] = dev->regs[0xFA] = dev->regs[0xFD] = 0x80;
+}
+
+/**
+ * @brief Latches a new conversion into the data registers
+ * @details Values sit around 25 °C, 951 hPa and 44 %RH with the datasheet calibration, offset per
+ * device so that sensors can be told apart.
+ */
+static void bme280_convert(struct sim_device* dev) {
+  uint8_t index = dev - devices;
+  uint32_t adc_p = 447148 + index * 400 + noise(&dev->seed, 16);
+  uint32_t adc_t = 519888 + index * 200 + noise(&dev->seed, 16);
+  uint32_t adc_h = 28000 + index * 100 + noise(&dev->seed, 8);
+
+  // Sleep mode: no new conversions
+  if ((dev->regs[0xF4] & 0x03) == 0)
+    return;
+
+  dev->regs[0xF7] = adc_p >> 12;
+  dev->regs[0xF8] = adc_p >> 4;
+  dev->regs[0xF9] = (adc_p & 0x0F) << 4;
+  dev->regs[0xFA] = adc_t >> 12;
+  dev->regs[0xFB] = adc_t >> 4;
+  dev->regs[0xFC] = (adc_t & 0x0F) << 4;
+  dev->regs[0xFD] = adc_h >> 8;
+  dev->regs[0xFE] = adc_h;
+}
+
+/**
+ * @brief Handles a BME280 write: a register pointer, optionally followed by (data, address) pairs
+ */
+static int bme280_write(struct sim_device* dev, const uint8_t* buf, uint16_t len) {
+  uint8_t reg;
+
+  if (len == 0)
+    return -1;
+
+  dev->ptr = buf[0];
+
+  for (uint16_t i = 1; i < len; i += 2) {
+    reg = buf[i - 1];
+
+    if (reg == BME280_RESET_ADDR) {
+      if (buf[i] == BME280_RESET_CMD)
+        bme280_reset(dev);
+    } else if (reg >= 0xF2 && reg <= 0xF5) {
+      dev->regs[reg] = buf[i];
+    }
+  }
+
+  return 0;
+}
+
+static int bme280_read(struct sim_device* dev, uint8_t* buf, uint16_t len) {
+  // Burst reads starting inside the data block see one consistent conversion (shadowing)
+  if (dev->ptr >= BME280_DATA_ADDR && dev->ptr <= 0xFE)
+    bme280_convert(dev);
+
+  for (uint16_t i = 0; i < len; i++)
+    buf[i] = dev->regs[(uint8_t)(dev->ptr + i)];
+
+  dev->ptr += len;
+  return 0;
+}
+
+/**
+ * @brief Sensirion CRC-8 (polynomial 0x31, initialization 0xFF)
+ */
+static uint8_t sht3x_crc(const uint8_t* data, uint8_t len) {
+  uint8_t crc = 0xFF;
+
+  for (uint8_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++)
+      crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+  }
+
+  return crc;
+}
+
+static void sht3x_respond(struct sim_device* dev, uint16_t w0, uint16_t w1, double delay) {
+  dev->out[0] = w0 >> 8;
+  dev->out[1] = w0;
+  dev->out[2] = sht3x_crc(dev->out, 2);
+  dev->out[3] = w1 >> 8;
+  dev->out[4] = w1;
+  dev->out[5] = sht3x_crc(dev->out + 3, 2);
+  dev->out_len = 6;
+  dev->ready = sim_now() + delay;
+}
+
+static int sht3x_start_periodic(struct sim_device* dev, double period) {
+  dev->period = period;
+  dev->next = sim_now() + period;
+  return 0;
+}
+
+static int sht3x_write(struct sim_device* dev, const uint8_t* buf, uint16_t len) {
+  uint8_t index = dev - devices;
+  uint16_t command;
+  double duration, temperature, humidity;
+
+  if (len < 2)
+    return -1;
+
+  command = buf[0] << 8 | buf[1];
+  dev->out_len = 0;
+  dev->stretch = buf[0] == 0x2C;
+
+  switch (command) {
+    case 0x2400:  // Single shot, high repeatability
+    case 0x2C06:
+      duration = 0.0125;
+      break;
+    case 0x240B:  // Medium repeatability
+    case 0x2C0D:
+      duration = 0.0045;
+      break;
+    case 0x2416:  // Low repeatability
+    case 0x2C10:
+      duration = 0.0025;
+      break;
+    case SHT3X_CMD_READ_STATUS_REG:
+      sht3x_respond(dev, 0x8010, 0, 0);
+      dev->out_len = 3;
+      return 0;
+    case SHT3X_CMD_READ_SERIAL_ID:
+      sht3x_respond(dev, 0x5348, 0x5400 + index, 0);
+      return 0;
+    case SHT3X_CMD_FETCH_DATA:
+      // Each periodic measurement is returned once; without a new one, the read is NACKed
+      if (dev->period == 0 || sim_now() < dev->next)
+        return 0;
+      while (dev->next <= sim_now())
+        dev->next += dev->period;
+      duration = 0;
+      break;
+    case SHT3X_CMD_ART:
+      return sht3x_start_periodic(dev, 0.25);
+    case SHT3X_CMD_BREAK:
+      dev->period = 0;
+      return 0;
+    default:
+      // Periodic acquisition: the command's MSB selects the rate
+      switch (buf[0]) {
+        case 0x20:
+          return sht3x_start_periodic(dev, 2);
+        case 0x21:
+          return sht3x_start_periodic(dev, 1);
+        case 0x22:
+          return sht3x_start_periodic(dev, 0.5);
+        case 0x23:
+          return sht3x_start_periodic(dev, 0.25);
+        case 0x27:
+          return sht3x_start_periodic(dev, 0.1);
+      }
+      return 0;
+  }
+
+  temperature = 24.5 + 0.3 * index + noise(&dev->seed, 10) / 100.0;
+  humidity = 45 + index + noise(&dev->seed, 10) / 100.0;
+  sht3x_respond(dev, (temperature + 45) / 175 * 65535, humidity / 100 * 65535, duration);
+
+  return 0;
+}
+
+static int sht3x_read(struct sim_device* dev, uint8_t* buf, uint16_t len) {
+  double now = sim_now();
+
+  if (!dev->out_len || len > dev->out_len)
+    return -1;
+
+  if (now < dev->ready) {
+    // Clock stretching commands hold the bus until the result is ready; the others NACK
+    if (!dev->stretch)
+      return -1;
+    nanosleep((const struct timespec[]){{0, (dev->ready - now) * 1e9}}, NULL);
+  }
+
+  memcpy(buf, dev->out, len);
+  dev->out_len = 0;
+  return 0;
+}
+
+void sim_devices_init() {
+  const char* list = getenv("SIMAR_SIM_DEVICES");
+  char* end;
+  long channel, ext_channel, addr;
+
+  if (list == NULL)
+    list = DEFAULT_DEVICES;
+
+  while (*list && device_count < SIM_MAX_DEVICES) {
+    channel = strtol(list, &end, 10);
+    ext_channel = SIM_NO_EXT;
+
+    if (*end == '.')
+      ext_channel = strtol(end + 1, &end, 10);
+    if (*end != ':')
+      break;
+
+    addr = strtol(end + 1, &end, 16);
+
+    if (addr == 0x76 || addr == 0x77 || addr == 0x44 || addr == 0x45) {
+      struct sim_device* dev = &devices[device_count];
+
+      dev->type = addr >= 0x76 ? SIM_BME280 : SIM_SHT3X;
+      dev->channel = channel;
+      dev->ext_channel = ext_channel;
+      dev->addr = addr;
+      dev->seed = 0x5EED + device_count;
+
+      if (dev->type == SIM_BME280)
+        bme280_reset(dev);
+
+      device_count++;
+    }
+
+    list = *end == ',' ? end + 1 : end;
+  }
+}
+
+struct sim_device* sim_device_find(uint8_t channel, int8_t ext_channel, uint8_t addr) {
+  for (uint8_t i = 0; i < device_count; i++) {
+    if (devices[i].channel == channel && devices[i].ext_channel == ext_channel &&
+        devices[i].addr == addr)
+      return &devices[i];
+  }
+
+  return NULL;
+}
+
+int sim_device_write(struct sim_device* dev, const uint8_t* buf, uint16_t len) {
+  return dev->type == SIM_BME280 ? bme280_write(dev, buf, len) : sht3x_write(dev, buf, len);
+}
+
+int sim_device_read(struct sim_device* dev, uint8_t* buf, uint16_t len) {
+  return dev->type == SIM_BME280 ? bme280_read(dev, buf, len) : sht3x_read(dev, buf, len);
+}
+
+/**
+ * @brief Analog value seen by an ADC channel
+ * @details Channel 0 is the rectified line voltage (about 127 V after the daemon's scaling, with
+ * some ripple), channels 1 through 7 are the outlet current transducers (2.5 V offset, 0.66 V/A).
+ * @param[in] channel ADC channel
+ * @returns Voltage at the input
+ */
+static double adc_input(uint8_t channel) {
+  double t = sim_now();
+  double phase = 2 * M_PI * LINE_FREQUENCY * t;
+
+  if (channel == 0)
+    return 1.846 + 0.010 * sin(2 * phase) + 0.003 * sin(6 * phase);
+
+  // Outlet n draws n * 0.4 A (RMS), plus some third harmonic
+  return 2.5 + 0.66 * channel * 0.4 * M_SQRT2 * (sin(phase - 0.3) + 0.1 * sin(3 * phase));
+}
+
+uint16_t sim_adc_frame(uint16_t word) {
+  static uint8_t channel;
+  static uint32_t seed = 0xADC;
+  double code = adc_input(channel) / ADC_VREF * 4096 + noise(&seed, 2);
+  uint16_t frame;
+
+  code = code < 0 ? 0 : code > 4095 ? 4095 : code;
+  frame = channel << 12 | (uint16_t)code;
+
+  if (word & ADC_WRITE)
+    channel = (word >> 10) & 0x07;
+
+  return frame;
+}
+
+static uint8_t pru_queue(struct sim_pru* pru,
+                         uint32_t glitch,
+                         uint32_t edges,
+                         uint32_t set,
+                         uint32_t clear) {
+  uint32_t words[4] = {glitch, edges, set, clear};
+  uint8_t* msg;
+
+  if (pru->count == SIM_PRU_QUEUE_LEN)
+    return 0;
+
+  msg = pru->queue[(pru->head + pru->count) % SIM_PRU_QUEUE_LEN];
+  for (uint8_t i = 0; i < 4; i++) {
+    msg[i * 4] = words[i];
+    msg[i * 4 + 1] = words[i] >> 8;
+    msg[i * 4 + 2] = words[i] >> 16;
+    msg[i * 4 + 3] = words[i] >> 24;
+  }
+  pru->count++;
+  return 1;
+}
+
+uint8_t sim_pru_kick(struct sim_pru* pru) {
+  double window;
+
+  if (!pru->counting) {
+    pru->counting = 1;
+    pru->window_start = sim_now();
+    return 0;
+  }
+
+  window = sim_now() - pru->window_start;
+  pru->counting = 0;
+
+  return pru_queue(pru, 0, LINE_FREQUENCY * window + 0.5, PRU_LOOP_HZ * window * PRU_DUTY,
+                   PRU_LOOP_HZ * window * (1 - PRU_DUTY)) +
+         pru_queue(pru, 0, 0, 0, 1);
+}
+
+static void pru_ring_push(struct pru_ring* ring, double t, uint8_t changed, uint8_t pins) {
+  volatile struct pru_ring_entry* entry = &ring->entries[ring->head & (PRU_RING_LEN - 1)];
+
+  entry->timestamp = (uint64_t)(t * PRU_IEP_HZ);
+  entry->changed = changed;
+  entry->pins = pins;
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  ring->head++;
+}
+
+void sim_pru_ring_update(struct sim_pru_ring* sim) {
+  const double period = 1 / LINE_FREQUENCY;
+  double now = sim_now(), start;
+
+  // Cycles start on the rising zero crossings of the simulated line voltage
+  if (sim->next_cycle == 0)
+    sim->next_cycle = ceil(now * LINE_FREQUENCY) / LINE_FREQUENCY;
+
+  // Whole cycles only, so that entries stay in time order
+  while (sim->next_cycle + period <= now) {
+    start = sim->next_cycle + noise(&sim->seed, PRU_JITTER_TICKS) / (double)PRU_IEP_HZ;
+
+    pru_ring_push(sim->ring, start, PRU_PIN_FREQUENCY | PRU_PIN_PFACTOR,
+                  PRU_PIN_FREQUENCY | PRU_PIN_PFACTOR);
+    pru_ring_push(sim->ring, sim->next_cycle + period / 2, PRU_PIN_FREQUENCY, PRU_PIN_PFACTOR);
+    pru_ring_push(sim->ring, sim->next_cycle + period * PRU_DUTY, PRU_PIN_PFACTOR, 0);
+
+    sim->next_cycle += period;
+  }
+}
+
+int sim_fan_value() {
+  static uint32_t seed = 0xFA;
+  double period = 60 / (FAN_RPM * FAN_PULSES);
+
+  if (fmod(sim_now(), period) < FAN_VALLEY_S)
+    return 100 + noise(&seed, 20);
+  return 900 + noise(&seed, 20);
+}
@@ -0,0 +1,134 @@
+/*! @file devices.h
+ * @brief Simulated device models (internal to the simulation backend)
+ */
+
+#ifndef SIM_DEVICES_H
+#define SIM_DEVICES_H
+
+#include <stdint.h>
+
+#include "../pru/ring.h"
+
+#define SIM_MAX_DEVICES 32
+#define SIM_PRU_QUEUE_LEN 8
+#define SIM_PRU_MSG_LEN 16
+
+/// No expansion board channel (device sits directly on a digital interface board channel)
+#define SIM_NO_EXT -1
+
+enum sim_device_type { SIM_BME280, SIM_SHT3X };
+
+/*!
+ * @brief Simulated I2C device
+ */
+struct sim_device {
+  enum sim_device_type type;
+  uint8_t channel;
+  int8_t ext_channel;
+  uint8_t addr;
+  uint32_t seed;
+
+  /// BME280 register file and register pointer
+  uint8_t regs[256];
+  uint8_t ptr;
+
+  /// SHT3x pending response and the time (in seconds) at which it becomes available
+  uint8_t out[6];
+  uint8_t out_len;
+  uint8_t stretch;
+  double ready;
+
+  /// SHT3x periodic acquisition: measurement period (0 in single shot mode) and next completion
+  double period;
+  double next;
+};
+
+/*!
+ * @brief Simulated PRU1 glitch/frequency counter firmware
+ */
+struct sim_pru {
+  uint8_t counting;
+  double window_start;
+  uint8_t queue[SIM_PRU_QUEUE_LEN][SIM_PRU_MSG_LEN];
+  uint8_t head;
+  uint8_t count;
+};
+
+/*!
+ * @brief Simulated PRU1 edge timestamp ring writer
+ */
+struct sim_pru_ring {
+  struct pru_ring* ring;
+  double next_cycle;  ///< Start of the next line cycle, in seconds
+  uint32_t seed;
+};
+
+/**
+ * @brief Monotonic time, in seconds
+ * @returns Current time
+ */
+double sim_now();
+
+/**
+ * @brief Creates the I2C devices listed in `SIMAR_SIM_DEVICES` (or the default layout)
+ */
+void sim_devices_init();
+
+/**
+ * @brief Finds the device reachable at the given multiplexer channels and address
+ * @param[in] channel Digital interface board channel
+ * @param[in] ext_channel Expansion board channel (SIM_NO_EXT if the extender is not selected)
+ * @param[in] addr I2C address
+ * @returns Device, or NULL if nothing answers at that address
+ */
+struct sim_device* sim_device_find(uint8_t channel, int8_t ext_channel, uint8_t addr);
+
+/**
+ * @brief Handles an I2C write to a device
+ * @retval 0 ACK
+ * @retval -1 NACK
+ */
+int sim_device_write(struct sim_device* dev, const uint8_t* buf, uint16_t len);
+
+/**
+ * @brief Handles an I2C read from a device
+ * @retval 0 ACK
+ * @retval -1 NACK (no data available)
+ */
+int sim_device_read(struct sim_device* dev, uint8_t* buf, uint16_t len);
+
+/**
+ * @brief Clocks one 16-bit frame through the AC board's 8-channel ADC
+ * @details Conversions are pipelined as in the real converter: the returned frame holds the
+ * conversion of the channel addressed by the previous control word.
+ * @param[in] word Control word
+ * @returns Conversion result frame (channel in bits 14-12, code in bits 11-0)
+ */
+uint16_t sim_adc_frame(uint16_t word);
+
+/**
+ * @brief Handles a kick from the ARM to the PRU counter firmware
+ * @details The first kick starts a measurement window; the next one closes it, queueing its
+ * counters followed by an empty message (the firmware reenters the counting routine once more
+ * with the kick still pending).
+ * @param[in] pru PRU state
+ * @returns Amount of messages queued
+ */
+uint8_t sim_pru_kick(struct sim_pru* pru);
+
+/**
+ * @brief Appends the input changes the PRU firmware would have seen up to now
+ * @details Every line cycle, the frequency and power factor inputs rise together (with some
+ * jitter), the frequency input falls halfway and the power factor input falls after its duty
+ * cycle.
+ * @param[in, out] sim Ring writer state
+ */
+void sim_pru_ring_update(struct sim_pru_ring* sim);
+
+/**
+ * @brief Fan tachometer analog input value
+ * @returns Raw ADC reading (0-4095)
+ */
+int sim_fan_value();
+
+#endif
@@ -5,13 +5,16 @@
 #include "common.h"
 
 #include <fcntl.h>
-#include <linux/spi/spidev.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "../sim/common.h"
+
 static uint32_t gpio_addresses[4] = {GPIO0_ADDR, GPIO1_ADDR, GPIO2_ADDR, GPIO3_ADDR};
 static volatile uint32_t* gpio_base[4] = {NULL};
 
@@ -19,6 +22,12 @@ int _bits, _speed, _delay, _mode, fd;
 int mod_bits = 8;
 int mod_mode = SPI_MODE_3;
 
+// Bus arbitration (see spi_bus_lock)
+static pthread_mutex_t bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bus_free = PTHREAD_COND_INITIALIZER;
+static uint8_t bus_busy;
+static atomic_uint bus_urgent;
+
 gpio_t cs_pin = {.pin = P9_17};
 gpio_t ds_pin = {.pin = P9_14};
 
@@ -32,10 +41,12 @@ void mmio_set_input(gpio_t gpio) {
 
 void mmio_set_high(gpio_t gpio) {
   gpio.base[MMIO_GPIO_SETDATAOUT / 4] = 1 << gpio.number;
+  hal_gpio_latch(gpio);
 }
 
 void mmio_set_low(gpio_t gpio) {
   gpio.base[MMIO_GPIO_CLEARDATAOUT / 4] = 1 << gpio.number;
+  hal_gpio_latch(gpio);
 }
 
 uint32_t mmio_input(gpio_t gpio) {
@@ -54,12 +65,12 @@ int mmio_get_gpio(gpio_t* gpio) {
   if (number < 0 || number > 31)
     return MMIO_ERROR_ARGUMENT;
   if (gpio_base[base] == NULL) {
-    int mfd = open("/dev/mem", O_RDWR | O_SYNC);
+    int mfd = hal_open("/dev/mem", O_RDWR | O_SYNC);
     if (mfd == -1)
       return MMIO_ERROR_DEVMEM;
 
-    gpio_base[base] = (uint32_t*)mmap(NULL, GPIO_LENGTH, PROT_READ | PROT_WRITE, MAP_SHARED, mfd,
-                                      gpio_addresses[base]);
+    gpio_base[base] = (uint32_t*)hal_mmap(NULL, GPIO_LENGTH, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                          mfd, gpio_addresses[base]);
     if (gpio_base[base] == MAP_FAILED) {
       gpio_base[base] = NULL;
       return MMIO_ERROR_MMAP;
@@ -73,16 +84,16 @@ int mmio_get_gpio(gpio_t* gpio) {
 }
 
 int spi_open(const char* device, uint32_t* mode, uint8_t* bits, uint32_t* speed) {
-  fd = open(device, O_RDWR);
+  fd = hal_open(device, O_RDWR);
 
-  ioctl(fd, SPI_IOC_WR_MODE, mode);
-  ioctl(fd, SPI_IOC_RD_MODE, mode);
+  hal_ioctl(fd, SPI_IOC_WR_MODE, mode);
+  hal_ioctl(fd, SPI_IOC_RD_MODE, mode);
 
-  ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, bits);
-  ioctl(fd, SPI_IOC_RD_BITS_PER_WORD, bits);
+  hal_ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, bits);
+  hal_ioctl(fd, SPI_IOC_RD_BITS_PER_WORD, bits);
 
-  ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, speed);
-  ioctl(fd, SPI_IOC_RD_MAX_SPEED_HZ, speed);
+  hal_ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, speed);
+  hal_ioctl(fd, SPI_IOC_RD_MAX_SPEED_HZ, speed);
 
   _bits = *bits;
   _speed = *speed;
@@ -98,23 +109,151 @@ int spi_open(const char* device, uint32_t* mode, uint8_t* bits, uint32_t* speed)
 }
 
 int spi_close() {
-  return close(fd);
+  return hal_close(fd);
 }
 
-int spi_transfer(const char* tx, const char* rx, int len) {
-  int ret;
+/**
+ * @brief Switches the device to an SPI mode
+ * @details The mode is the only setting that sticks to the device: word size, speed and delay are
+ * carried by every transfer. It is set again for every group of transfers, as other processes
+ * (leak, bme) open the same device and change it.
+ * @param[in] mode SPI mode
+ * @retval 0 Success
+ * @retval -1 Failure
+ */
+static int set_mode(int mode) {
+  uint8_t value = mode;
+
+  return hal_ioctl(fd, SPI_IOC_WR_MODE, &value) < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Submits a single transfer
+ * @param[in] tx TX buffer (NULL to shift out zeros)
+ * @param[out] rx RX buffer (NULL to discard)
+ * @param[in] len Buffer length
+ * @param[in] bits Bits per word
+ * @param[in] delay Delay after the transfer (in microseconds)
+ * @retval 0 Success
+ * @retval -1 Failure
+ */
+static int transfer(const char* tx, const char* rx, int len, int bits, int delay) {
   struct spi_ioc_transfer tr = {
+      .tx_buf = (unsigned long)tx,
+      .rx_buf = (unsigned long)rx,
+      .len = len,
+      .delay_usecs = delay,
+      .speed_hz = _speed,
+      .bits_per_word = bits,
+  };
+
+  return hal_ioctl(fd, SPI_IOC_MESSAGE(1), &tr) < 0 ? -1 : 0;
+}
+
+int spi_transfer(const char* tx, const char* rx, int len) {
+  if (set_mode(_mode))
+    return -1;
+
+  return transfer(tx, rx, len, _bits, _delay);
+}
+
+void spi_batch_init(struct spi_batch* batch) {
+  batch->count = 0;
+}
+
+int spi_batch_add(struct spi_batch* batch, const char* tx, char* rx, int len) {
+  if (batch->count == SPI_BATCH_MAX)
+    return -1;
+
+  batch->transfers[batch->count++] = (struct spi_ioc_transfer){
       .tx_buf = (unsigned long)tx,
       .rx_buf = (unsigned long)rx,
       .len = len,
       .delay_usecs = _delay,
       .speed_hz = _speed,
       .bits_per_word = _bits,
+      .cs_change = 1,
   };
+  return 0;
+}
+
+int spi_batch_submit(struct spi_batch* batch) {
+  if (batch->count == 0)
+    return 0;
+
+  if (set_mode(_mode))
+    return -1;
+
+  // On the last transfer, cs_change would keep CS asserted after the message instead
+  batch->transfers[batch->count - 1].cs_change = 0;
 
-  ret = ioctl(fd, SPI_IOC_MESSAGE(len), &tr);
+  return hal_ioctl(fd, SPI_IOC_MESSAGE(batch->count), batch->transfers) < 0 ? -1 : 0;
+}
+
+int adc_scan(const uint8_t* channels, uint8_t count, struct adc_sample* samples) {
+  return adc_scan_part(channels, count, 0, 1, samples);
+}
+
+int adc_scan_part(const uint8_t* channels,
+                  uint8_t count,
+                  uint8_t carried,
+                  uint8_t flush,
+                  struct adc_sample* samples) {
+  uint16_t tx[SPI_BATCH_MAX] = {0}, rx[SPI_BATCH_MAX];
+  uint8_t frames = count + (flush ? 1 : 0);
+  struct spi_batch batch;
+
+  if (count >= SPI_BATCH_MAX)
+    return -1;
+
+  // Frame i programs channel i and returns the conversion programmed by the frame before it
+  spi_batch_init(&batch);
+  for (uint8_t i = 0; i < frames; i++) {
+    if (i < count)
+      tx[i] = ADC_CMD(channels[i] & 0x07);
+    spi_batch_add(&batch, (char*)&tx[i], (char*)&rx[i], sizeof(uint16_t));
+  }
 
-  return ret < 0 ? -1 : 0;
+  if (spi_batch_submit(&batch))
+    return -1;
+
+  for (int16_t i = carried ? -1 : 0; i + 1 < frames; i++) {
+    uint16_t frame = rx[i + 1];
+
+    samples[i].channel = (frame >> 12) & 0x07;
+    samples[i].code = frame & 0x0FFF;
+    samples[i].valid = frame != 0xFFFF && samples[i].channel == (channels[i] & 0x07);
+  }
+
+  return 0;
+}
+
+void spi_bus_lock(enum spi_priority priority) {
+  pthread_mutex_lock(&bus_mutex);
+
+  if (priority == SPI_URGENT)
+    atomic_fetch_add(&bus_urgent, 1);
+
+  // Background users also let urgent ones that are already waiting go first
+  while (bus_busy || (priority == SPI_BACKGROUND && atomic_load(&bus_urgent) > 0))
+    pthread_cond_wait(&bus_free, &bus_mutex);
+
+  if (priority == SPI_URGENT)
+    atomic_fetch_sub(&bus_urgent, 1);
+
+  bus_busy = 1;
+  pthread_mutex_unlock(&bus_mutex);
+}
+
+void spi_bus_unlock() {
+  pthread_mutex_lock(&bus_mutex);
+  bus_busy = 0;
+  pthread_cond_broadcast(&bus_free);
+  pthread_mutex_unlock(&bus_mutex);
+}
+
+uint8_t spi_bus_contended() {
+  return atomic_load_explicit(&bus_urgent, memory_order_relaxed) > 0;
 }
 
 /**
@@ -132,38 +271,32 @@ int calculate_parity(int x) {
   return y & 1;
 }
 
-int spi_mod_comm(char* tx, char* rx, int len) {
+/**
+ * @brief Transfers to the module selector, with the device already in the module mode
+ * @param[in] tx TX buffer
+ * @param[out] rx RX buffer
+ * @param[in] len Buffer length
+ * @retval 0 Success
+ * @retval -1 Failure
+ */
+static int mod_transfer(char* tx, char* rx, int len) {
   int ret;
 
-  if (_mode != SPI_MODE_3)
-    ioctl(fd, SPI_IOC_WR_MODE, &mod_mode);
-  if (_bits != 8)
-    ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &mod_bits);
-
-  // Reusing device file descriptor, but creating custom struct to prevent
-  // confusion
-  struct spi_ioc_transfer tr = {
-      .tx_buf = (unsigned long)tx,
-      .rx_buf = (unsigned long)rx,
-      .len = len,
-      .delay_usecs = 0,
-      .speed_hz = _speed,
-      .bits_per_word = mod_bits,
-  };
-
   mmio_set_low(ds_pin);
-  ret = ioctl(fd, SPI_IOC_MESSAGE(1), &tr);
+  ret = transfer(tx, rx, len, mod_bits, 0);
   mmio_set_high(ds_pin);
 
-  if (_mode != SPI_MODE_3)
-    ioctl(fd, SPI_IOC_WR_MODE, &_mode);
-  if (_bits != 8)
-    ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &_bits);
-
-  return ret < 0 ? -1 : 0;
+  return ret;
 }
 
-int select_module(int address, int module) {
+/**
+ * @brief Selects a module, with the device already in the module mode
+ * @param[in] address Address
+ * @param[in] module Module value
+ * @retval 0 Success
+ * @retval -1 Failure
+ */
+static int mod_select(int address, int module) {
   unsigned long msg;
   int parity = calculate_parity(address);
 
@@ -172,7 +305,21 @@ int select_module(int address, int module) {
 
   char msg_c[1] = {msg};
 
-  return spi_mod_comm(msg_c, msg_c, 1);
+  return mod_transfer(msg_c, msg_c, 1);
+}
+
+int spi_mod_comm(char* tx, char* rx, int len) {
+  if (set_mode(mod_mode))
+    return -1;
+
+  return mod_transfer(tx, rx, len);
+}
+
+int select_module(int address, int module) {
+  if (set_mode(mod_mode))
+    return -1;
+
+  return mod_select(address, module);
 }
 
 int transfer_module(char* data, int len) {
@@ -182,48 +329,31 @@ int transfer_module(char* data, int len) {
 int write_data(int address, char* data, int len) {
   int ret;
 
-  select_module(address, 1);
+  if (set_mode(mod_mode))
+    return -1;
 
-  if (_mode != SPI_MODE_3)
-    ioctl(fd, SPI_IOC_WR_MODE, &mod_mode);
-  if (_bits != 8)
-    ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &mod_bits);
+  mod_select(address, 1);
 
   mmio_set_high(cs_pin);
   mmio_set_low(cs_pin);
 
   mmio_set_high(cs_pin);
-  ret = write(fd, data, len);
+  ret = transfer(data, NULL, len, mod_bits, 0);
   mmio_set_low(cs_pin);
 
-  if (_mode != SPI_MODE_3)
-    ioctl(fd, SPI_IOC_WR_MODE, &_mode);
-  if (_bits != 8)
-    ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &_bits);
-
-  return ret;
+  return ret < 0 ? -1 : len;
 }
 
 int read_data(int address, char* rx, int len) {
-  int ret;
   char dummy_data[1] = "";
 
-  select_module(address, 2);
-  spi_transfer(dummy_data, dummy_data, 1);
-  select_module(address, 3);
-  spi_transfer(dummy_data, dummy_data, 1);
-
-  if (_mode != SPI_MODE_3)
-    ioctl(fd, SPI_IOC_WR_MODE, &mod_mode);
-  if (_bits != 8)
-    ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &mod_bits);
+  if (set_mode(mod_mode))
+    return -1;
 
-  ret = read(fd, rx, len);
+  mod_select(address, 2);
+  transfer(dummy_data, dummy_data, 1, mod_bits, 0);
+  mod_select(address, 3);
+  transfer(dummy_data, dummy_data, 1, mod_bits, 0);
 
-  if (_mode != SPI_MODE_3)
-    ioctl(fd, SPI_IOC_WR_MODE, &_mode);
-  if (_bits != 8)
-    ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &_bits);
-
-  return ret;
+  return transfer(NULL, rx, len, mod_bits, 0) < 0 ? -1 : len;
 }
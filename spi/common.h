@@ -10,6 +10,7 @@
 #ifndef SPIUTIL_H
 #define SPIUTIL_H
 
+#include <linux/spi/spidev.h>
 #include <stdint.h>
 
 #define GPIO_LENGTH 4096
@@ -29,6 +30,13 @@
 #define MMIO_GPIO_CLEARDATAOUT 0x190
 #define MMIO_GPIO_SETDATAOUT 0x194
 
+/// Maximum amount of transfers in a batch
+#define SPI_BATCH_MAX 64
+
+#define ADC_CHANNELS 8
+/// ADC control word (write, normal power, straight binary), with the channel in bits 12:10
+#define ADC_CMD(channel) (0x8310 | ((channel) << 10))
+
 #define SENSOR_FAIL -2
 #define DB_FAIL -3
 #define BUS_FAIL -9
@@ -149,8 +157,12 @@ int spi_close();
 /**
  * \ingroup spiComm
  * @brief Transfers buffer through SPI with determined length
- * @param[in] tx TX buffer
- * @param[out] rx RX buffer
+ * @details Uses the mode and word size given to spi_open(). The mode is set on the device before
+ * every transfer (or batch, or module exchange), since it is shared with other processes, which
+ * may have changed it. The bus must only be accessed through these methods, as plain read()/write()
+ * calls on its descriptor would use whatever mode was set last.
+ * @param[in] tx TX buffer (NULL to shift out zeros)
+ * @param[out] rx RX buffer (NULL to discard received data)
  * @param[in] len Buffer length
  * @returns SPI transfer operation result
  * @retval 0 Success
@@ -158,6 +170,123 @@ int spi_close();
  */
 int spi_transfer(const char* tx, const char* rx, int len);
 
+/*!
+ * @brief Batch of SPI transfers, submitted as a single message (CS is toggled between transfers)
+ */
+struct spi_batch {
+  struct spi_ioc_transfer transfers[SPI_BATCH_MAX];
+  uint8_t count;
+};
+
+/// Bus users, by priority
+enum spi_priority {
+  SPI_BACKGROUND,  ///< Long-running users (ADC scans), which yield the bus between chunks
+  SPI_URGENT,      ///< Short, latency-sensitive users (actuation), served before background ones
+};
+
+/*!
+ * @brief Decoded ADC conversion result
+ */
+struct adc_sample {
+  uint8_t channel;  ///< Channel the conversion was made on, as reported by the ADC
+  uint16_t code;    ///< 12-bit conversion result
+  uint8_t valid;    ///< Whether the frame was returned for the requested channel
+};
+
+/**
+ * \ingroup spiComm
+ * @brief Starts an empty transfer batch
+ * @param[out] batch Batch
+ */
+void spi_batch_init(struct spi_batch* batch);
+
+/**
+ * \ingroup spiComm
+ * @brief Queues a transfer, using the mode, word size and speed given to spi_open()
+ * @param[in, out] batch Batch
+ * @param[in] tx TX buffer (NULL to shift out zeros); must stay valid until the batch is submitted
+ * @param[out] rx RX buffer (NULL to discard received data)
+ * @param[in] len Buffer length
+ * @retval 0 Queued
+ * @retval -1 Batch is full
+ */
+int spi_batch_add(struct spi_batch* batch, const char* tx, char* rx, int len);
+
+/**
+ * \ingroup spiComm
+ * @brief Submits every queued transfer in one SPI_IOC_MESSAGE ioctl, releasing CS between them
+ * @param[in, out] batch Batch
+ * @retval 0 Success
+ * @retval -1 Failure
+ */
+int spi_batch_submit(struct spi_batch* batch);
+
+/**
+ * \ingroup spiComm
+ * @brief Converts a list of ADC channels in a single batch
+ * @details The ADC returns each conversion one frame after its channel is programmed, so the scan
+ * takes one frame more than the amount of channels, all in one ioctl. The ADC module must already
+ * be selected.
+ * @param[in] channels Channels to convert, in order (0 to 7)
+ * @param[in] count Amount of channels (up to SPI_BATCH_MAX - 1)
+ * @param[out] samples Decoded conversions, in the same order as `channels`
+ * @retval 0 Success
+ * @retval -1 Failure
+ */
+int adc_scan(const uint8_t* channels, uint8_t count, struct adc_sample* samples);
+
+/**
+ * \ingroup spiComm
+ * @brief Converts part of a list of ADC channels, carrying the conversion pipeline across parts
+ * @details Frame i programs `channels[i]` and returns the conversion programmed by the frame before
+ * it: the first frame returns the previous part's last channel (`channels[-1]`, stored in
+ * `samples[-1]`) when `carried` is set, and `flush` adds a final frame returning this part's last
+ * channel. A scan split into parts costs no more frames than adc_scan(), as long as nothing else
+ * clocks the ADC between them. The ADC module must already be selected.
+ * @param[in] channels Channels to convert, in order (0 to 7)
+ * @param[in] count Amount of channels (may be 0, to only flush a carried conversion)
+ * @param[in] carried Whether the previous part's last conversion is still in the ADC
+ * @param[in] flush Whether to read this part's last conversion out of the ADC
+ * @param[out] samples Decoded conversions, in the same order as `channels`
+ * @retval 0 Success
+ * @retval -1 Failure
+ */
+int adc_scan_part(const uint8_t* channels,
+                  uint8_t count,
+                  uint8_t carried,
+                  uint8_t flush,
+                  struct adc_sample* samples);
+
+/**
+ * \ingroup spi
+ * \defgroup spiBus Bus scheduling
+ * @brief Arbitration of the SPI bus between threads
+ * @details Urgent users are served as soon as the bus is released, ahead of any background user
+ * already waiting. Background users working in chunks check spi_bus_contended() between them, and
+ * release the bus when an urgent user waits, which bounds its latency to a single chunk.
+ */
+
+/**
+ * \ingroup spiBus
+ * @brief Waits for the bus and takes it
+ * @param[in] priority Priority of the caller
+ */
+void spi_bus_lock(enum spi_priority priority);
+
+/**
+ * \ingroup spiBus
+ * @brief Releases the bus, waking up waiting users
+ */
+void spi_bus_unlock();
+
+/**
+ * \ingroup spiBus
+ * @brief Checks whether urgent users wait for the bus (lock-free)
+ * @retval 1 An urgent user waits
+ * @retval 0 No urgent user waits
+ */
+uint8_t spi_bus_contended();
+
 void mmio_set_output(gpio_t gpio);
 void mmio_set_input(gpio_t gpio);
 void mmio_set_high(gpio_t gpio);
@@ -207,6 +336,7 @@ int write_data(int address, char* data, int len);
 /**
  * \ingroup spiModule
  * @brief Reads digital data at given address
+ * @details The whole exchange, dummy frames included, is clocked in the module mode (mode 3).
  * @param[in] address address
  * @param[out] rx Buffer to write data to
  * @returns SPI transfer operation result
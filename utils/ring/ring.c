@@ -0,0 +1,51 @@
+/*! @file ring.c
+ * @brief Single-producer, single-consumer lock-free ring buffer
+ */
+
+#include "ring.h"
+
+#include <string.h>
+
+int ring_init(struct ring* r, void* storage, uint32_t capacity, uint32_t elem_size) {
+  if (capacity == 0 || (capacity & (capacity - 1)))
+    return -1;
+
+  r->data = storage;
+  r->mask = capacity - 1;
+  r->elem_size = elem_size;
+  atomic_init(&r->head, 0);
+  atomic_init(&r->tail, 0);
+
+  return 0;
+}
+
+int ring_push(struct ring* r, const void* elem) {
+  unsigned int head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+  // Acquire pairs with the consumer's release, so its slot is no longer being read
+  if (head - atomic_load_explicit(&r->tail, memory_order_acquire) > r->mask)
+    return -1;
+
+  memcpy(r->data + (head & r->mask) * r->elem_size, elem, r->elem_size);
+  atomic_store_explicit(&r->head, head + 1, memory_order_release);
+
+  return 0;
+}
+
+int ring_pop(struct ring* r, void* elem) {
+  unsigned int tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+  // Acquire pairs with the producer's release, so the element is fully written
+  if (tail == atomic_load_explicit(&r->head, memory_order_acquire))
+    return -1;
+
+  memcpy(elem, r->data + (tail & r->mask) * r->elem_size, r->elem_size);
+  atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+
+  return 0;
+}
+
+uint32_t ring_count(struct ring* r) {
+  return atomic_load_explicit(&r->head, memory_order_acquire) -
+         atomic_load_explicit(&r->tail, memory_order_acquire);
+}
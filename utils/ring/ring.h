@@ -0,0 +1,71 @@
+/*! @file ring.h
+ * @brief Single-producer, single-consumer lock-free ring buffer
+ */
+
+/*!
+ * @defgroup ring Ring buffer
+ * @brief Lock-free FIFO of fixed-size elements, between one producer and one consumer thread
+ *
+ * @details The producer only writes `head` and the consumer only writes `tail`, so neither side
+ * ever blocks or takes a lock. Both indexes run freely and are masked on access, which requires a
+ * power-of-two capacity.
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*!
+ * @brief Ring buffer state (indexes kept on separate cache lines)
+ */
+struct ring {
+  uint8_t* data;
+  uint32_t mask;
+  uint32_t elem_size;
+  _Alignas(64) atomic_uint head;  ///< Next slot to be written (producer)
+  _Alignas(64) atomic_uint tail;  ///< Next slot to be read (consumer)
+};
+
+/**
+ * \ingroup ring
+ * @brief Initializes an empty ring over caller-provided storage
+ * @param[out] r Ring
+ * @param[in] storage Storage for `capacity * elem_size` bytes
+ * @param[in] capacity Amount of elements (power of two)
+ * @param[in] elem_size Element size, in bytes
+ * @retval 0 OK
+ * @retval -1 Capacity is not a power of two
+ */
+int ring_init(struct ring* r, void* storage, uint32_t capacity, uint32_t elem_size);
+
+/**
+ * \ingroup ring
+ * @brief Appends an element (producer side)
+ * @param[in, out] r Ring
+ * @param[in] elem Element to copy in
+ * @retval 0 OK
+ * @retval -1 Ring is full
+ */
+int ring_push(struct ring* r, const void* elem);
+
+/**
+ * \ingroup ring
+ * @brief Removes the oldest element (consumer side)
+ * @param[in, out] r Ring
+ * @param[out] elem Element copied out
+ * @retval 0 OK
+ * @retval -1 Ring is empty
+ */
+int ring_pop(struct ring* r, void* elem);
+
+/**
+ * \ingroup ring
+ * @brief Amount of elements currently queued (a snapshot, from either side)
+ * @param[in] r Ring
+ * @returns Amount of elements
+ */
+uint32_t ring_count(struct ring* r);
+
+#endif
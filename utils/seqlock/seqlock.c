@@ -0,0 +1,39 @@
+/*! @file seqlock.c
+ * @brief Single-writer sequence lock, for sharing snapshots between threads
+ */
+
+#include "seqlock.h"
+
+#include <string.h>
+
+void seqlock_init(struct seqlock* s, void* storage, uint32_t size) {
+  s->data = storage;
+  s->size = size;
+  atomic_init(&s->seq, 0);
+}
+
+void seqlock_write(struct seqlock* s, const void* value) {
+  unsigned int seq = atomic_load_explicit(&s->seq, memory_order_relaxed);
+
+  // The fence keeps the value's stores from moving above the odd sequence number
+  atomic_store_explicit(&s->seq, seq + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  memcpy(s->data, value, s->size);
+  atomic_store_explicit(&s->seq, seq + 2, memory_order_release);
+}
+
+uint32_t seqlock_read(struct seqlock* s, void* value) {
+  unsigned int before, after;
+
+  do {
+    before = atomic_load_explicit(&s->seq, memory_order_acquire);
+    memcpy(value, s->data, s->size);
+
+    // The fence keeps the value's loads from moving below the second sequence number check
+    atomic_thread_fence(memory_order_acquire);
+    after = atomic_load_explicit(&s->seq, memory_order_relaxed);
+  } while ((before & 1) || before != after);
+
+  return before / 2;
+}
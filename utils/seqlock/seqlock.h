@@ -0,0 +1,55 @@
+/*! @file seqlock.h
+ * @brief Single-writer sequence lock, for sharing snapshots between threads
+ */
+
+/*!
+ * @defgroup seqlock Sequence lock
+ * @brief Consistent snapshots of a value written by one thread and read by any number of others
+ *
+ * @details The writer bumps the sequence number to odd before updating the value and back to even
+ * afterwards; readers copy the value out and retry if the sequence was odd or changed meanwhile.
+ * Neither side ever blocks, and the writer is never held back by readers.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*!
+ * @brief Sequence lock state
+ */
+struct seqlock {
+  atomic_uint seq;  ///< Twice the amount of completed writes (odd while one is in progress)
+  void* data;
+  uint32_t size;
+};
+
+/**
+ * \ingroup seqlock
+ * @brief Initializes a sequence lock over caller-provided storage, which holds the initial value
+ * @param[out] s Sequence lock
+ * @param[in] storage Value storage
+ * @param[in] size Value size, in bytes
+ */
+void seqlock_init(struct seqlock* s, void* storage, uint32_t size);
+
+/**
+ * \ingroup seqlock
+ * @brief Replaces the value (writer side, a single thread only)
+ * @param[in, out] s Sequence lock
+ * @param[in] value New value
+ */
+void seqlock_write(struct seqlock* s, const void* value);
+
+/**
+ * \ingroup seqlock
+ * @brief Copies out a consistent snapshot of the value (any thread)
+ * @param[in] s Sequence lock
+ * @param[out] value Snapshot
+ * @returns Amount of writes the snapshot includes (0 if it is still the initial value)
+ */
+uint32_t seqlock_read(struct seqlock* s, void* value);
+
+#endif